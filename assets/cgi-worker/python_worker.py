@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Long-lived worker running Python CGI scripts for webserv's `cgi_pool` directive.
+
+The server talks to the worker over its stdin and stdout (one end of a socket pair), one request at a time:
+    request:  u32 length, environment ("NAME=VALUE\\0" each), u32 length, body
+    response: u32 exit status, u32 length, the script's stdout
+(lengths and statuses big-endian). Each script runs in this process as `__main__`, with the request's environment, its
+body as stdin and its own directory as working directory, as if it had been started as a CGI subprocess. The script's
+stderr goes to the server's stderr.
+The socket is moved to private, non-inheritable descriptors at startup. Descriptors 0 and 1 are the request body and a
+temporary file while a script runs (and /dev/null in between), so what the script writes with `os.write(1, ...)` or
+`sys.__stdout__`, and what the programs it starts write, ends up in its output instead of corrupting the framing.
+"""
+
+import io
+import os
+import runpy
+import struct
+import sys
+import tempfile
+import traceback
+
+channel_fd = os.dup(0)  # Not inherited by the programs scripts start (os.dup() is non-inheritable)
+channel_in = os.fdopen(channel_fd, "rb", buffering=0)
+channel_out = os.fdopen(os.dup(channel_fd), "wb", buffering=0)
+null_fd = os.open(os.devnull, os.O_RDWR)
+os.dup2(null_fd, 0)
+os.dup2(null_fd, 1)
+base_environ = dict(os.environ)
+base_cwd = os.getcwd()
+
+
+def read_exactly(size):
+    data = bytearray()
+    while len(data) < size:
+        chunk = channel_in.read(size - len(data))
+        if not chunk:
+            sys.exit(0)  # The server closed the socket: no more requests
+        data += chunk
+    return bytes(data)
+
+
+def read_frame():
+    (length,) = struct.unpack("!I", read_exactly(4))
+    return read_exactly(length)
+
+
+def run_script(environment, body):
+    os.environ.clear()
+    os.environ.update(base_environ)
+    os.environ.update(environment)
+    script = environment.get("SCRIPT_FILENAME", "")
+    # Files rather than pipes: nothing has to be read while the script runs
+    body_file = tempfile.TemporaryFile()
+    body_file.write(body)
+    body_file.seek(0)
+    output = tempfile.TemporaryFile()
+    os.dup2(body_file.fileno(), 0)
+    os.dup2(output.fileno(), 1)
+    saved = sys.stdin, sys.stdout, sys.argv
+    sys.stdin = io.TextIOWrapper(io.BytesIO(body), encoding="utf-8", errors="replace")
+    # Unbuffered, so what's printed and what's written to fd 1 directly stay in order
+    script_stdout = io.TextIOWrapper(io.FileIO(os.dup(1), "wb"), encoding="utf-8", write_through=True)
+    sys.stdout = script_stdout
+    sys.argv = [script]
+    status = 0
+    try:
+        os.chdir(os.path.dirname(script) or base_cwd)
+        runpy.run_path(script, run_name="__main__")
+    except SystemExit as exit_request:
+        if exit_request.code is None:
+            status = 0
+        elif isinstance(exit_request.code, int):
+            status = exit_request.code
+        else:
+            print(exit_request.code, file=sys.stderr)
+            status = 1
+    except BaseException:
+        traceback.print_exc()
+        status = 1
+    finally:
+        script_stdout.close()
+        if sys.__stdout__ is not None:
+            sys.__stdout__.flush()
+        sys.stdin, sys.stdout, sys.argv = saved
+        os.dup2(null_fd, 0)
+        os.dup2(null_fd, 1)
+        os.chdir(base_cwd)
+    output.seek(0)
+    result = output.read()
+    output.close()
+    body_file.close()
+    return status & 0xFFFFFFFF, result
+
+
+def main():
+    while True:
+        environment = {}
+        for pair in read_frame().split(b"\0"):
+            if pair:
+                name, _, value = pair.decode("utf-8", "surrogateescape").partition("=")
+                environment[name] = value
+        body = read_frame()
+        status, output = run_script(environment, body)
+        channel_out.write(struct.pack("!II", status, len(output)) + output)
+
+
+if __name__ == "__main__":
+    main()
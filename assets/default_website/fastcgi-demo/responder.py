@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""A minimal FastCGI responder to try `fastcgi_pass` with (standard library only).
+
+Usage: responder.py unix:/tmp/webserv-fastcgi.sock
+       responder.py 127.0.0.1:9000
+
+It answers every request with a page listing the parameters it received, the request body and how many requests
+were already served over the same connection (connections are kept open when the server asks for it).
+"""
+
+import os
+import socket
+import struct
+import sys
+import threading
+
+BEGIN_REQUEST, ABORT_REQUEST, END_REQUEST, PARAMS, STDIN, STDOUT, STDERR = 1, 2, 3, 4, 5, 6, 7
+FLAG_KEEP_CONN = 1
+REQUEST_COMPLETE, UNKNOWN_ROLE = 0, 3
+RESPONDER = 1
+
+
+def read_exactly(conn, size):
+    data = b""
+    while len(data) < size:
+        chunk = conn.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError("connection closed")
+        data += chunk
+    return data
+
+
+def read_record(conn):
+    version, record_type, request_id, content_length, padding_length, _ = struct.unpack(
+        "!BBHHBB", read_exactly(conn, 8))
+    content = read_exactly(conn, content_length)
+    read_exactly(conn, padding_length)
+    return record_type, request_id, content
+
+
+def record(record_type, request_id, content=b""):
+    padding = -len(content) % 8
+    return struct.pack("!BBHHBB", 1, record_type, request_id, len(content), padding, 0) + content + b"\0" * padding
+
+
+def stream(record_type, request_id, data):
+    out = b"".join(record(record_type, request_id, data[i:i + 65535]) for i in range(0, len(data), 65535))
+    return out + record(record_type, request_id)
+
+
+def parse_pairs(data):
+    params, pos = {}, 0
+    while pos < len(data):
+        lengths = []
+        for _ in range(2):
+            if data[pos] >> 7:
+                lengths.append(struct.unpack("!I", data[pos:pos + 4])[0] & 0x7FFFFFFF)
+                pos += 4
+            else:
+                lengths.append(data[pos])
+                pos += 1
+        name = data[pos:pos + lengths[0]].decode("latin-1")
+        pos += lengths[0]
+        params[name] = data[pos:pos + lengths[1]].decode("latin-1")
+        pos += lengths[1]
+    return params
+
+
+def respond(params, body, served):
+    page = "<html><head><title>FastCGI Test</title></head><body><h1>Hello from a FastCGI responder!</h1>"
+    page += f"<p>Process {os.getpid()}, request {served + 1} on this connection.</p><h2>Parameters</h2><ul>"
+    for name, value in sorted(params.items()):
+        page += f"<li><b>{name}:</b> {value}</li>"
+    page += "</ul>"
+    if params.get("REQUEST_METHOD") == "POST":
+        page += "<h2>POST Data</h2><pre>" + body.decode("utf-8", "replace") + "</pre>"
+    page += "</body></html>"
+    data = page.encode()
+    return b"Content-Type: text/html\r\nContent-Length: %d\r\n\r\n" % len(data) + data
+
+
+def serve_connection(conn):
+    served = 0
+    with conn:
+        while True:
+            try:
+                record_type, request_id, content = read_record(conn)
+            except ConnectionError:
+                return
+            if record_type != BEGIN_REQUEST:
+                continue
+            role, flags = struct.unpack("!HB5x", content)
+            params_data, body = b"", b""
+            while True:
+                record_type, _, content = read_record(conn)
+                if record_type == PARAMS:
+                    params_data += content
+                elif record_type == STDIN:
+                    if not content:
+                        break
+                    body += content
+            if role != RESPONDER:
+                conn.sendall(record(END_REQUEST, request_id, struct.pack("!IB3x", 0, UNKNOWN_ROLE)))
+            else:
+                output = respond(parse_pairs(params_data), body, served)
+                conn.sendall(stream(STDOUT, request_id, output) +
+                             record(END_REQUEST, request_id, struct.pack("!IB3x", 0, REQUEST_COMPLETE)))
+            served += 1
+            if not flags & FLAG_KEEP_CONN:
+                return
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(f"usage: {sys.argv[0]} unix:/path/to/socket | host:port")
+    address = sys.argv[1]
+    if address.startswith("unix:"):
+        path = address[5:]
+        if os.path.exists(path):
+            os.unlink(path)
+        listener = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        listener.bind(path)
+    else:
+        host, port = address.rsplit(":", 1)
+        listener = socket.socket(socket.AF_INET6 if ":" in host else socket.AF_INET, socket.SOCK_STREAM)
+        listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        listener.bind((host.strip("[]"), int(port)))
+    listener.listen(64)
+    print(f"FastCGI responder listening on {address}")
+    while True:
+        conn, _ = listener.accept()
+        threading.Thread(target=serve_connection, args=(conn,), daemon=True).start()
+
+
+if __name__ == "__main__":
+    main()
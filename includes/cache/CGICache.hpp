@@ -0,0 +1,126 @@
+#pragma once
+
+#include "HTTPRequestData.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#define CGI_CACHE_DEFAULT_SIZE 8000000       // bytes
+#define CGI_CACHE_DEFAULT_MAX_OBJECT 1000000 // bytes
+
+/* Memory-budgeted LRU cache of the output of CGI scripts (and FastCGI responders) for locations with `cgi_cache`, keyed
+by server, method, request path and query, and the values of the location's key headers. A fresh entry is served
+without running anything. Once it's expired, it's still served for the `stale` time while a single refresh runs in the
+background (stale-while-revalidate); the first response of the refresh replaces it.
+How long an entry is fresh is the location's `valid` time, unless the script's `Cache-Control` says otherwise:
+`no-store`, `no-cache` and `private` responses (and those that set cookies, or whose `Vary` names a field that isn't a
+key header) aren't stored, `s-maxage`/`max-age` replace
+`valid`, and `stale-while-revalidate` replaces `stale`. */
+class CGICache
+{
+public:
+    using Headers = std::unordered_map<std::string, std::string>;
+
+    // `cgi_cache` directive of a location
+    struct Settings
+    {
+        long                     valid{0}; // Seconds an entry is fresh (0 disables caching for the location)
+        long                     stale{0}; // Seconds an expired entry is served while it's refreshed
+        std::vector<std::string> keyHeaders{}; // Request header fields (lowercase) whose values are part of the key
+
+        [[nodiscard]] bool isEnabled() const;
+    };
+
+    struct Entry
+    {
+        Headers     headers; // The script's header fields (`Status` included, `Content-Length` left out)
+        std::string body;
+
+        std::chrono::steady_clock::time_point storedAt{};
+        std::chrono::steady_clock::time_point freshUntil{};
+        std::chrono::steady_clock::time_point staleUntil{};
+
+        // Seconds since the entry was stored (the `Age` of a response served from it)
+        [[nodiscard]] long getAge() const;
+    };
+    using EntryPtr = std::shared_ptr<const Entry>;
+
+    enum Freshness
+    {
+        MISS,
+        FRESH,
+        STALE // Expired, but served while it's refreshed
+    };
+
+    // Seconds a response is fresh, then served stale
+    struct Lifetime
+    {
+        long fresh{0};
+        long stale{0};
+    };
+
+    struct Stats
+    {
+        std::uint64_t hits{0};
+        std::uint64_t staleHits{0};
+        std::uint64_t misses{0};
+        std::uint64_t stores{0};
+        std::uint64_t evictions{0};
+        std::uint64_t refreshes{0};
+    };
+
+    // A cache with `capacity` of 0 is disabled
+    CGICache(std::size_t capacity, std::size_t maxObject);
+
+    // OCF
+    CGICache() = delete;
+    CGICache(const CGICache &other) = delete;
+    CGICache &operator=(const CGICache &other) = delete;
+    ~CGICache() = default;
+
+    // Whether a request could be answered from (and its response stored in) the cache: a GET or HEAD without credentials
+    [[nodiscard]] static bool        isCacheableRequest(const HTTPRequestData &data);
+    // Key of the response to a request on `server` (HEAD shares the entries of GET)
+    [[nodiscard]] static std::string makeKey(const void *server, const HTTPRequestData &data, const Settings &settings);
+    /* How long a response with `status` and the script's header fields is kept, for a location's `settings`. False if
+    it isn't to be stored at all */
+    [[nodiscard]] static bool        getLifetime(int status, const Headers &headers, const Settings &settings,
+                                                 Lifetime &lifetime);
+    [[nodiscard]] bool               isEnabled() const;
+    // Largest body (in bytes) that is stored
+    [[nodiscard]] std::size_t        getMaxObject() const;
+
+    // Returns nullptr on miss (counted in the stats, like hits); `freshness` tells whether the entry has expired
+    EntryPtr lookup(const std::string &key, Freshness &freshness);
+    void     store(const std::string &key, Headers headers, std::string body, const Lifetime &lifetime);
+    // Whether the caller is to refresh the entry of `key` (false if a refresh is already running)
+    bool     startRefresh(const std::string &key);
+    // The refresh of `key` is over, whether or not it stored a new entry
+    void     endRefresh(const std::string &key);
+
+    [[nodiscard]] const Stats &getStats() const;
+    [[nodiscard]] std::size_t  getSize() const;
+    [[nodiscard]] std::size_t  getEntryCount() const;
+
+private:
+    using LRUList = std::list<std::pair<std::string, EntryPtr>>;
+
+    std::size_t _capacity;
+    std::size_t _max_object;
+    std::size_t _size{0}; // Bytes held by entries (including their keys)
+    Stats       _stats{};
+
+    // Most recently used first
+    LRUList                                            _lru{};
+    std::unordered_map<std::string, LRUList::iterator> _index{};
+    std::unordered_set<std::string>                    _refreshing{};
+
+    void               erase(LRUList::iterator it);
+    static std::size_t footprint(const std::string &key, const Entry &entry);
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "HTTPRequestData.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional> /* std::hash */
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#define CONTENT_CACHE_DEFAULT_MAX_OBJECT 65536 // bytes
+#define CONTENT_CACHE_DEFAULT_VALID 60         // seconds
+
+/* Memory-budgeted LRU cache of complete `200 OK` responses to GET requests for small static files, keyed by server and
+request path. A hit skips location lookup, path resolution, file I/O and response building: the client gets a freshly
+rendered status and Date line followed by the stored bytes, in a single writev().
+Entries are trusted for `valid` seconds (time-dependent headers such as a relative Expires can be that much behind).
+The whole cache is dropped whenever the server itself modifies files; with the root index, entries are also dropped as
+soon as the file they were built from changes on disk. */
+class ContentCache
+{
+public:
+    struct Entry
+    {
+        std::string tail;           // Everything after the Date line: the other headers, the empty line and the body
+        std::size_t headersSize{0}; // Length of the header part of `tail` (what HEAD sends)
+        std::string file;           // The file the response was built from
+
+        std::chrono::steady_clock::time_point validUntil{};
+    };
+    using EntryPtr = std::shared_ptr<const Entry>;
+
+    struct Stats
+    {
+        std::uint64_t hits{0};
+        std::uint64_t misses{0};
+        std::uint64_t stores{0};
+        std::uint64_t evictions{0};
+    };
+
+    // A cache with `capacity` of 0 is disabled
+    ContentCache(std::size_t capacity, std::size_t maxObject, long valid);
+
+    // OCF
+    ContentCache() = delete;
+    ContentCache(const ContentCache &other) = delete;
+    ContentCache &operator=(const ContentCache &other) = delete;
+    ~ContentCache() = default;
+
+    // Whether a request could be answered from (and its response stored in) the cache: a plain GET or HEAD
+    [[nodiscard]] static bool isCacheableRequest(const HTTPRequestData &data);
+    // Whether a body of this size is small enough to be stored
+    [[nodiscard]] bool        admits(std::size_t bodySize) const;
+    [[nodiscard]] bool        isEnabled() const;
+
+    // Returns nullptr on miss (counted in the stats)
+    EntryPtr lookup(const void *server, std::string_view path);
+    // Store a rendered `200 OK` response (as produced by `ResponseWriter`, with the Date header first) built from `file`
+    void     store(const void *server, std::string_view path, const std::string &response, const std::string &file);
+    // Drop every response built from `file`
+    void     invalidateFile(const std::string &file);
+    void     clear();
+
+    // Status line and Date header sent in front of a stored `tail`
+    static void renderFreshHead(std::string &out);
+
+    [[nodiscard]] const Stats &getStats() const;
+    [[nodiscard]] std::size_t  getSize() const;
+    [[nodiscard]] std::size_t  getEntryCount() const;
+
+private:
+    struct Key
+    {
+        const void *server;
+        std::string path;
+
+        bool operator==(const Key &other) const;
+    };
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const;
+    };
+    using LRUList = std::list<std::pair<Key, EntryPtr>>;
+
+    std::size_t          _capacity;
+    std::size_t          _max_object;
+    std::chrono::seconds _valid;
+    std::size_t          _size{0}; // Bytes held by entries (including their keys)
+    Stats                _stats{};
+
+    // Most recently used first
+    LRUList                                             _lru{};
+    std::unordered_map<Key, LRUList::iterator, KeyHash> _index{};
+
+    void                      erase(LRUList::iterator it);
+    static std::size_t        footprint(const Key &key, const Entry &entry);
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility> /* std::pair */
+#include <vector>
+
+#define DIRECTORY_LISTING_DEFAULT_MAX 100       // directories
+#define DIRECTORY_LISTING_DEFAULT_VALID 60      // seconds
+#define DIRECTORY_LISTING_DEFAULT_SIZE 16000000 // bytes
+#define DIRECTORY_LISTING_PAGE_SIZE 1000        // entries per autoindex page
+
+/* Sorted contents of directories shown by `autoindex`, and the HTML pages already rendered from them.
+A directory is read again once its mtime changes (an entry was added, removed or renamed) or after `valid` seconds, so
+the sizes and dates shown for unchanged entries are at most that old. Reading only needs readdir(): sorting uses the
+names and entry types, and the per-entry stat() is left to the page that displays the entry.
+The cache holds at most `max` directories and `size` bytes (names and rendered pages); the least recently used
+listings are dropped to make room */
+class DirectoryListingCache
+{
+public:
+    struct Item
+    {
+        std::string name;
+        bool        isDirectory;
+    };
+
+    struct Listing
+    {
+        std::vector<Item> items; // Directories first, then by name
+        std::time_t       mtimeSec{0};
+        long              mtimeNsec{0};
+
+        std::chrono::steady_clock::time_point validUntil{};
+
+        // Rendered pages, keyed by what they depend on besides the items (see `pageKey()`). Added with `storePage()`
+        std::unordered_map<std::string, std::string> pages{};
+
+        std::size_t footprint{0}; // Bytes counted against the cache's size
+    };
+    using ListingPtr = std::shared_ptr<Listing>;
+
+    // A cache with `max` or `size` of 0 is disabled: every lookup reads the directory
+    DirectoryListingCache(std::size_t max, long valid, std::size_t size);
+
+    // OCF
+    DirectoryListingCache() = delete;
+    DirectoryListingCache(const DirectoryListingCache &other) = delete;
+    DirectoryListingCache &operator=(const DirectoryListingCache &other) = delete;
+    ~DirectoryListingCache() = default;
+
+    // Listing of `dirPath` (read now if it's not cached or out of date). Returns nullptr if it can't be read
+    ListingPtr lookup(const std::string &dirPath);
+    // Keep the page rendered from `listing` (as returned by `lookup(dirPath)`) if it's still cached and the page fits
+    void       storePage(const std::string &dirPath, const ListingPtr &listing, const std::string &key, std::string html);
+    // Forget `dirPath` (after the server itself changed something in it)
+    void       invalidate(const std::string &dirPath);
+    void       clear();
+
+    [[nodiscard]] std::size_t getSize() const;
+
+    // Key of a rendered page in `Listing::pages`
+    static std::string pageKey(const std::string &uriPath, std::size_t page);
+
+private:
+    using LRUList = std::list<std::pair<std::string, ListingPtr>>;
+
+    std::size_t          _max;
+    std::chrono::seconds _valid;
+    std::size_t          _capacity;
+    std::size_t          _size{0}; // Bytes held by the listings (including their paths)
+
+    // Most recently used first
+    LRUList                                            _lru{};
+    std::unordered_map<std::string, LRUList::iterator> _index{};
+
+    ListingPtr load(const std::string &dirPath) const;
+    void       erase(LRUList::iterator it);
+    // Drop the least recently used listings (but not the most recent one) until the cache fits in its limits
+    void       evict();
+};
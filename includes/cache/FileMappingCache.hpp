@@ -0,0 +1,65 @@
+#pragma once
+
+#include "OpenFileCache.hpp"
+#include <cstddef>
+#include <ctime>
+#include <list>
+#include <map>
+#include <memory>
+#include <sys/types.h> /* dev_t, ino_t */
+#include <utility>     /* std::pair */
+
+#define FILE_MAPPING_DEFAULT_MIN 65536   // bytes
+#define FILE_MAPPING_DEFAULT_MAX 8000000 // bytes
+
+/* Read-only `mmap()` mappings of medium-sized files, shared by every connection that serves the same file.
+Which files are mapped is decided by size (`min` < size <= `max`); smaller ones are left to the hot cache and
+larger ones to sendfile(). Mappings are keyed by device and inode and replaced when the file's size or mtime changes.
+When `capacity` bytes are mapped, the least recently used mapping is dropped; it is unmapped once the last response
+using it has been sent. */
+class FileMappingCache
+{
+public:
+    struct Mapping
+    {
+        const char *data{nullptr};
+        std::size_t size{0};
+        std::time_t mtime{0};
+
+        Mapping() = default;
+        Mapping(const Mapping &other) = delete;
+        Mapping &operator=(const Mapping &other) = delete;
+        ~Mapping();
+    };
+    using MappingPtr = std::shared_ptr<const Mapping>;
+
+    // A cache with `capacity` of 0 is disabled
+    FileMappingCache(std::size_t capacity, std::size_t minSize, std::size_t maxSize);
+
+    // OCF
+    FileMappingCache() = delete;
+    FileMappingCache(const FileMappingCache &other) = delete;
+    FileMappingCache &operator=(const FileMappingCache &other) = delete;
+    ~FileMappingCache() = default;
+
+    // Whether a file of this size should be sent from a mapping
+    [[nodiscard]] bool selects(std::size_t fileSize) const;
+    // Shared mapping of an open file (created if needed). Returns nullptr if it can't be mapped
+    MappingPtr         map(const OpenFileCache::Entry &file);
+    void               clear();
+
+private:
+    using Key = std::pair<dev_t, ino_t>;
+    using LRUList = std::list<std::pair<Key, MappingPtr>>;
+
+    std::size_t _capacity;
+    std::size_t _min_size;
+    std::size_t _max_size;
+    std::size_t _size{0}; // Bytes currently mapped by the cache
+
+    // Most recently used first
+    LRUList                          _lru{};
+    std::map<Key, LRUList::iterator> _index{};
+
+    void erase(LRUList::iterator it);
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "GzipEncoder.hpp"
+#include "OpenFileCache.hpp"
+#include <cstddef>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility> /* std::pair */
+
+#define GZIP_CACHE_DEFAULT_SIZE 16000000     // bytes
+#define GZIP_CACHE_DEFAULT_MAX_OBJECT 1000000 // bytes
+
+/* Gzip-compressed bodies of static files, keyed by path, so each file is compressed once instead of on every request.
+An entry is only used while the file still has the size and mtime (and is wanted at the compression level) it was
+compressed with. Files larger than `maxObject` are never compressed on the fly, since that would block the event
+loop; with a `capacity` of 0 nothing is kept and eligible files are compressed for every request */
+class GzipCache
+{
+public:
+    using BodyPtr = std::shared_ptr<const std::string>;
+
+    GzipCache(std::size_t capacity, std::size_t maxObject);
+
+    // OCF
+    GzipCache() = delete;
+    GzipCache(const GzipCache &other) = delete;
+    GzipCache &operator=(const GzipCache &other) = delete;
+    ~GzipCache() = default;
+
+    // Whether a file of this size may be compressed on the fly
+    [[nodiscard]] bool admits(std::size_t fileSize) const;
+    // Compressed body of an open file (compressed now if it isn't cached). Returns nullptr if the file can't be read
+    BodyPtr            get(const std::string &path, const OpenFileCache::Entry &file, int level);
+    // Compressed body of an open file if it's cached already, nullptr otherwise (nothing is read nor compressed)
+    BodyPtr            lookup(const std::string &path, const OpenFileCache::Entry &file, int level);
+    void               invalidate(const std::string &path);
+    void               clear();
+
+private:
+    struct Entry
+    {
+        BodyPtr     body;
+        std::size_t size;
+        std::time_t mtime;
+        int         level;
+    };
+    using LRUList = std::list<std::pair<std::string, Entry>>;
+
+    std::size_t _capacity;
+    std::size_t _max_object;
+    std::size_t _size{0}; // Compressed bytes currently cached
+
+    // Most recently used first
+    LRUList                                            _lru{};
+    std::unordered_map<std::string, LRUList::iterator> _index{};
+
+    void erase(LRUList::iterator it);
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "MimeTypes.hpp"
+#include "utils.hpp"
+#include <chrono>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <sys/types.h> /* dev_t, ino_t */
+#include <unordered_map>
+#include <utility> /* std::pair */
+
+#define OPEN_FILE_CACHE_DEFAULT_VALID 60 // seconds
+
+/* Caches what resolving a path on disk found out (like nginx's `open_file_cache`): whether it exists, whether it is a
+directory and, for a regular file, an open read-only fd with everything its response headers need.
+A hit costs no syscalls at all. Entries (including negative ones for missing paths) are trusted for `valid` seconds and
+then looked up again; they can also be invalidated when the server itself changes a file.
+Entries are shared: a request keeps the one it serves from, so its fd stays open even if the entry is evicted. */
+class OpenFileCache
+{
+public:
+    struct Entry
+    {
+        bool             exists{false};
+        bool             isDirectory{false};
+        int              error{0}; // Why the content can't be served (errno, e.g., EACCES or EISDIR), 0 if it can
+        int              fd{-1};   // Owned, closed when the last user of the entry is gone
+        std::size_t      size{0};
+        std::time_t      mtime{0};
+        dev_t            dev{0};
+        ino_t            ino{0};
+        std::string      lastModified{};
+        std::string      etag{};
+        std::string_view mimeType{};
+
+        std::chrono::steady_clock::time_point validUntil{};
+
+        Entry() = default;
+        Entry(const Entry &other) = delete;
+        Entry &operator=(const Entry &other) = delete;
+        ~Entry();
+    };
+    using EntryPtr = std::shared_ptr<const Entry>;
+
+    // A cache with `max` of 0 is disabled: every lookup goes to the filesystem
+    OpenFileCache(std::size_t max, long valid);
+
+    // OCF
+    OpenFileCache() = delete;
+    OpenFileCache(const OpenFileCache &other) = delete;
+    OpenFileCache &operator=(const OpenFileCache &other) = delete;
+    ~OpenFileCache() = default;
+
+    // What is known about `path` (looked up now if it's not cached or no longer valid). Never returns nullptr
+    EntryPtr lookup(const std::string &path);
+    // Forget `path` (after it has been created, modified or removed by the server)
+    void     invalidate(const std::string &path);
+    void     clear();
+
+    [[nodiscard]] bool isEnabled() const;
+
+private:
+    using LRUList = std::list<std::pair<std::string, EntryPtr>>;
+
+    std::size_t          _max;
+    std::chrono::seconds _valid;
+
+    // Most recently used first
+    LRUList                                            _lru{};
+    std::unordered_map<std::string, LRUList::iterator> _index{};
+
+    EntryPtr load(const std::string &path) const;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional> /* std::hash */
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#define RESOLUTION_CACHE_DEFAULT_MAX 10000 // paths
+
+class LocationConfig;
+
+/* LRU cache of what a request path resolves to on a given server: the matching location, the normalized file path
+under its root (or that the path escapes it), the CGI handler for it and, for directories, the index file.
+Everything but the index file only depends on the configuration and is kept until evicted. The index file depends on
+the filesystem, so it is trusted for `indexValid` seconds (like the open file cache) or until `forgetIndexFiles()` is
+called because files changed. */
+class ResolutionCache
+{
+public:
+    struct Entry
+    {
+        const LocationConfig *location{nullptr};
+        bool                  underRoot{false};         // False if the path escapes the root (the request is forbidden)
+        std::string           filePath{};               // Root joined with the path, lexically normalized
+        const std::string    *cgiInterpreter{nullptr};  // CGI handler for `filePath`, nullptr if it's not a script
+
+        // Index file of the directory at `filePath` (empty if it has none), see `getIndexFile()`
+        std::string                           indexFile{};
+        const std::string                    *indexCGIInterpreter{nullptr};
+        std::size_t                           indexGeneration{0};
+        std::chrono::steady_clock::time_point indexValidUntil{};
+    };
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    // A cache with `max` of 0 is disabled: every request path is resolved again
+    ResolutionCache(std::size_t max, long indexValid);
+
+    // OCF
+    ResolutionCache() = delete;
+    ResolutionCache(const ResolutionCache &other) = delete;
+    ResolutionCache &operator=(const ResolutionCache &other) = delete;
+    ~ResolutionCache() = default;
+
+    // Returns nullptr on miss
+    EntryPtr lookup(const void *server, const std::string &path);
+    void     store(const void *server, const std::string &path, EntryPtr entry);
+    void     clear();
+
+    // Resolve a request path (without query) within `location`. Never returns nullptr
+    [[nodiscard]] static EntryPtr resolve(const LocationConfig *location, const std::string &path);
+
+    // Whether `entry` remembers an index file that can still be trusted
+    [[nodiscard]] bool hasIndexFile(const Entry &entry) const;
+    // Remember the index file the directory of `entry` resolved to (empty if none)
+    void               setIndexFile(Entry &entry, std::string indexFile) const;
+    // Stop trusting every remembered index file (after files were created or removed)
+    void               forgetIndexFiles();
+
+    // CGI handler configured in `location` for the extension of `path`, nullptr if there is none
+    [[nodiscard]] static const std::string *findCGIInterpreter(const LocationConfig *location, const std::string &path);
+
+private:
+    struct Key
+    {
+        const void *server;
+        std::string path;
+
+        bool operator==(const Key &other) const;
+    };
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const;
+    };
+    using LRUList = std::list<std::pair<Key, EntryPtr>>;
+
+    std::size_t          _max;
+    std::chrono::seconds _index_valid;
+    std::size_t          _index_generation{1}; // Index files remembered in earlier generations are not trusted
+
+    // Most recently used first
+    LRUList                                              _lru{};
+    std::unordered_map<Key, LRUList::iterator, KeyHash> _index{};
+};
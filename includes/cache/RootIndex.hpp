@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define ROOT_INDEX_DEFAULT_MAX 1000000 // paths
+
+/* In-memory index of every path under the configured document roots, kept up to date with inotify.
+It answers "does this exist, and is it a directory?" with a hash lookup, so requests for paths that aren't there
+(e.g., bots scanning for `/wp-admin`) are rejected without touching the filesystem. Paths are stored the way requests
+build them (root joined with the URI, lexically normalized, no trailing slash).
+Anything the index can't vouch for (symlinks, unreadable directories, paths outside the roots, or everything after
+it gave up because a root holds more than `max` paths) is answered with UNKNOWN, and the caller asks the filesystem */
+class RootIndex
+{
+public:
+    enum State
+    {
+        UNKNOWN,
+        MISSING,
+        FILE,
+        DIRECTORY
+    };
+
+    // An index with `max` of 0 is disabled: every lookup answers UNKNOWN
+    explicit RootIndex(std::size_t max);
+
+    // OCF
+    RootIndex() = delete;
+    RootIndex(const RootIndex &other) = delete;
+    RootIndex &operator=(const RootIndex &other) = delete;
+    ~RootIndex();
+
+    // Index a root directory and watch it (and everything below it) for changes
+    void addRoot(const std::string &root);
+
+    [[nodiscard]] State       lookup(const std::string &path) const;
+    [[nodiscard]] std::size_t getPathCount() const;
+
+    // inotify fd to poll for readability (-1 if the index is disabled)
+    [[nodiscard]] int getFd() const;
+    [[nodiscard]] bool isEnabled() const;
+
+    /* Apply the pending filesystem events to the index. `changed` receives every path that was created, modified or
+    removed; returns false if events were lost (the index is rebuilt and the caller should drop everything it cached) */
+    bool processEvents(std::vector<std::string> &changed);
+
+private:
+    enum Kind
+    {
+        KIND_FILE,
+        KIND_DIRECTORY,
+        KIND_OTHER // Known to exist, but its type (or contents) isn't tracked
+    };
+
+    std::size_t _max;
+    int         _fd{-1};
+
+    std::vector<std::string>              _roots{};
+    std::unordered_map<std::string, Kind> _nodes{};
+    std::unordered_map<int, std::string>  _watchedDirs{}; // inotify watch descriptor -> directory path
+
+    void indexDirectory(const std::string &dirPath);
+    void addPath(const std::string &path);
+    void removePath(const std::string &path);
+    void rebuild();
+    void disable(const std::string &reason);
+};
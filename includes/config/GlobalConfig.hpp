@@ -1,5 +1,15 @@
 #pragma once
 
+#include "CGICache.hpp"              /* CGI_CACHE_DEFAULT_* */
+#include "CGIConcurrencyLimiter.hpp" /* CGIConcurrencyLimiter::Settings */
+#include "CGIWorkerPool.hpp"         /* CGIWorkerPool::Settings */
+#include "ContentCache.hpp"          /* CONTENT_CACHE_DEFAULT_* */
+#include "DirectoryListingCache.hpp" /* DIRECTORY_LISTING_DEFAULT_* */
+#include "FileMappingCache.hpp"      /* FILE_MAPPING_DEFAULT_* */
+#include "GzipCache.hpp"             /* GZIP_CACHE_DEFAULT_* */
+#include "OpenFileCache.hpp"         /* OPEN_FILE_CACHE_DEFAULT_VALID */
+#include "ResolutionCache.hpp"       /* RESOLUTION_CACHE_DEFAULT_MAX */
+#include "RootIndex.hpp"             /* ROOT_INDEX_DEFAULT_MAX */
 #include "ServerConfig.hpp"
 #include "utils.hpp"
 #include <algorithm> /* std::transform() */
@@ -36,6 +46,26 @@ public:
     bool                                              getAutoIndex() const;
     const std::map<int, std::string>                 &getErrorPagesMap() const;
     const std::vector<std::unique_ptr<ServerConfig>> &getServerConfigs() const;
+    std::size_t                                       getOpenFileCacheMax() const;
+    long                                              getOpenFileCacheValid() const;
+    std::size_t                                       getHotCacheSize() const;
+    std::size_t                                       getHotCacheMaxObject() const;
+    long                                              getHotCacheValid() const;
+    bool                                              getHotCacheStats() const;
+    std::size_t                                       getCGICacheSize() const;
+    std::size_t                                       getCGICacheMaxObject() const;
+    std::size_t                                       getMmapCacheSize() const;
+    std::size_t                                       getMmapCacheMin() const;
+    std::size_t                                       getMmapCacheMax() const;
+    std::size_t                                       getGzipCacheSize() const;
+    std::size_t                                       getGzipCacheMaxObject() const;
+    std::size_t                                       getAutoIndexCacheMax() const;
+    long                                              getAutoIndexCacheValid() const;
+    std::size_t                                       getAutoIndexCacheSize() const;
+    std::size_t                                       getRootIndexMax() const;
+    std::size_t                                       getResolutionCacheMax() const;
+    const std::map<std::string, CGIWorkerPool::Settings> &getCGIPools() const;
+    const CGIConcurrencyLimiter::Settings                &getCGIConcurrency() const;
 
 private:
     // Root directory for requests
@@ -56,12 +86,80 @@ private:
     // `ServerConfig`s
     std::vector<std::unique_ptr<ServerConfig>> _serverConfigs{};
 
+    // Maximum number of entries in the open file cache (0 disables it)
+    std::size_t _open_file_cache_max{0};
+
+    // Seconds an open file cache entry is trusted before the file is looked up again
+    long _open_file_cache_valid{OPEN_FILE_CACHE_DEFAULT_VALID};
+
+    // Memory budget (in bytes) of the cache of complete small static responses (0 disables it)
+    std::size_t _hot_cache_size{0};
+
+    // Largest body (in bytes) that is stored in the hot cache
+    std::size_t _hot_cache_max_object{CONTENT_CACHE_DEFAULT_MAX_OBJECT};
+
+    // Seconds a hot cache entry is served before the file is read again
+    long _hot_cache_valid{CONTENT_CACHE_DEFAULT_VALID};
+
+    // Whether hot cache hit/miss counters are reported
+    bool _hot_cache_stats{false};
+
+    // Memory budget (in bytes) of the cache of CGI output, used by locations with `cgi_cache` (0 disables it)
+    std::size_t _cgi_cache_size{CGI_CACHE_DEFAULT_SIZE};
+
+    // Largest CGI response body (in bytes) that is stored in the CGI cache
+    std::size_t _cgi_cache_max_object{CGI_CACHE_DEFAULT_MAX_OBJECT};
+
+    // Bytes of medium-sized files kept mapped with mmap() (0 disables mappings; everything goes through sendfile())
+    std::size_t _mmap_cache_size{0};
+
+    // Files larger than this (in bytes) and up to `_mmap_cache_max` are sent from a shared mapping
+    std::size_t _mmap_cache_min{FILE_MAPPING_DEFAULT_MIN};
+    std::size_t _mmap_cache_max{FILE_MAPPING_DEFAULT_MAX};
+
+    // Memory budget (in bytes) of the cache of gzip-compressed static files (0 compresses them for every request)
+    std::size_t _gzip_cache_size{GZIP_CACHE_DEFAULT_SIZE};
+
+    // Largest static file (in bytes) that is compressed on the fly
+    std::size_t _gzip_cache_max_object{GZIP_CACHE_DEFAULT_MAX_OBJECT};
+
+    // Maximum number of directories whose `autoindex` listings are cached (0 reads them for every request)
+    std::size_t _autoindex_cache_max{DIRECTORY_LISTING_DEFAULT_MAX};
+
+    // Seconds a cached listing of an unchanged directory is served before it is read again
+    long _autoindex_cache_valid{DIRECTORY_LISTING_DEFAULT_VALID};
+
+    // Memory budget (in bytes) of the cached listings: the names they hold and the pages rendered from them
+    std::size_t _autoindex_cache_size{DIRECTORY_LISTING_DEFAULT_SIZE};
+
+    // Maximum number of paths in the inotify-backed index of the roots (0 disables it)
+    std::size_t _root_index_max{0};
+
+    // Maximum number of request paths whose resolution (location, file path, index file, CGI handler) is cached
+    std::size_t _resolution_cache_max{RESOLUTION_CACHE_DEFAULT_MAX};
+
+    // Interpreters whose scripts are run by pooled long-lived workers instead of a new process per request
+    std::map<std::string, CGIWorkerPool::Settings> _cgi_pools{};
+
+    // How many CGI subprocesses run at once, and how the requests beyond that wait for them
+    CGIConcurrencyLimiter::Settings _cgi_concurrency{};
+
 private: // Data members for parser only
     // Represents whether a value has already been seen in the config file
     bool _seen_root{false};
     bool _seen_client_max_body_size{false};
     bool _seen_autoindex{false};
     bool _seen_index{false};
+    bool _seen_open_file_cache{false};
+    bool _seen_hot_cache{false};
+    bool _seen_hot_cache_stats{false};
+    bool _seen_cgi_cache_zone{false};
+    bool _seen_mmap_cache{false};
+    bool _seen_gzip_cache{false};
+    bool _seen_autoindex_cache{false};
+    bool _seen_root_index{false};
+    bool _seen_resolution_cache{false};
+    bool _seen_cgi_max_concurrency{false};
 
     // `ServerConfig`s in string form only for use in parser
     std::vector<std::string> _serverConfigsStr{};
@@ -78,4 +176,15 @@ private: // Member functions for parser only
     void setAutoIndex(std::string directive);
     void setErrorPage(std::string directive);
     void setIndex(std::string directive);
+    void setOpenFileCache(std::string directive);
+    void setHotCache(std::string directive);
+    void setHotCacheStats(std::string directive);
+    void setCGICacheZone(std::string directive);
+    void setMmapCache(std::string directive);
+    void setGzipCache(std::string directive);
+    void setAutoIndexCache(std::string directive);
+    void setRootIndex(std::string directive);
+    void setResolutionCache(std::string directive);
+    void setCGIPool(std::string directive);
+    void setCGIMaxConcurrency(std::string directive);
 };
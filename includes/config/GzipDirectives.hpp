@@ -0,0 +1,34 @@
+#pragma once
+
+#include "utils.hpp"
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#define GZIP_DEFAULT_COMP_LEVEL 1
+#define GZIP_MIN_LENGTH 256 // bytes; smaller bodies gain too little from compression
+
+/* `gzip`, `gzip_comp_level` and `gzip_types` directives of a server or location: whether responses are compressed on
+the fly, how hard, and which content types qualify (`text/html` always does, `*` matches every type) */
+class GzipDirectives
+{
+public:
+    // Parse `gzip on | off`
+    void setEnabled(const std::string &directive);
+    // Parse `gzip_comp_level <1-9>`
+    void setCompLevel(const std::string &directive);
+    // Parse `gzip_types <mime-type> ...` (replaces the inherited list)
+    void setTypes(const std::string &directive);
+
+    [[nodiscard]] bool isEnabled() const;
+    [[nodiscard]] int  getCompLevel() const;
+    // Whether a response with this Content-Type (parameters like `; charset=` are ignored) may be compressed
+    [[nodiscard]] bool compressesType(std::string_view contentType) const;
+
+private:
+    bool                  _enabled{false};
+    int                   _comp_level{GZIP_DEFAULT_COMP_LEVEL};
+    bool                  _all_types{false};
+    std::set<std::string> _types{"text/html"};
+};
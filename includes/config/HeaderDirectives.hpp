@@ -0,0 +1,51 @@
+#pragma once
+
+#include "utils.hpp"
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/* `expires` and `add_header` directives of a server or location, precompiled when the config is loaded so that
+applying them to a response is a couple of copies (only a relative Expires date has to be formatted, once a second) */
+class HeaderDirectives
+{
+public:
+    // Parse `expires off | epoch | max | <time>` (e.g., `expires 30d;`, `expires 1h30m;`, `expires -1;`)
+    void setExpires(const std::string &directive);
+    // Parse `add_header <name> <value> [always]` (can be repeated, lines are kept in config order)
+    void addHeader(const std::string &directive);
+    // Forget the `add_header`s (a location that defines its own doesn't inherit the server's)
+    void clearAddedHeaders();
+
+    [[nodiscard]] bool empty() const;
+    // Whether `expires` and the `add_header`s without `always` apply to a response with this status
+    [[nodiscard]] static bool appliesToStatus(int statusCode);
+
+    [[nodiscard]] bool             hasExpires() const;
+    [[nodiscard]] std::string_view getCacheControl() const;
+    [[nodiscard]] std::string_view getExpires() const;
+    // Rendered "Name: value\r\n" lines
+    [[nodiscard]] std::string_view getAddedHeaders() const;
+    [[nodiscard]] std::string_view getAddedHeadersAlways() const;
+
+private:
+    enum ExpiresMode
+    {
+        EXPIRES_OFF,
+        EXPIRES_FIXED,   // `epoch` and `max`: the Expires value never changes
+        EXPIRES_RELATIVE // Expires is the response time plus `_expires_seconds`
+    };
+
+    ExpiresMode _expires_mode{EXPIRES_OFF};
+    long        _expires_seconds{0};
+    std::string _cache_control{};
+    std::string _expires{};
+
+    std::string _added_headers{};
+    std::string _added_headers_always{};
+
+    // Relative Expires value, formatted at most once per second
+    mutable std::time_t _expires_formatted_at{-1};
+    mutable std::string _expires_formatted{};
+};
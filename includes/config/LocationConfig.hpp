@@ -1,5 +1,8 @@
 #pragma once
 
+#include "CGICache.hpp" /* CGICache::Settings */
+#include "GzipDirectives.hpp"
+#include "HeaderDirectives.hpp"
 #include "ServerConfig.hpp"
 #include <map>
 #include <set>
@@ -29,11 +32,20 @@ public:
     [[nodiscard]] const std::vector<std::string>           &getIndexFilesVec() const;
     [[nodiscard]] std::size_t                               getClientMaxBodySize() const;
     [[nodiscard]] bool                                      getAutoIndex() const;
+    [[nodiscard]] bool                                      getGzipStatic() const;
+    [[nodiscard]] bool                                      getBrotliStatic() const;
     [[nodiscard]] const std::map<int, std::string>         &getErrorPagesMap() const;
     [[nodiscard]] const std::set<std::string>              &getLimitExcept() const;
     [[nodiscard]] const std::string                        &getUploadStore() const;
     [[nodiscard]] const std::pair<int, std::string>        &getReturn() const;
     [[nodiscard]] const std::map<std::string, std::string> &getCGIHandlersMap() const;
+    [[nodiscard]] const HeaderDirectives                   &getHeaderDirectives() const;
+    [[nodiscard]] const GzipDirectives                     &getGzipDirectives() const;
+    [[nodiscard]] const std::vector<std::string>           &getPreloadPatterns() const;
+    [[nodiscard]] const std::string                        &getFastCGIPass() const;
+    [[nodiscard]] const CGICache::Settings                 &getCGICache() const;
+    [[nodiscard]] std::size_t                               getCGIMaxConcurrency() const;
+    [[nodiscard]] bool                                      getMetrics() const;
 
 private:
     // Root directory for requests to this location
@@ -48,6 +60,10 @@ private:
     // Enables or disables the directory listing output
     bool _autoindex{false};
 
+    // Serve precompressed `<file>.gz`/`<file>.br` siblings to clients that accept them
+    bool _gzip_static{false};
+    bool _brotli_static{false};
+
     // URI that will be shown for the specified error codes (must be between 300 and 599)
     std::map<int, std::string> _error_pages_map{};
 
@@ -63,17 +79,49 @@ private:
     // For redirects; Stops processing and returns the specified code to the client
     std::pair<int, std::string> _return{-1, ""};
 
+    // `expires` and `add_header` directives applied to responses from this location
+    HeaderDirectives _header_directives{};
+
+    // `gzip`, `gzip_comp_level` and `gzip_types` directives (on-the-fly compression)
+    GzipDirectives _gzip_directives{};
+
+    // Glob patterns (URI paths under the root) of files loaded into the caches at startup (not inherited)
+    std::vector<std::string> _preload_patterns{};
+
+    // FastCGI responder requests are passed to (`unix:/path/to/socket` or `host:port`), empty if none (not inherited)
+    std::string _fastcgi_pass{""};
+
+    // How long the output of the location's scripts is served from the CGI cache, and what it's keyed on (not inherited)
+    CGICache::Settings _cgi_cache{};
+
+    // Scripts of this location that run at once, on top of the global limit (0 is no limit of its own; not inherited)
+    std::size_t _cgi_max_concurrency{0};
+
+    // Answer requests with the server's counters instead of files (not inherited)
+    bool _metrics{false};
+
 private: // Data members for parser only
     // Represents whether a value has already been seen in the config file
     bool _seen_root{false};
     bool _seen_client_max_body_size{false};
     bool _seen_autoindex{false};
+    bool _seen_gzip_static{false};
+    bool _seen_brotli_static{false};
     bool _seen_index{false};
     // bool _seen_error_page{false}; // unused
     bool _seen_limit_except{false};
     bool _seen_upload_store{false};
     bool _seen_return{false};
     bool _seen_cgi_handler{false};
+    bool _seen_expires{false};
+    bool _seen_gzip{false};
+    bool _seen_gzip_comp_level{false};
+    bool _seen_gzip_types{false};
+    bool _seen_add_header{false};
+    bool _seen_fastcgi_pass{false};
+    bool _seen_cgi_cache{false};
+    bool _seen_cgi_max_concurrency{false};
+    bool _seen_metrics{false};
 
 private: // Member functions for parser only
     // Main parser
@@ -85,10 +133,22 @@ private: // Member functions for parser only
     void setRoot(std::string directive);
     void setClientMaxBodySize(std::string directive);
     void setAutoIndex(std::string directive);
+    void setGzipStatic(std::string directive);
+    void setBrotliStatic(std::string directive);
+    void setGzip(std::string directive);
+    void setGzipCompLevel(std::string directive);
+    void setGzipTypes(std::string directive);
     void setErrorPage(std::string directive);
     void setIndex(std::string directive);
     void setLimitExcept(std::string directive);
     void setUploadStore(std::string directive);
     void setReturn(std::string directive);
     void setCGIHandler(std::string directive);
+    void setExpires(std::string directive);
+    void setAddHeader(std::string directive);
+    void setPreload(std::string directive);
+    void setFastCGIPass(std::string directive);
+    void setCGICache(std::string directive);
+    void setCGIMaxConcurrency(std::string directive);
+    void setMetrics(std::string directive);
 };
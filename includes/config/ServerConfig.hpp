@@ -1,6 +1,8 @@
 #pragma once
 
 #include "GlobalConfig.hpp"
+#include "GzipDirectives.hpp"
+#include "HeaderDirectives.hpp"
 #include "LocationConfig.hpp"
 #include "utils.hpp"
 #include <cstring> /* std::memset() */
@@ -44,9 +46,14 @@ public:
     [[nodiscard]] const std::vector<std::string>                               &getIndexFilesVec() const;
     [[nodiscard]] std::size_t                                                   getClientMaxBodySize() const;
     [[nodiscard]] bool                                                          getAutoIndex() const;
+    [[nodiscard]] bool                                                          getGzipStatic() const;
+    [[nodiscard]] bool                                                          getBrotliStatic() const;
     [[nodiscard]] const std::map<int, std::string>                             &getErrorPagesMap() const;
     [[nodiscard]] const std::map<std::string, std::unique_ptr<LocationConfig>> &getLocationsMap() const;
     [[nodiscard]] const std::map<std::string, std::string>                     &getCGIHandlersMap() const;
+    [[nodiscard]] const HeaderDirectives                                       &getHeaderDirectives() const;
+    [[nodiscard]] const GzipDirectives                                         &getGzipDirectives() const;
+    [[nodiscard]] const std::vector<std::string>                               &getPreloadPatterns() const;
 
 private:
     // All `host:port` combinations this server listens to // * Better convert to unordered_set or unordered_map
@@ -70,6 +77,10 @@ private:
     // Enables or disables the directory listing output
     bool _autoindex{false};
 
+    // Serve precompressed `<file>.gz`/`<file>.br` siblings to clients that accept them
+    bool _gzip_static{false};
+    bool _brotli_static{false};
+
     // URI that will be shown for the specified error codes (must be between 300 and 599)
     std::map<int, std::string> _error_pages_map{};
 
@@ -79,14 +90,29 @@ private:
     // CGI handler, maps extensions (e.g., `.py` or `.php`) to their interpreters (e.g., `/usr/bin/python3`)
     std::map<std::string, std::string> _cgi_handlers_map{};
 
+    // `expires` and `add_header` directives (inherited by locations)
+    HeaderDirectives _header_directives{};
+
+    // `gzip`, `gzip_comp_level` and `gzip_types` directives (on-the-fly compression)
+    GzipDirectives _gzip_directives{};
+
+    // Glob patterns (URI paths under the root) of files loaded into the caches at startup (not inherited)
+    std::vector<std::string> _preload_patterns{};
+
 private: // Data members for parser only
     // Represents whether a value has already been seen in the config file
     bool _seen_listen{false};
     bool _seen_root{false};
     bool _seen_client_max_body_size{false};
     bool _seen_autoindex{false};
+    bool _seen_gzip_static{false};
+    bool _seen_brotli_static{false};
     bool _seen_index{false};
     bool _seen_cgi_handler{false};
+    bool _seen_expires{false};
+    bool _seen_gzip{false};
+    bool _seen_gzip_comp_level{false};
+    bool _seen_gzip_types{false};
     // bool _seen_error_page{false}; unused for now
 
     // `LocationConfig`s in string form only for use in parser
@@ -109,7 +135,15 @@ private: // Member functions for parser only
     void setRoot(std::string directive);
     void setClientMaxBodySize(std::string directive);
     void setAutoIndex(std::string directive);
+    void setGzipStatic(std::string directive);
+    void setBrotliStatic(std::string directive);
+    void setGzip(std::string directive);
+    void setGzipCompLevel(std::string directive);
+    void setGzipTypes(std::string directive);
     void setErrorPage(std::string directive);
     void setIndex(std::string directive);
     void setCGIHandler(std::string directive);
+    void setExpires(std::string directive);
+    void setAddHeader(std::string directive);
+    void setPreload(std::string directive);
 };
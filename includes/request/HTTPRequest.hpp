@@ -1,14 +1,26 @@
 #pragma once
 
+#include "CGIBodyStream.hpp"
+#include "CGICache.hpp"
+#include "CGIConcurrencyLimiter.hpp"
+#include "CGIResponseRelay.hpp"
 #include "CGISubprocess.hpp"
+#include "DirectoryListingCache.hpp"
+#include "CGIWorkerExchange.hpp"
+#include "FastCGIExchange.hpp"
 #include "HTTPRequestData.hpp"
 #include "HTTPRequestParser.hpp"
 #include "LocationConfig.hpp"
+#include "FileMappingCache.hpp"
+#include "GzipEncoder.hpp"
 #include "MimeTypes.hpp"
+#include "OpenFileCache.hpp"
 #include "PollManager.hpp"
+#include "ResolutionCache.hpp"
 #include "ResponseWriter.hpp"
 #include "utils.hpp"
 #include <algorithm> /* std::transform(), std::replace() */
+#include <charconv> /* std::from_chars() */
 #include <chrono>
 #include <fcntl.h>
 #include <filesystem>
@@ -17,6 +29,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <sys/stat.h> /* fstat() */
 #include <unistd.h>
 #include <unordered_map>
 #include <unordered_set>
@@ -45,10 +58,23 @@ protected:
 
     HTTPRequestData                 _data;
     const LocationConfig           *_effective_config;
+    ResolutionCache::EntryPtr       _resolution{nullptr}; // What the request path resolves to (set by the server)
     ResponseState                   _responseState{NOT_STARTED};
-    std::unique_ptr<ResponseWriter> _responseWithoutBody{nullptr};
     std::unique_ptr<CGISubprocess>  _cgiSubprocess{nullptr};
+    std::shared_ptr<CGIResponseRelay> _cgiRelay{nullptr}; // Output of `_cgiSubprocess`, relayed to the client as it arrives
+    std::shared_ptr<CGIBodyStream>  _bodyStream{nullptr}; // Body still arriving from the client, passed on to the script
+    std::unique_ptr<UpstreamExchange> _upstream{nullptr}; // FastCGI request or CGI worker request in progress
+    int                             _upstreamFd{-1};      // The fd of `_upstream` polled on its behalf
+    std::string                     _cgiCacheKey{};       // Key the script's output is stored under (empty if it isn't)
+    CGICache::Lifetime              _cgiCacheLifetime{};  // How long that output is kept, from the script's headers
+    bool                            _holdsCGISlot{false}; // `_cgiSubprocess` counts against `cgi_max_concurrency`
+    // Script and interpreter of a request waiting in the queue for a CGI slot
+    std::optional<std::pair<std::filesystem::path, std::string>> _cgiWaitingScript{std::nullopt};
     std::string                     _fullResponse;
+    std::vector<FileSegment>        _fileSegments;
+    OpenFileCache::EntryPtr         _bodyFile{nullptr}; // File the `_fileSegments` are sent from (keeps its fd open)
+    FileMappingCache::MappingPtr    _bodyMapping{nullptr}; // Keeps a mapping the `_fileSegments` point into alive
+    std::shared_ptr<const std::string> _sharedBody{nullptr}; // Body sent right after the head, shared with a cache
     Server                         *_server;
     int                             _clientFd;
     ClientData                     *_clientData;
@@ -57,53 +83,95 @@ protected:
     std::optional<std::chrono::time_point<std::chrono::steady_clock>> _cgiStartTime{std::nullopt};
 
 protected: // helper functions to use within public member functions of inherited classes
-    // Remove leading slash from URI so std::filesystem doesn't think it refers to root directory
-    std::string getURInoLeadingSlash() const;
     // If custom files for error codes are not defined, these default bodies are used
     std::string getMinimalErrorDefaultBody(int errorCode) const;
-    // Create HTML directory listing of a given URI (it should be an existing directory)
-    std::string getDirectoryListingBody(const std::filesystem::path &dirPath) const;
+    /* Create the HTML directory listing of a given URI (page `?page=N` of it for huge directories) from the listing cache.
+    Returns false if the directory can't be read or the page doesn't exist */
+    bool        getDirectoryListingBody(const std::filesystem::path &dirPath, std::string &body) const;
     // Redirection
     void        handleRedirection(const std::pair<int, std::string> &redirectInfo);
     // Handle CGI and return the full response to be sent to client
     void        serveCGI(const std::filesystem::path &filePath, const std::string &interpreter);
+    // Run the script in a new subprocess (the request holds a CGI slot) and poll its pipes
+    void        startCGISubprocess(const std::filesystem::path &filePathAbs, const std::string &interpreter);
+    // Start the script once the request waiting in the queue is granted a CGI slot (503 after the queue timeout)
+    void        continueWaitingForCGISlot();
+    // Give the CGI slot back once the script has exited (or the request is gone)
+    void        releaseCGISlot();
+    // 503 with `Retry-After`, for a request that can't get a CGI slot
+    void        serviceUnavailable();
+    // Pass the request to the location's FastCGI responder (with the same parameters a CGI script gets)
+    void        serveFastCGI();
+    /* Respond with the script's output from the CGI cache if the location has `cgi_cache` and it's there (starting a
+    refresh of a stale entry). Otherwise the output of the script about to run is to be stored */
+    bool        serveFromCGICache();
+    // Turn the upstream's answer into the response once it's complete (502/504 from a FastCGI responder and 500 from a
+    // CGI worker if the exchange failed or timed out)
+    void        continueUpstream();
+    // Poll the fd the upstream exchange currently uses (it changes when a connection is retried or a worker assigned)
+    void        syncUpstreamFd();
+    // Stop polling the upstream exchange and let it reuse its connection or worker if possible
+    void        endUpstream();
     // Create environment variables for CGI subprocess
     [[nodiscard]] std::unordered_map<std::string, std::string> createCGIenvironment(const std::filesystem::path &filePath) const;
-    // Generate a response for the given status code (either reading from configured error file or default minimal response)
-    void errorResponse(int errorCode);
+    // Generate a response for the given status code (either reading from configured error file or default minimal response),
+    // with `extraHeaders` (like `Retry-After`) added to it
+    void errorResponse(int errorCode, std::initializer_list<ResponseWriter::HeaderField> extraHeaders = {});
     // bool errorResponseRequiresReadingFile(int errorCode);
-    // Opens an fd for file, adds it to poll manager, initalizes _responseWithoutBody, throws on open error
-    void openFileSetHeaders(const std::filesystem::path &filePath);
+    // Serves a whole file (e.g., a custom error page) with sendfile() from the open file cache, throws on open error
+    void openFileSetHeaders(const std::filesystem::path &filePath, int statusCode = 200,
+                            std::initializer_list<ResponseWriter::HeaderField> extraHeaders = {});
     // Converts the CGI output to a final response ready to be sent to client
     void cgiOutputToResponse(const std::string &cgi_output);
+    // Response with the status and header fields of a CGI response (without its `Status` field)
+    [[nodiscard]] static ResponseWriter cgiHeadersToResponse(std::unordered_map<std::string, std::string> headers);
+    // Index file of the directory the request path resolved to (empty if it has none), remembered in the resolution
+    const std::string &findIndexFile();
     // Normalize path and validate it is under root
     bool normalizeAndValidateUnderRoot(const std::filesystem::path &candidate, std::filesystem::path &outNormalized) const;
-    // Check if CGI has exited, and with what status code. Set `_responseState` accordingly
-    void checkCGIstatus();
+    /* Wait for the CGI subprocess to send its header block, then respond with it while the body is relayed (500 if the
+    output ends without a valid header block or nothing comes within the timeout) */
+    void continueCGI();
+    // Build the head of the response from the script's header fields and start relaying the body
+    void startCGIResponse();
+    // Add the configured `expires` and `add_header` headers and render the response. In-memory bodies are gzipped on the
+    // way out if the location enables it; responses that handle their own encoding pass `compressBody` false
+    [[nodiscard]] std::string renderResponse(ResponseWriter &response, bool compressBody = true) const;
+    // Gzip the body in place if `gzip` applies to this response and the client accepts it (adds `Vary` either way)
+    void                      gzipBody(ResponseWriter &response) const;
+    /* Whether a body of `bodySize` bytes (npos if it isn't known yet) is to be gzipped for this response. Sets `Vary` if
+    gzip applies, and `Content-Encoding` and a weak ETag if the body is to be compressed */
+    [[nodiscard]] bool        prepareGzip(ResponseWriter &response, std::size_t bodySize) const;
+    // Whether the client's `Accept-Encoding` allows gzip
+    [[nodiscard]] bool        acceptsGzip() const;
 
     virtual void continuePrevious() = 0;
 
-public:
-    // Struct for use in directory listing
-    struct FileInfo
-    {
-        std::string name;
-        bool        is_directory;
-        std::size_t size;
-        std::time_t modified_time;
-    };
-
 public:
     HTTPRequest() = delete;
     explicit HTTPRequest(HTTPRequestData data, const LocationConfig *location_config);
     HTTPRequest(const HTTPRequest &) = delete;
     HTTPRequest(HTTPRequest &&) = delete;
-    virtual ~HTTPRequest() = default;
+    virtual ~HTTPRequest();
 
     // Where the magic happens
     virtual std::string getFullResponse();
+    // Body parts to be sent with sendfile() after the full response (the fds stay valid as long as this object lives)
+    std::vector<FileSegment> takeFileSegments();
+    std::shared_ptr<const std::string> takeSharedBody();
     bool                fullResponseIsReady();
     virtual void        generateResponse(Server *server, int clientFd) = 0;
+    void                setResolution(ResolutionCache::EntryPtr resolution);
+    // The body isn't in the request data but arrives through `bodyStream` (set by the server for CGI scripts)
+    void                setBodyStream(std::shared_ptr<CGIBodyStream> bodyStream);
+    // Let the upstream exchange make progress after poll() reported `revents` on its fd. False if there is none
+    bool                handleUpstreamEvents(short revents);
+    // Collect the exit status of the CGI subprocess after poll() reported its exit
+    void                handleProcessExit();
+    // Body relayed from a CGI script after the full response (its head), if it's streamed
+    std::shared_ptr<CGIResponseRelay> getCGIRelay() const;
+    // End the relayed body once the script has exited (called while it's being sent)
+    void                continueCGIResponse();
 
     [[nodiscard]] bool isCloseConnection() const;
 };
@@ -3,7 +3,7 @@
 #include <string>
 #include <unordered_map>
 
-enum HTTPMethod { GET, POST, DELETE, NONE, UNKNOWN, BAD_REQUEST };
+enum HTTPMethod { GET, HEAD, POST, DELETE, NONE, UNKNOWN, BAD_REQUEST };
 
 struct HTTPRequestData
 {
@@ -12,6 +12,8 @@ struct HTTPRequestData
     std::string version;
     std::unordered_map<std::string, std::string> headers;
     std::string body;
+    std::string path{"/"}; // Canonical (decoded and normalized) path of `uri`, what every lookup and cache keys on
+    std::string query;     // Raw query of `uri` (without the '?')
 
     std::string methodStr() const;
 };
\ No newline at end of file
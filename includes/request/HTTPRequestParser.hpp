@@ -19,5 +19,12 @@ private:
 public:
     static bool isValidRequest(const std::string &request_str);
     static HTTPRequestData parse(const std::string &request_str);
-    static std::size_t getResponseSizeFromCgiHeader(const std::string& cgiResponseStr);
+    // The request whose head was parsed already (see parseHead()), with its body starting at `bodyStart` of `request_str`
+    static HTTPRequestData parse(HTTPRequestData head, const std::string &request_str, std::size_t bodyStart);
+    // Request line and header fields of a request (`head` ends before the empty line), without the body
+    static HTTPRequestData parseHead(const std::string &head);
+    // Split a CGI response into its header fields (lowercased names) and body. False if no empty line ends the headers
+    static bool parseCGIResponse(const std::string &cgiResponseStr, std::unordered_map<std::string, std::string> &headers, std::string &body);
+    // Header fields (lowercased names) of a CGI header block, without the empty line that ends it
+    static std::unordered_map<std::string, std::string> parseCGIHeaders(const std::string &headerBlock);
 };
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#define CGI_BODY_BUFFER_SIZE 65536 // bytes of request body waiting for the script before the client isn't read anymore
+
+/* The body of a request to a CGI script, passed on to the script's stdin while it's still arriving from the client.
+The server appends what it reads from the client and writes it to the pipe once the request has `attach`ed it. The
+buffer is bounded: the server stops polling the client while `isFull()`, so a script that reads slowly holds the
+upload back instead of filling the server's memory. Once the pipe is gone (the script closed its stdin, or the
+request ended), the rest of the body is still read from the client, so the connection can carry the next request,
+but dropped. */
+class CGIBodyStream
+{
+public:
+    // The body has `contentLength` bytes (as announced by the client)
+    explicit CGIBodyStream(std::size_t contentLength);
+
+    // OCF
+    CGIBodyStream() = delete;
+    CGIBodyStream(const CGIBodyStream &other) = delete;
+    CGIBodyStream &operator=(const CGIBodyStream &other) = delete;
+    ~CGIBodyStream() = default;
+
+    // Take bytes read from the client. Returns how many of them belong to the body (the rest is the next request)
+    std::size_t append(const char *data, std::size_t size);
+    // Write the body to the script's stdin `pipeFd` from now on
+    void        attach(int pipeFd);
+    // The pipe is closed: the rest of the body is dropped
+    void        detach();
+
+    [[nodiscard]] std::size_t getContentLength() const;
+    [[nodiscard]] int         getPipeFd() const;
+    // The whole body has arrived from the client
+    [[nodiscard]] bool        isComplete() const;
+
+    // Bytes waiting for the script
+    [[nodiscard]] const char *data() const;
+    [[nodiscard]] std::size_t size() const;
+    void                      consume(std::size_t count);
+    // Complete and everything written: the script's stdin can be closed
+    [[nodiscard]] bool        isDrained() const;
+    // Enough of the body is waiting for the script; the client shouldn't be read until some of it has been written
+    [[nodiscard]] bool        isFull() const;
+
+private:
+    std::size_t _contentLength;
+    std::size_t _received{0};
+    std::string _pending{};
+    std::size_t _pendingSent{0};
+    int         _pipeFd{-1};
+    bool        _detached{false};
+};
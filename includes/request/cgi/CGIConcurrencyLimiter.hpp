@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#define CGI_QUEUE_DEFAULT_SIZE 100  // requests waiting for a CGI slot
+#define CGI_QUEUE_DEFAULT_TIMEOUT 10 // seconds
+#define CGI_RETRY_AFTER_DEFAULT 1    // seconds
+
+/* Caps how many CGI subprocesses run at once, in total (`cgi_max_concurrency` in the global context) and per location
+(`cgi_max_concurrency` in a location). A request beyond the limits waits in a bounded FIFO queue until a running script
+exits; slots are granted as soon as they are released, in order, to the first waiters whose location has room. When the
+queue is full, the request is rejected right away (the server answers 503 with `Retry-After`), and so is a request that
+has waited for `queueTimeout` seconds. Requests are identified by their client's fd. */
+class CGIConcurrencyLimiter
+{
+public:
+    struct Settings
+    {
+        std::size_t maxConcurrency{0}; // Scripts running at once (0 is no global limit)
+        std::size_t queueSize{CGI_QUEUE_DEFAULT_SIZE};
+        long        queueTimeout{CGI_QUEUE_DEFAULT_TIMEOUT};
+        long        retryAfter{CGI_RETRY_AFTER_DEFAULT}; // Seconds a rejected client is told to wait
+    };
+
+    enum Admission
+    {
+        ADMITTED, // The caller holds a slot (to `release()` once the script has exited)
+        QUEUED,   // The caller is woken once it's granted a slot (see `takeGrant()`)
+        REJECTED  // The queue is full
+    };
+
+    struct Stats
+    {
+        std::uint64_t admitted{0};      // Slots taken, right away or after waiting
+        std::uint64_t queued{0};        // Requests that had to wait
+        std::uint64_t rejected{0};      // Requests turned away because the queue was full
+        std::uint64_t timedOut{0};      // Requests turned away after waiting `queueTimeout`
+        std::uint64_t waitCount{0};     // Requests that waited until granted a slot or timed out...
+        double        waitSeconds{0};   // ...the time they waited in total...
+        double        maxWaitSeconds{0}; // ...and at most
+    };
+
+    explicit CGIConcurrencyLimiter(const Settings &settings);
+
+    // OCF
+    CGIConcurrencyLimiter() = delete;
+    CGIConcurrencyLimiter(const CGIConcurrencyLimiter &other) = delete;
+    CGIConcurrencyLimiter &operator=(const CGIConcurrencyLimiter &other) = delete;
+    ~CGIConcurrencyLimiter() = default;
+
+    // Ask for a slot for the request of `clientFd` to run a script of `location`, which allows `locationLimit` at once (0 is no limit)
+    Admission admit(int clientFd, const void *location, std::size_t locationLimit);
+    // Whether the waiting request of `clientFd` has been granted a slot (it then holds it)
+    bool      takeGrant(int clientFd);
+    // The request of `clientFd` stops waiting (it `timedOut`, or it's gone); a slot granted to it is given to the next
+    void      leave(int clientFd, bool timedOut);
+    // A script of `location` has exited: its slot goes to the next waiter that fits
+    void      release(const void *location);
+    // Clients granted a slot since the last call (to be woken)
+    std::vector<int> takeGranted();
+
+    [[nodiscard]] const Settings &getSettings() const;
+    [[nodiscard]] const Stats    &getStats() const;
+    [[nodiscard]] std::size_t     getRunning() const;
+    [[nodiscard]] std::size_t     getQueueDepth() const;
+
+private:
+    struct Waiter
+    {
+        int                                   clientFd;
+        const void                           *location;
+        std::size_t                           locationLimit;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    Settings                                      _settings;
+    Stats                                         _stats{};
+    std::size_t                                   _running{0}; // Slots held or granted
+    std::unordered_map<const void *, std::size_t> _runningPerLocation{};
+    std::deque<Waiter>                            _queue{};
+    std::unordered_map<int, const void *>         _granted{}; // Granted slots not taken yet, by client
+    std::vector<int>                              _toWake{};
+
+    [[nodiscard]] bool hasRoom(const void *location, std::size_t locationLimit) const;
+    void               take(const void *location);
+    // Give the released slots to the waiters that fit, in order
+    void               grantWaiters();
+    // Count the time `waiter` has spent in the queue (it leaves it, with or without a slot)
+    void               recordWait(const Waiter &waiter, std::chrono::steady_clock::time_point now);
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "GzipEncoder.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#define CGI_RELAY_BUFFER_SIZE 65536 // bytes of output waiting for the client before the script's pipe isn't read anymore
+#define CGI_HEADERS_MAX_SIZE 65536  // a longer header block is an invalid response
+
+/* Relays the output of a CGI script to the client while the script is still writing it. The header block is parsed
+once, as it arrives; the request then builds the response head from it and starts the body, which is queued for the
+client as it is (Content-Length given by the script), chunked, or delimited by the end of the connection (HTTP/1.0
+clients), gzipped on the way if that applies. The queue is bounded: the server stops polling the pipe while `isFull()`,
+so a slow client holds the script back instead of filling the server's memory. */
+class CGIResponseRelay
+{
+public:
+    enum Framing
+    {
+        LENGTH,  // Content-Length given by the script
+        CHUNKED, // Transfer-Encoding: chunked
+        CLOSE    // The body ends with the connection
+    };
+
+    explicit CGIResponseRelay(int pipeFd);
+
+    // OCF
+    CGIResponseRelay() = delete;
+    CGIResponseRelay(const CGIResponseRelay &other) = delete;
+    CGIResponseRelay &operator=(const CGIResponseRelay &other) = delete;
+    ~CGIResponseRelay() = default;
+
+    // Take the next piece of the script's output. False if the header block is invalid (too long)
+    bool feed(const char *data, std::size_t size);
+    // The script's output ended (or the pipe was closed on error or timeout)
+    void endOfOutput();
+
+    [[nodiscard]] bool headersComplete() const;
+    // Header fields as sent by the script (names lowercased), once complete
+    [[nodiscard]] const std::unordered_map<std::string, std::string> &getHeaders() const;
+    /* Start relaying the body, output received so far included. `length` is the Content-Length for LENGTH framing (more
+    output is dropped); a `discard`ed body (HEAD, 204, 304) is read but not sent. `gzip` compresses it on the way */
+    void startBody(Framing framing, std::size_t length, bool discard, std::unique_ptr<GzipEncoder> gzip);
+    /* End the body once the script has exited: properly if it `succeeded` and sent everything it announced, otherwise
+    the response is cut off (no last chunk) and the connection closed, so the client can tell it's incomplete */
+    void finish(bool succeeded);
+    // Also keep a copy of the body as the script sends it (before gzip), as long as it's at most `limit` bytes
+    void captureBody(std::size_t limit);
+    // The body kept since `captureBody()`. False if it was longer than the limit or the response was cut off
+    bool takeCapturedBody(std::string &body);
+
+    [[nodiscard]] int  getPipeFd() const;
+    [[nodiscard]] bool hasEndOfOutput() const;
+    [[nodiscard]] bool isFinished() const;
+    // Whether the connection has to be closed after the response (close-delimited or cut off)
+    [[nodiscard]] bool closesConnection() const;
+
+    /* Whether the next bytes of the body can go from the pipe straight to the client with splice(): the body is sent as
+    the script writes it (no gzip, chunks or copy for the cache) and nothing is queued before them */
+    [[nodiscard]] bool        canSplice() const;
+    // Most bytes that may be spliced at once (what's left of the announced length)
+    [[nodiscard]] std::size_t getSpliceLimit() const;
+    // `count` bytes of the body went from the pipe straight to the client
+    void                      spliced(std::size_t count);
+    // The client's socket doesn't take spliced data: the rest of the body is copied
+    void                      disableSplice();
+
+    // Bytes queued for the client
+    [[nodiscard]] const char *data() const;
+    [[nodiscard]] std::size_t size() const;
+    void                      consume(std::size_t count);
+    // Finished and everything sent
+    [[nodiscard]] bool        isDrained() const;
+    // Enough output is waiting for the client; the pipe shouldn't be read until some of it has been sent
+    [[nodiscard]] bool        isFull() const;
+    // Whether the server has stopped polling the pipe because the relay was full
+    [[nodiscard]] bool        isPaused() const;
+    void                      setPaused(bool paused);
+
+private:
+    int                                          _pipeFd;
+    std::string                                  _headerBlock{}; // Output until the end of the header block
+    std::size_t                                  _lineStart{0};  // Start of the header line not yet terminated
+    bool                                         _headersComplete{false};
+    std::unordered_map<std::string, std::string> _headers{};
+    std::string                                  _early{}; // Body output received before `startBody()`
+    bool                                         _started{false};
+    Framing                                      _framing{CHUNKED};
+    std::size_t                                  _remaining{0}; // Body bytes still expected with LENGTH framing
+    bool                                         _discard{false};
+    std::unique_ptr<GzipEncoder>                 _gzip{nullptr};
+    std::string                                  _queue{};
+    std::size_t                                  _queueSent{0};
+    bool                                         _endOfOutput{false};
+    bool                                         _finished{false};
+    bool                                         _cutOff{false};
+    bool                                         _paused{false};
+    bool                                         _spliceDisabled{false};
+    bool                                         _capturing{false};
+    std::size_t                                  _captureLimit{0};
+    std::string                                  _captured{};
+
+    void relayBody(std::string_view body);
+    void queue(std::string_view data);
+};
@@ -5,15 +5,14 @@
 #include <cstring>
 #include <fcntl.h>
 #include <filesystem>
+#include <spawn.h> /* posix_spawn() */
 #include <stdexcept>
+#include <sys/syscall.h> /* SYS_pidfd_open */
 #include <sys/wait.h>
 #include <unistd.h>
 #include <unordered_map>
 #include <vector>
 
-// Global volatile flag to signal shutdown
-extern volatile std::sig_atomic_t g_shutdownServer;
-
 class CGISubprocess
 {
 public:
@@ -30,6 +29,11 @@ public:
     // Closing this pipe becomes the caller's responsibility!
     int getReadPipeFromCGI();
 
+    /* Readable once the child has exited, for poll() (-1 if the kernel has no pidfd_open(); the child is then checked
+    for with waitpid() on every `childHasExited()`). Stays owned by the subprocess */
+    int  getPidFd() const;
+    // Collect the exit status once the pidfd reported the exit (the child doesn't stay a zombie)
+    void collectExitStatus();
     bool childHasExited();
     bool childExitedSuccessfully();
     int  getChildExitStatus();
@@ -44,17 +48,14 @@ private:
     int   _pipe_to_cgi[2]{-1, -1};
     int   _pipe_from_cgi[2]{-1, -1};
     pid_t _pid;
-    int   _status;
+    int   _status{-1};
     bool  _subprocessStarted{false};
+    int   _pidFd{-1};
+    bool  _exited{false}; // `_status` is collected
 
-    // Data to be passed to execve
+    // Environment passed to the script
     std::vector<char *> _envp;
 
     // Helper vector that is the owner of all the `char *` stored in _envp
     std::vector<std::vector<char>> _envStorage;
-
-private:
-    // redirect relevant pipe ends to stdin and stdout, and close the rest
-    void redirectPipesChild();
-    // void setNonBlocking(int fd);
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CGIWorkerPool.hpp"
+#include "UpstreamExchange.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/* One CGI request run by a pooled worker (see `CGIWorkerPool` for the protocol). While every worker is busy, the
+exchange has no fd and waits for the pool to `start()` it with a worker that became free. */
+class CGIWorkerExchange : public UpstreamExchange
+{
+public:
+    CGIWorkerExchange(CGIWorkerPool &pool, std::string interpreter, const std::unordered_map<std::string, std::string> &env,
+                      std::string_view body);
+
+    // OCF
+    CGIWorkerExchange() = delete;
+    CGIWorkerExchange(const CGIWorkerExchange &other) = delete;
+    CGIWorkerExchange &operator=(const CGIWorkerExchange &other) = delete;
+    ~CGIWorkerExchange() override;
+
+    // Called by the pool when it hands a worker to this waiting exchange
+    void start(CGIWorkerPool::Worker *worker);
+
+    [[nodiscard]] int   getFd() const override;
+    [[nodiscard]] short getEvents() const override;
+    void                handleEvents(short revents) override;
+
+    [[nodiscard]] bool isDone() const override;
+    // A script exiting with a non-zero status counts as a failure, like a CGI subprocess would
+    [[nodiscard]] bool hasFailed() const override;
+    [[nodiscard]] bool isGateway() const override;
+    std::string        takeOutput() override;
+    // Give the worker back to the pool (or leave the line)
+    void               releaseConnection() override;
+
+private:
+    CGIWorkerPool         &_pool;
+    std::string            _interpreter;
+    CGIWorkerPool::Worker *_worker{nullptr};
+    bool                   _waiting{false};
+    bool                   _broken{false}; // The worker died or broke the protocol
+    std::string            _request{};
+    std::size_t            _sent{0};
+    std::string            _response{};    // Status, length and output as received
+    bool                   _complete{false};
+    std::uint32_t          _status{0};
+
+    void fail(const std::string &reason);
+    void sendRequest();
+    void receiveResponse();
+};
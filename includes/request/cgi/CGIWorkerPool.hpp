@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/types.h> /* pid_t */
+#include <vector>
+
+#define CGI_POOL_DEFAULT_SIZE 4            // workers per interpreter
+#define CGI_POOL_DEFAULT_MAX_REQUESTS 1000 // requests a worker serves before it's replaced
+
+class CGIWorkerExchange;
+
+/* Long-lived interpreter processes that run CGI scripts without a fork()/exec() and interpreter startup per request.
+Each `cgi_pool` interpreter gets up to `size` workers, started on demand: the interpreter running a worker program that
+reads requests from its stdin and writes responses to its stdout, both one end of a socket pair:
+    request:  u32 length, environment ("NAME=VALUE\0" each), u32 length, body
+    response: u32 exit status, u32 length, the script's stdout (a CGI response)
+(lengths and statuses big-endian). Requests wait in line while all workers are busy. A worker is replaced after
+`maxRequests` requests, and discarded as soon as one of its requests fails or is abandoned. */
+class CGIWorkerPool
+{
+public:
+    struct Settings
+    {
+        std::string worker;                                // Program the interpreter runs to serve requests
+        std::size_t size{CGI_POOL_DEFAULT_SIZE};
+        std::size_t maxRequests{CGI_POOL_DEFAULT_MAX_REQUESTS};
+    };
+
+    struct Worker
+    {
+        pid_t       pid{-1};
+        int         fd{-1}; // The server's end of the socket pair (blocking, used with MSG_DONTWAIT)
+        std::size_t served{0};
+    };
+
+    // Settings per interpreter (as configured with `cgi_handler`)
+    explicit CGIWorkerPool(std::map<std::string, Settings> settings);
+
+    // OCF
+    CGIWorkerPool() = delete;
+    CGIWorkerPool(const CGIWorkerPool &other) = delete;
+    CGIWorkerPool &operator=(const CGIWorkerPool &other) = delete;
+    ~CGIWorkerPool();
+
+    // Whether scripts of `interpreter` are run by workers
+    [[nodiscard]] bool handles(const std::string &interpreter) const;
+    /* An idle worker (started if there is room for one), or nullptr and `exchange` waits in line until a worker is
+    handed to it with `CGIWorkerExchange::start()`. Throws if a worker can't be started */
+    Worker            *acquire(const std::string &interpreter, CGIWorkerExchange *exchange);
+    // Take an exchange out of the line (it's abandoned before it got a worker)
+    void               cancel(const std::string &interpreter, CGIWorkerExchange *exchange);
+    // Give back a worker after a request; it serves the next exchange in line unless it's `broken` or worn out
+    void               release(const std::string &interpreter, Worker *worker, bool broken);
+
+private:
+    struct Group
+    {
+        Settings                             settings;
+        std::vector<std::unique_ptr<Worker>> workers{};
+        std::vector<Worker *>                idle{};
+        std::deque<CGIWorkerExchange *>      waiting{};
+    };
+
+    std::map<std::string, Group> _groups{};
+    std::vector<pid_t>           _exiting{}; // Retired workers that haven't been waited for yet
+
+    Worker *spawn(const std::string &interpreter, Group &group);
+    void    retire(Group &group, Worker *worker);
+    // Whether an idle worker can take a request (checked without blocking before it's handed out)
+    static bool isAlive(const Worker &worker);
+    // Collect retired workers that have exited (without waiting for the others)
+    void    reap();
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/* Encoding and decoding of FastCGI records, as far as a web server talking to a responder needs them
+(https://fastcgi-archives.github.io/FastCGI_Specification.html).
+The static functions encode the records of a request; an instance decodes the records of one response, fed with
+whatever the connection delivered. */
+class FastCGICodec
+{
+public:
+    enum RecordType : std::uint8_t
+    {
+        BEGIN_REQUEST = 1,
+        ABORT_REQUEST = 2,
+        END_REQUEST = 3,
+        PARAMS = 4,
+        STDIN = 5,
+        STDOUT = 6,
+        STDERR = 7
+    };
+
+    enum Status
+    {
+        INCOMPLETE, // More records are needed
+        COMPLETE,   // END_REQUEST arrived
+        FAILED      // Malformed records or the responder refused the request
+    };
+
+    explicit FastCGICodec(std::uint16_t requestId);
+
+    // OCF
+    FastCGICodec() = delete;
+    FastCGICodec(const FastCGICodec &other) = delete;
+    FastCGICodec &operator=(const FastCGICodec &other) = delete;
+    ~FastCGICodec() = default;
+
+    // Append a BEGIN_REQUEST record for the responder role
+    static void appendBeginRequest(std::string &out, std::uint16_t requestId, bool keepConnection);
+    // Append the name-value pairs of the PARAMS stream and the empty record that ends it
+    static void appendParams(std::string &out, std::uint16_t requestId, const std::unordered_map<std::string, std::string> &params);
+    // Append a stream split into records (at most 65535 bytes each) and the empty record that ends it
+    static void appendStream(std::string &out, RecordType type, std::uint16_t requestId, std::string_view data);
+
+    // Decode the records in `data` (which may end in the middle of one)
+    Status feed(const char *data, std::size_t size);
+
+    [[nodiscard]] Status             getStatus() const;
+    [[nodiscard]] std::uint32_t      getAppStatus() const;
+    [[nodiscard]] const std::string &getStderr() const;
+    // What the responder wrote to its stdout: a CGI response (header fields, an empty line and the body)
+    std::string                      takeStdout();
+
+private:
+    std::uint16_t _request_id;
+    Status        _status{INCOMPLETE};
+    std::uint32_t _app_status{0};
+    std::string   _pending{}; // Bytes of a record that hasn't arrived completely
+    std::string   _stdout{};
+    std::string   _stderr{};
+
+    static void appendHeader(std::string &out, RecordType type, std::uint16_t requestId, std::size_t contentLength);
+    static void appendLength(std::string &out, std::size_t length);
+};
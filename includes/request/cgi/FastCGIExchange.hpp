@@ -0,0 +1,55 @@
+#pragma once
+
+#include "FastCGICodec.hpp"
+#include "FastCGIPool.hpp"
+#include "UpstreamExchange.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/* One request to a FastCGI responder over a pooled connection: the encoded request is written and the response records
+are read as poll() reports the connection ready, without blocking the server.
+A request that fails on a reused connection before anything was read is sent again on a new one (the responder may have
+closed it in the meantime), so `getFd()` can change after `handleEvents()`. */
+class FastCGIExchange : public UpstreamExchange
+{
+public:
+    FastCGIExchange(FastCGIPool &pool, std::string address, const std::unordered_map<std::string, std::string> &params,
+                    std::string_view body);
+
+    // OCF
+    FastCGIExchange() = delete;
+    FastCGIExchange(const FastCGIExchange &other) = delete;
+    FastCGIExchange &operator=(const FastCGIExchange &other) = delete;
+    ~FastCGIExchange() override;
+
+    [[nodiscard]] int   getFd() const override;
+    [[nodiscard]] short getEvents() const override;
+    void                handleEvents(short revents) override;
+
+    [[nodiscard]] bool isDone() const override;
+    [[nodiscard]] bool hasFailed() const override;
+    [[nodiscard]] bool isGateway() const override;
+    // The responder's stdout
+    std::string        takeOutput() override;
+    // Hand the connection back to the pool if it can take another request, close it otherwise
+    void               releaseConnection() override;
+
+private:
+    FastCGIPool      &_pool;
+    std::string       _address;
+    int               _fd{-1};
+    bool              _reused{false};     // The connection came from the pool
+    bool              _connecting{false}; // connect() is still in progress
+    bool              _failed{false};
+    bool              _received{false};   // Something was read (the request can't be sent again)
+    std::string       _request{};         // Encoded request records
+    std::size_t       _sent{0};
+    FastCGICodec      _codec;
+
+    void connectUpstream(bool allowIdle);
+    void fail(const std::string &reason);
+    void sendRequest();
+    void receiveResponse();
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <sys/socket.h>
+#include <unordered_map>
+#include <vector>
+
+#define FASTCGI_KEEPALIVE_DEFAULT 8 // idle connections kept per upstream
+
+/* Persistent connections to FastCGI responders, per `fastcgi_pass` address (`unix:/path/to/socket` or `host:port`).
+Connections a request is done with are kept idle (up to `keepalive` per address) and handed to the next request for the
+same address, so responders aren't reconnected to for every request. */
+class FastCGIPool
+{
+public:
+    explicit FastCGIPool(std::size_t keepalive);
+
+    // OCF
+    FastCGIPool() = delete;
+    FastCGIPool(const FastCGIPool &other) = delete;
+    FastCGIPool &operator=(const FastCGIPool &other) = delete;
+    ~FastCGIPool();
+
+    /* A non-blocking socket to `address`: an idle one that is still open if `allowIdle`, else a new one whose connect()
+    may still be in progress. `reused` tells which it is. Throws if no connection could be started */
+    int  acquire(const std::string &address, bool allowIdle, bool &reused);
+    // Give back a connection that is done with its request and can take another one (closed if the pool is full)
+    void release(const std::string &address, int fd);
+
+    [[nodiscard]] std::size_t getIdleCount() const;
+
+private:
+    struct Upstream
+    {
+        sockaddr_storage address{};
+        socklen_t        addressLength{0};
+        std::vector<int> idle{}; // Most recently released last
+    };
+
+    std::size_t                               _keepalive;
+    std::unordered_map<std::string, Upstream> _upstreams{};
+
+    // Resolve `address` once (host names with getaddrinfo()), throws if it can't be
+    Upstream &findUpstream(const std::string &address);
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+/* A request handed to a long-lived process (a FastCGI responder or a pooled CGI worker) over one non-blocking fd,
+making progress whenever poll() reports that fd ready. The request owning the exchange keeps the fd polled. */
+class UpstreamExchange
+{
+public:
+    UpstreamExchange() = default;
+    UpstreamExchange(const UpstreamExchange &other) = delete;
+    UpstreamExchange &operator=(const UpstreamExchange &other) = delete;
+    virtual ~UpstreamExchange() = default;
+
+    // The fd to poll, -1 while the exchange waits for a connection or worker (it may change after `handleEvents()`)
+    [[nodiscard]] virtual int   getFd() const = 0;
+    // Events to poll the fd for
+    [[nodiscard]] virtual short getEvents() const = 0;
+    // Make progress after poll() reported `revents` on the fd
+    virtual void                handleEvents(short revents) = 0;
+
+    // Whether the response is complete or the exchange failed
+    [[nodiscard]] virtual bool isDone() const = 0;
+    [[nodiscard]] virtual bool hasFailed() const = 0;
+    // Whether the other end is a separate server (failures are 502/504) rather than our own script runner (500)
+    [[nodiscard]] virtual bool isGateway() const = 0;
+    // The script's output (a CGI response), once complete
+    virtual std::string        takeOutput() = 0;
+    // Done with the exchange: reuse what it ran on for the next request if possible
+    virtual void               releaseConnection() = 0;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <zlib.h>
+
+/* Incremental gzip compression (zlib deflate with a gzip wrapper). Input can be fed in pieces as it becomes
+available; each call appends whatever compressed output zlib has produced so far to `out` */
+class GzipEncoder
+{
+public:
+    // `level` is zlib's compression level (1 fastest to 9 best). Throws if zlib can't be initialized
+    explicit GzipEncoder(int level);
+
+    // OCF
+    GzipEncoder() = delete;
+    GzipEncoder(const GzipEncoder &other) = delete;
+    GzipEncoder &operator=(const GzipEncoder &other) = delete;
+    ~GzipEncoder();
+
+    // Compress the next part of the input
+    void update(std::string_view in, std::string &out);
+    // Flush everything still buffered and write the gzip trailer. The encoder can't be used afterwards
+    void finish(std::string &out);
+
+    // Compress a complete body in one go
+    static std::string compress(std::string_view in, int level);
+
+private:
+    z_stream _stream{};
+    bool     _finished{false};
+
+    void deflateInto(std::string &out, int flush);
+};
@@ -1,13 +1,56 @@
+#pragma once
+
 #include "utils.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <string>
+#include <string_view>
+#include <sys/types.h> /* off_t */
 #include <unordered_map>
 #include <utility>
+#include <vector>
+
+// Part of a response body that is sent straight from a file (with sendfile()) instead of from memory
+struct FileSegment
+{
+    std::string preamble; // Sent before the file data (e.g., the headers of a multipart/byteranges part)
+    int         fd{-1};   // Not owned
+    off_t       offset{0};
+    std::size_t length{0};
+    const char *mapped{nullptr}; // If set, the file data is written from this shared mapping (at `offset`) instead
+};
 
-/* Converts a given status code, headers map and response body into a properly formatted HTTP/1.1 response
-Automatically adds the "Date", "Server", and "Content-Length" headers, but they can be provided to override default values */
+/* Converts a given status code, headers and response body into a properly formatted HTTP/1.1 response
+Automatically adds the "Date", "Server", and "Content-Length" headers, but they can be provided to override default values.
+Well-known headers are stored in typed slots backed by a small inline buffer, so a typical response doesn't touch the heap
+before it is rendered. Rendering order is deterministic: well-known headers in `Header` order, then the rest as added,
+then raw header lines. */
 class ResponseWriter
 {
 public:
+    // Well-known headers (also the order in which they are rendered)
+    enum Header
+    {
+        DATE,
+        SERVER,
+        CONTENT_TYPE,
+        CONTENT_ENCODING,
+        CONTENT_LENGTH,
+        CONTENT_RANGE,
+        ACCEPT_RANGES,
+        LAST_MODIFIED,
+        ETAG,
+        VARY,
+        CACHE_CONTROL,
+        EXPIRES,
+        LOCATION,
+        HEADER_COUNT
+    };
+
+    using HeaderField = std::pair<std::string_view, std::string_view>;
+
     ResponseWriter() = delete;
     ResponseWriter(const ResponseWriter &src) = delete;
     ResponseWriter(ResponseWriter &&src) = default;
@@ -15,13 +58,59 @@ public:
     ResponseWriter &operator=(ResponseWriter &&src) = delete;
     ~ResponseWriter() = default;
 
-    explicit ResponseWriter(int statusCode, const std::unordered_map<std::string, std::string> &headers, const std::string &response_body);
+    explicit ResponseWriter(int statusCode);
+    explicit ResponseWriter(int statusCode, std::initializer_list<HeaderField> headers, std::string response_body = "");
 
-    void        setBody(const std::string &body);
-    std::string write();
+    // Set a well-known header (replaces a previous value)
+    void setHeader(Header header, std::string_view value);
+    // Set any header by name; well-known names (case-insensitive) end up in their typed slot
+    void addHeader(std::string_view name, std::string_view value);
+    // Append preformatted "Name: value\r\n" lines (rendered after all other headers, as given)
+    void appendRawHeaders(std::string_view lines);
+    void setBody(std::string body);
+    // The body is sent separately, as it's produced: no Content-Length unless one is set
+    void setStreamedBody();
+
+    [[nodiscard]] int                getStatusCode() const;
+    // Value set for a well-known header (empty if it isn't set)
+    [[nodiscard]] std::string_view   getHeader(Header header) const;
+    [[nodiscard]] const std::string &getBody() const;
+
+    // Exact size of the status line and headers (including the empty line that ends them)
+    [[nodiscard]] std::size_t headersSize() const;
+    // Render status line and headers into `buf`. Returns the number of bytes needed; nothing is written if `capacity` is too small
+    std::size_t renderHeaders(char *buf, std::size_t capacity) const;
+    // Append the full response (headers and body) to `out`
+    void        writeTo(std::string &out) const;
+    std::string write() const;
+
+    // Canonical name of a well-known header
+    static std::string_view headerName(Header header);
 
 private:
-    std::string                                  _start_line;
-    std::unordered_map<std::string, std::string> _headers;
-    std::string                                  _response_body;
+    static constexpr std::size_t INLINE_STORAGE = 256;
+
+    // Location of a value: either inside `_inline` or (if it didn't fit) an element of `_spilled`
+    struct Slot
+    {
+        std::uint32_t offset{0};
+        std::uint32_t length{0};
+        bool          isSet{false};
+        bool          isSpilled{false};
+    };
+
+    int                                _status_code;
+    std::array<Slot, HEADER_COUNT>     _known{};
+    std::vector<std::pair<Slot, Slot>> _extra{};
+    std::vector<Slot>                  _raw{};
+    std::array<char, INLINE_STORAGE>   _inline{};
+    std::size_t                        _inline_used{0};
+    std::vector<std::string>           _spilled{};
+    std::string                        _response_body;
+    bool                               _streamed_body{false};
+
+    Slot             store(std::string_view value);
+    std::string_view view(const Slot &slot) const;
+    // Value that will be rendered for a well-known header (defaults for Date/Server/Content-Length)
+    std::string_view renderedValue(Header header, char *scratch, std::size_t scratchSize) const;
 };
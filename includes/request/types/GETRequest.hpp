@@ -14,7 +14,21 @@ public:
     void generateResponse(Server *server, int clientFd) override;
 
 private:
-    void serveFile(const std::filesystem::path &filePath);
+    // `cgiInterpreter` is the CGI handler for the file (nullptr if it's served as it is)
+    void serveFile(const std::filesystem::path &filePath, OpenFileCache::EntryPtr file, const std::string *cgiInterpreter);
+    /* With `gzip_static`/`brotli_static`, pick the precompressed sibling (`<file>.br`/`<file>.gz`) the client prefers
+    according to `Accept-Encoding`. Returns `file` itself if none is acceptable; `varyOnEncoding` is set if any exists */
+    OpenFileCache::EntryPtr selectPrecompressedVariant(const std::filesystem::path &filePath, OpenFileCache::EntryPtr file,
+                                                       std::string_view &contentEncoding, bool &varyOnEncoding);
+    // Serve a regular file with sendfile(), honoring conditional and `Range` headers. Throws if the file can't be opened
+    void serveStaticFile(const std::filesystem::path &filePath, OpenFileCache::EntryPtr file, std::string_view mimeType,
+                         std::string_view contentEncoding, bool varyOnEncoding);
+    // Respond with the server's counters (for locations with `metrics on`)
+    void serveMetrics();
+    // Whether `If-None-Match`/`If-Modified-Since` allow answering with 304 Not Modified
+    bool isNotModified(const std::string &etag, std::time_t lastModified) const;
+    // Whether a `Range` header should be evaluated for a representation with the given validators
+    bool rangeIsApplicable(const std::string &etag, const std::string &lastModified) const;
 
     virtual void continuePrevious() override;
 };
@@ -31,6 +31,23 @@ public:
     std::vector<MultipartPart*> findAllUploadFileParts(std::vector<MultipartPart> &parts);
 
 
+    // What handles a POST request, in the order generateResponse() checks it. The server passes the body on while it
+    // arrives only to `CGI_SUBPROCESS` requests (see Server::streamRequestBody()), so both go by this
+    enum Route
+    {
+        NOT_ALLOWED,  // 405
+        REDIRECT,     // `return`
+        TOO_LARGE,    // 413
+        FASTCGI,
+        OUTSIDE_ROOT, // 403
+        DIRECTORY,    // Its index file decides (a script or an upload)
+        CGI_WORKER,
+        CGI_SUBPROCESS,
+        UPLOAD
+    };
+    static Route route(Server &server, const LocationConfig &location, const ResolutionCache::Entry &resolution,
+                       std::size_t contentLength);
+
     void generateResponse(Server* server, int clientFd) override;
 
     virtual void continuePrevious() override;
@@ -12,7 +12,10 @@ private:
         SERVER,
         CLIENT,
         READFILE,
-        WRITEFILE
+        WRITEFILE,
+        WATCH,   // Filesystem notifications
+        UPSTREAM, // Connections to FastCGI responders
+        PROCESS   // pidfds of CGI subprocesses, readable once they have exited
     };
 
     std::vector<pollfd>                 _pollfds;
@@ -34,6 +37,9 @@ public:
     void                      addClientSocket(int fd);
     void                      addReadFileFd(int fd);
     void                      addWriteFileFd(int fd);
+    void                      addWatchFd(int fd);
+    void                      addUpstreamFd(int fd, short events);
+    void                      addProcessFd(int fd);
     void                      removeSocket(int fd);
     void                      setEvents(int fd, short events);
     void                      updateEvents(int fd, short events);
@@ -45,12 +51,17 @@ public:
     [[nodiscard]] bool isClientSocket(int fd) const;
     [[nodiscard]] bool isReadFileSocket(int fd) const;
     [[nodiscard]] bool isWriteFileSocket(int fd) const;
+    [[nodiscard]] bool isUpstreamSocket(int fd) const;
+    [[nodiscard]] bool isProcessFd(int fd) const;
+    [[nodiscard]] short getRevents(int fd) const;
 
     [[nodiscard]] std::vector<int> getReadableServerSockets() const;
     [[nodiscard]] std::vector<int> getReadableClientSockets() const;
     [[nodiscard]] std::vector<int> getWritableClientSockets() const;
     [[nodiscard]] std::vector<int> getWritableFiles() const;
     [[nodiscard]] std::vector<int> getReadableFiles() const;
+    [[nodiscard]] std::vector<int> getReadyUpstreamSockets() const;
+    [[nodiscard]] std::vector<int> getExitedProcesses() const;
 
     std::vector<pollfd> getPollFDs();
 };
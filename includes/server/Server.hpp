@@ -1,17 +1,35 @@
 #pragma once
 
+#include "CGIBodyStream.hpp"
+#include "CGICache.hpp"
+#include "CGIConcurrencyLimiter.hpp"
+#include "CGIResponseRelay.hpp"
+#include "CGIWorkerPool.hpp"
+#include "ContentCache.hpp"
+#include "DirectoryListingCache.hpp"
+#include "FastCGIPool.hpp"
+#include "FileMappingCache.hpp"
+#include "GzipCache.hpp"
 #include "HTTPRequest.hpp"
 #include "HTTPRequestFactory.hpp"
 #include "HTTPRequestParser.hpp"
+#include "OpenFileCache.hpp"
 #include "PollManager.hpp"
+#include "ResolutionCache.hpp"
+#include "RootIndex.hpp"
 #include "ServerConfig.hpp"
 #include "Socket.hpp"
 #include <chrono>
 #include <csignal>
+#include <filesystem>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <poll.h>
 #include <stdexcept>
+#include <fcntl.h> /* splice() */
+#include <sys/sendfile.h>
+#include <sys/uio.h> /* writev() */
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -20,8 +38,10 @@
 #include <vector>
 
 #define BUFFER_SIZE 4096
+#define CGI_READ_SIZE 16384
 #define CLIENT_TIMEOUT 45 // seconds
 #define FILE_TIMEOUT 30   // seconds
+#define POLL_TICK 1000    // milliseconds poll() waits at most, so timeouts are noticed without any event
 
 // Global volatile flag to signal shutdown
 extern volatile std::sig_atomic_t g_shutdownServer;
@@ -37,8 +57,22 @@ class Socket;
 
 struct PendingResponse
 {
-    std::string response;
-    size_t      sent;
+    std::string                        response;
+    size_t                             sent{0};
+    std::shared_ptr<const std::string> sharedTail{}; // Sent right after `response` (e.g., from the hot cache)
+    std::size_t                        sharedTailSize{0};
+    std::size_t                        sharedTailSent{0};
+    std::vector<FileSegment>           fileSegments{}; // Sent after `response` and `sharedTail`
+    std::size_t                        segmentIndex{0};
+    std::size_t                        segmentSent{0}; // Bytes of the current segment (preamble + file data) already sent
+    std::shared_ptr<CGIResponseRelay>  cgiRelay{};     // Body relayed from a CGI script after `response` (its head)
+    bool                               closeConnection{false};
+
+    [[nodiscard]] bool isComplete() const;
+    // Everything queued has been sent, but the CGI script hasn't finished the body yet
+    [[nodiscard]] bool isWaitingForCGI() const;
+    // Drop what is queued as if it had been sent (the response of a connection without a client)
+    void               discard();
 };
 
 struct OpenFile
@@ -51,13 +85,38 @@ struct OpenFile
     std::string                                        content;
     bool                                               finished{false};
     bool                                               isCGI{false};
+    std::shared_ptr<CGIResponseRelay>                  cgiRelay{}; // Where the output read from a CGI pipe goes
+    std::shared_ptr<CGIBodyStream>                     bodyStream{}; // Where the input written to a CGI pipe comes from
     ReadOrWrite                                        fileType;
     std::size_t                                        size{};
     std::chrono::time_point<std::chrono::steady_clock> lastReadWriteTime;
+    std::filesystem::path                              uploadPath{}; // The file an upload is written to (empty otherwise)
+};
+
+/* The head of the request being received, parsed once as soon as it has arrived: from then on, only the arrival of the
+rest of the request is checked for */
+struct ReceivedHead
+{
+    HTTPRequestData data;
+    std::size_t     bodyStart{0}; // Where the body starts in the received bytes
+    std::size_t     contentLength{0};
+    bool            chunked{false};
+    std::size_t     scanned{0}; // Received bytes already searched for the end of a chunked body
+
+    // Whether all of the request is in `received`
+    [[nodiscard]] bool isComplete(const std::string &received);
 };
 
 struct ClientData
 {
+    /* What the connection waits for. The client is polled for POLLOUT only while RESPONDING, i.e. while there is
+    something to do for it: a request to start or continue, or bytes of the response to send */
+    enum State
+    {
+        IDLE,       // No request (the next one may be arriving)
+        PROCESSING, // The request waits for file, CGI or upstream I/O, whose completion wakes it
+        RESPONDING  // The request can make progress or the response has bytes queued
+    };
     std::string                                        partialRequest{""};
     std::unique_ptr<HTTPRequest>                       parsedRequest{nullptr};
     PendingResponse                                    pendingResponse;
@@ -66,17 +125,39 @@ struct ClientData
     std::string                                        hostName;
     std::string                                        port;
     std::chrono::time_point<std::chrono::steady_clock> lastInteractionTime;
+    std::shared_ptr<CGIBodyStream>                     bodyStream{}; // Body of the current request, still arriving
+    State                                              state{IDLE};
+    std::string                                        cgiCacheRefresh{}; // Key of the CGI cache entry it refreshes
+    std::optional<ReceivedHead>                        receivedHead{}; // Of `partialRequest`, until the request is created
 };
 
 class Server
 {
 private:
     GlobalConfig                                     _global_config;
+    OpenFileCache                                    _openFileCache;
+    ContentCache                                     _contentCache;
+    CGICache                                         _cgiCache;
+    FileMappingCache                                 _fileMappingCache;
+    GzipCache                                        _gzipCache;
+    DirectoryListingCache                            _directoryListingCache;
+    RootIndex                                        _rootIndex;
+    ResolutionCache                                  _resolutionCache;
+    FastCGIPool                                      _fastcgiPool{FASTCGI_KEEPALIVE_DEFAULT}; // Outlives the requests using it
+    CGIWorkerPool                                    _cgiWorkerPool;                          // Same
+    CGIConcurrencyLimiter                            _cgiLimiter;                             // Same
     std::unordered_map<int, std::unique_ptr<Socket>> _sockets;
 
     std::unordered_map<int, const ServerConfig *> _socket_to_server_config;
 
     PollManager                         _pollManager;
+    std::unordered_map<int, int>        _upstreamToClientMap; // FastCGI connections of the clients' requests (outlives them)
+    std::unordered_map<int, int>        _processToClientMap;  // pidfds of the CGI subprocesses of the clients' requests
+    std::unordered_set<int>             _clientsAwaitingUpstream; // Requests waiting in line for a CGI worker
+    bool                                _upstreamReleased{false};  // A worker has been given back since the last wakeup
+    std::unordered_set<int>             _clientsToWake;            // Requests whose I/O completed, see `wakeClient()`
+    std::chrono::steady_clock::time_point _lastTick{};                // Last time the waiting requests were woken
+    int                                 _nextRefreshFd{-2};        // Client-less connections of CGI cache refreshes
     std::unordered_map<int, ClientData> _clientData;
     std::unordered_set<int>             _clientsToRemove;
     std::unordered_set<int>             _filesToRemove;
@@ -85,10 +166,28 @@ private:
     void            acceptNewConnections();
     void            acceptNewConnection(int serverFd);
     void            readFromOpenFiles();
+    // Read the next piece of a CGI script's output into its relay (stops polling the pipe while the relay is full)
+    void            readFromCGI(int fileFd, int clientFd, OpenFile &file);
+    /* Move the next piece of a CGI script's body from its pipe straight to the client with splice(), once everything
+    before it has been sent. False if it has to be read and copied instead (see CGIResponseRelay::canSplice()) */
+    bool            spliceFromCGI(int fileFd, int clientFd, OpenFile &file);
     void            writeToOpenFiles();
-    ClientData     &getClientOfFile(int fileFd);
     void            readFromClients();
     std::string     readFromClientOrFile(int fd, std::string partialContent);
+    // Create the request for what the client has sent once it's complete (or its head, if the body is streamed)
+    void            processPartialRequest(int clientFd);
+    /* Create the request as soon as its head (the client's `receivedHead`) is complete if its body can be passed on to a
+    CGI script while it arrives. False if the request is to be received whole */
+    bool            streamRequestBody(int clientFd);
+    // Pass what was read from the client on to the body stream of its request, and keep the rest for the next request
+    void            consumeBody(int clientFd, const char *data, std::size_t size);
+    // Whether the body of the request is passed on to a CGI script while it arrives instead of buffered first
+    bool            streamsBodyToCGI(const HTTPRequestData &data, const ResolutionCache::Entry &resolution,
+                                     std::size_t &contentLength);
+    // Write what arrived of the request body to the script's stdin (closed once the whole body has been written)
+    void            writeBodyToCGI(int fileFd, int clientFd, OpenFile &file);
+    // Stop passing the body on once its request is done; the rest is read and dropped
+    void            abandonBodyStream(ClientData &client_data);
     void            writeToFile(int fileFd, ClientData &client_data);
     void            respondToClients();
     void            respondToClient(int clientFd);
@@ -96,14 +195,68 @@ private:
     void            closeConnections();
     void            closeDoneFiles();
     void            closeClientFiles(int fd);
-    PendingResponse writeResponseToClient(int clientFd);
+    // Apply filesystem changes reported for the roots to the index and drop what the caches know about them
+    void            processFilesystemEvents();
+    // Let the FastCGI and CGI worker exchanges of the requests make progress
+    void            exchangeWithUpstreams();
+    // Collect the exit status of CGI subprocesses that have exited and wake their requests
+    void            collectExitedProcesses();
+    // Let the requests waiting in line for a CGI worker try again after one has been given back
+    void            wakeUpstreamWaiters();
+    // Let the requests granted a CGI slot since the last wakeup start their scripts
+    void            admitCGIWaiters();
+    // Poll the client for POLLOUT: its request can make progress or its response has bytes to send
+    void            armResponse(int clientFd);
+    // Stop polling the client for POLLOUT until the I/O its request waits for completes
+    void            waitForIO(int clientFd);
+    // Send as much of the pending response as the socket accepts without blocking
+    void            writeResponseToClient(int clientFd);
+    // Queue a response from the hot cache (if there is one for this request) without creating an `HTTPRequest`
+    bool            respondFromContentCache(int clientFd, const HTTPRequestData &data);
 
-    const LocationConfig *findLocationConfig(const std::string &uri, const ServerConfig *server_config) const;
+    const LocationConfig     *findLocationConfig(const std::string &uri, const ServerConfig *server_config) const;
+    // Warm the caches with the files matching `patterns` (URI paths under `root`) as served by `server_config`
+    void                      preloadPatterns(const ServerConfig *server_config, const std::string &root,
+                                              const std::vector<std::string> &patterns, std::size_t &fileCount, std::size_t &byteCount);
+    // Serve `path` once without a client (and once more gzipped, if that applies), so everything it needs gets cached
+    bool                      preloadFile(const ServerConfig *server_config, const std::string &path);
+    // What a request path resolves to on a server, from the resolution cache if it has been resolved before
+    ResolutionCache::EntryPtr resolveRequestPath(const std::string &path, const ServerConfig *server_config);
 
 public: // used by HTTPRequest
     std::unordered_map<int, ClientData> &getClientDataMap();
     std::unordered_map<int, int>        &getOpenFilesToClientMap();
     PollManager                         &getPollManager();
+    OpenFileCache                       &getOpenFileCache();
+    ContentCache                        &getContentCache();
+    CGICache                            &getCGICache();
+    FileMappingCache                    &getFileMappingCache();
+    GzipCache                           &getGzipCache();
+    DirectoryListingCache               &getDirectoryListingCache();
+    RootIndex                           &getRootIndex();
+    ResolutionCache                     &getResolutionCache();
+    FastCGIPool                         &getFastCGIPool();
+    CGIWorkerPool                       &getCGIWorkerPool();
+    CGIConcurrencyLimiter               &getCGILimiter();
+    // Drop what the caches know about a file being written (again once it has been, so no partial version stays cached)
+    void                                 forgetFile(const std::filesystem::path &path);
+    // The server's counters in the Prometheus text format (for locations with `metrics on`)
+    [[nodiscard]] std::string            renderMetrics() const;
+    // Poll the FastCGI connection `fd` for `events` on behalf of the request of `clientFd`
+    void                                 registerUpstream(int fd, int clientFd, short events);
+    void                                 unregisterUpstream(int fd);
+    // Poll the pidfd `fd` of a CGI subprocess of the request of `clientFd` until the subprocess exits
+    void                                 registerProcess(int fd, int clientFd);
+    void                                 unregisterProcess(int fd);
+    // Let the request of `clientFd` continue if it's waiting for I/O (called when some of that I/O completes)
+    void                                 wakeClient(int clientFd);
+    // The request of `clientFd` waits in line for a CGI worker; it's woken once any worker has been given back
+    void                                 awaitUpstream(int clientFd);
+    void                                 releasedUpstream();
+    /* Run the request `data` of `clientFd` again in the background, without a client, to replace the stale CGI cache
+    entry of `key` (see CGICache::startRefresh()) */
+    void                                 refreshCGICache(int clientFd, HTTPRequestData data,
+                                                         ResolutionCache::EntryPtr resolution, const std::string &key);
 
 public:
     Server() = delete;
@@ -114,6 +267,8 @@ public:
     Server &operator=(Server &&src) = delete;
     ~Server();
 
+    // Load the files of every `preload` directive into the caches (before any connection is accepted)
+    void preload();
     void fillPollManager();
     void run();
 };
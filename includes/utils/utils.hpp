@@ -1,17 +1,23 @@
 #pragma once
 
+#include <algorithm> /* std::sort() */
 #include <chrono>
 #include <cmath>
 #include <cstring>
+#include <ctime>
 #include <fcntl.h>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <strings.h>  /* strncasecmp() */
+#include <sys/stat.h> /* struct stat */
 #include <unistd.h>
 #include <vector>
 
@@ -42,8 +48,11 @@ bool firstWordEquals(const std::string &str, const std::string &comparison, std:
 // Check if the string ends with a certain substring
 bool strEndsWith(const std::string &str, const std::string &suffix);
 
-// Returns a pair of strings after spliting the parts before and after '?'
-std::pair<std::string, std::string> splitUriIntoPathAndQuery(const std::string& uri);
+/* Split a request target into its path and (raw) query, dropping any fragment, and make the path canonical in a single
+pass: percent-escapes are decoded, `.` and `..` segments removed and duplicate slashes collapsed. The path is rewritten
+in place, without allocating beyond the raw target. Returns false if the target can't be served (it doesn't start with
+'/', has an invalid or NUL escape, or `..` leaves the root) */
+bool normalizeRequestTarget(const std::string &target, std::string &path, std::string &query);
 
 /*Checks if a given string is a valid HTTP method.
 Assumes the input string is already in lowercase for case-insensitive comparison.
@@ -57,6 +66,29 @@ bool isStandardAddress(const std::string &address);
 // Get current system date and time in HTTP format
 std::string getCurrentGMTString();
 
+// Same as `getCurrentGMTString()`, but formatted at most once per second into a static buffer
+std::string_view getCachedGMTString();
+
+// Format a given time in HTTP format (e.g., "Sun, 06 Nov 1994 08:49:37 GMT")
+std::string formatHTTPDate(std::time_t time);
+
+// Parse a date in HTTP format into `out`. Returns false if the format is invalid
+bool parseHTTPDate(const std::string &str, std::time_t &out);
+
+// Strong entity tag of a file derived from its inode, size and modification time (e.g., "\"1a2b-400-5f3e1c2d\"")
+std::string makeETag(const struct stat &fileStat);
+
+/* Check if an `If-None-Match`/`If-Match`-style list (e.g., `"a", W/"b"` or `*`) contains `etag`.
+With `weak` comparison, the `W/` prefix of the listed tags is ignored; with strong comparison weak tags never match */
+bool etagListMatches(const std::string &list, const std::string &etag, bool weak);
+
+/* Quality (0 to 1000) an `Accept-Encoding` header value gives to a content-coding (e.g., "gzip"), taking `*` into account.
+Names are case-insensitive; 0 means the coding is not acceptable */
+int acceptEncodingQuality(std::string_view acceptEncoding, std::string_view coding);
+
+// Read `size` bytes from the start of a file without moving its offset (the fd may be shared)
+bool readWholeFile(int fd, std::size_t size, std::string &out);
+
 // Return the last modified time of a file in HTTP format
 std::string getLastModTimeHTTP(const std::filesystem::path &filePath);
 
@@ -66,11 +98,41 @@ std::string getLastModTimeHTTP(const std::filesystem::path &filePath);
 // Remove leading forward slash if it exists
 void removeLeadingSlash(std::string &str);
 
+// Lexically normalize `candidate` into `out` if it is `root` or below it. Returns false if it escapes the root
+bool normalizeUnderRoot(const std::filesystem::path &root, const std::filesystem::path &candidate, std::filesystem::path &out);
+
 // Returns a human-readable string form of a site_t bytes value
 std::string bytesToHumanReadable(std::size_t size);
 
+// Parse a time like `90`, `30d` or `1h30m` into seconds (a plain number is in seconds, a leading `-` is allowed).
+// Returns false on syntax error or overflow
+bool parseTimeDuration(std::string_view str, long &out);
+
+// Parse a size like `512`, `64k`, `2M` or `1g` (decimal units, like `client_max_body_size`) into bytes.
+// Returns false on syntax error or overflow
+bool parseByteSize(std::string_view str, std::size_t &out);
+
 // Sets a given fd to non-blocking mode. Throws AND CLOSES fd on error.
 void setNonBlocking(int fd);
 
+// Inclusive range of byte positions
+struct ByteRange
+{
+    std::size_t first;
+    std::size_t last;
+};
+
+// Outcome of evaluating a `Range` header
+enum ByteRangeStatus
+{
+    RANGE_IGNORED,      // Syntactically invalid (or too many ranges); the full representation should be sent
+    RANGE_SATISFIABLE,  // `ranges` holds at least one range, sorted and coalesced
+    RANGE_UNSATISFIABLE // No range overlaps the representation
+};
+
+/* Parse the value of a `Range` header (e.g., "bytes=0-99,-500") for a representation of `size` bytes.
+Overlapping and adjacent ranges are merged. */
+ByteRangeStatus parseByteRanges(const std::string &header, std::size_t size, std::vector<ByteRange> &ranges);
+
 // Returns the standard HTTP reason phrase (as string) for an HTTP status code
-std::string reasonPhraseFromStatusCode(int code);
+std::string_view reasonPhraseFromStatusCode(int code);
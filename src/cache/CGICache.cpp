@@ -0,0 +1,256 @@
+#include "CGICache.hpp"
+
+#include <algorithm> /* std::find(), std::transform() */
+#include <cctype>    /* std::tolower() */
+#include <charconv>  /* std::from_chars() */
+#include <string_view>
+
+namespace
+{
+// Value of a `Cache-Control` directive like `max-age=60` as seconds. False if it isn't a number
+bool parseDeltaSeconds(std::string_view value, long &out)
+{
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+        value = value.substr(1, value.size() - 2);
+    auto [end, error]{std::from_chars(value.data(), value.data() + value.size(), out)};
+    return error == std::errc{} && end == value.data() + value.size() && !value.empty() && out >= 0;
+}
+
+// Whether every field named by a `Vary` value is a key header of the location (`*` never is)
+bool variesOnKeyOnly(const std::string &vary, const CGICache::Settings &settings)
+{
+    std::size_t start{0};
+    while (start <= vary.size())
+    {
+        std::size_t end{vary.find(',', start)};
+        if (end == std::string::npos)
+            end = vary.size();
+        std::string name{vary.substr(start, end - start)};
+        start = end + 1;
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (name.empty())
+            continue;
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (std::find(settings.keyHeaders.begin(), settings.keyHeaders.end(), name) == settings.keyHeaders.end())
+            return false;
+    }
+    return true;
+}
+} // namespace
+
+bool CGICache::Settings::isEnabled() const
+{
+    return valid > 0;
+}
+
+long CGICache::Entry::getAge() const
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - storedAt).count();
+}
+
+CGICache::CGICache(std::size_t capacity, std::size_t maxObject)
+    : _capacity(capacity)
+    , _max_object(maxObject)
+{
+}
+
+bool CGICache::isCacheableRequest(const HTTPRequestData &data)
+{
+    if (data.method != GET && data.method != HEAD)
+        return false;
+    // Responses to authenticated requests are for that user only
+    return data.headers.find("authorization") == data.headers.end();
+}
+
+std::string CGICache::makeKey(const void *server, const HTTPRequestData &data, const Settings &settings)
+{
+    // A HEAD hit is served from the response to GET (without its body), so both are stored as GET
+    std::string key{std::to_string(reinterpret_cast<std::uintptr_t>(server))};
+    key += " GET ";
+    key += data.path;
+    if (!data.query.empty())
+    {
+        key += '?';
+        key += data.query;
+    }
+    for (const auto &name : settings.keyHeaders)
+    {
+        key += '\n';
+        key += name;
+        auto header{data.headers.find(name)};
+        if (header == data.headers.end())
+            continue;
+        key += ": ";
+        key += header->second;
+    }
+    return key;
+}
+
+bool CGICache::getLifetime(int status, const Headers &headers, const Settings &settings, Lifetime &lifetime)
+{
+    // Responses that are complete and reusable by themselves (redirects with a Location of their own included)
+    if (status != 200 && status != 203 && status != 300 && status != 301 && status != 404 && status != 410)
+        return false;
+    if (headers.find("set-cookie") != headers.end())
+        return false;
+    // The entry is shared by every request with the same key, so it may only vary on what the key is made of
+    auto vary{headers.find("vary")};
+    if (vary != headers.end() && !variesOnKeyOnly(vary->second, settings))
+        return false;
+
+    lifetime = {settings.valid, settings.stale};
+    auto cacheControl{headers.find("cache-control")};
+    if (cacheControl == headers.end())
+        return true;
+    std::string value{cacheControl->second};
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::tolower(c); });
+    bool        sharedMaxAge{false};
+    bool        staleGiven{false};
+    std::size_t start{0};
+    while (start <= value.size())
+    {
+        std::size_t end{value.find(',', start)};
+        if (end == std::string::npos)
+            end = value.size();
+        std::string_view directive{value.data() + start, end - start};
+        start = end + 1;
+        while (!directive.empty() && (directive.front() == ' ' || directive.front() == '\t'))
+            directive.remove_prefix(1);
+        while (!directive.empty() && (directive.back() == ' ' || directive.back() == '\t'))
+            directive.remove_suffix(1);
+
+        if (directive == "no-store" || directive == "no-cache" || directive == "private")
+            return false;
+        long seconds{};
+        if (directive.compare(0, 9, "s-maxage=") == 0 && parseDeltaSeconds(directive.substr(9), seconds))
+        {
+            lifetime.fresh = seconds;
+            sharedMaxAge = true;
+        }
+        else if (directive.compare(0, 8, "max-age=") == 0 && !sharedMaxAge && parseDeltaSeconds(directive.substr(8), seconds))
+            lifetime.fresh = seconds;
+        else if (directive.compare(0, 23, "stale-while-revalidate=") == 0 && parseDeltaSeconds(directive.substr(23), seconds))
+        {
+            lifetime.stale = seconds;
+            staleGiven = true;
+        }
+    }
+    // `max-age=0` alone asks for a new response every time
+    return lifetime.fresh > 0 || (staleGiven && lifetime.stale > 0);
+}
+
+bool CGICache::isEnabled() const
+{
+    return _capacity != 0;
+}
+
+std::size_t CGICache::getMaxObject() const
+{
+    return _max_object;
+}
+
+CGICache::EntryPtr CGICache::lookup(const std::string &key, Freshness &freshness)
+{
+    freshness = MISS;
+    auto found{_index.find(key)};
+    if (found == _index.end())
+    {
+        ++_stats.misses;
+        return nullptr;
+    }
+    const auto  now{std::chrono::steady_clock::now()};
+    const Entry &entry{*found->second->second};
+    if (now >= entry.staleUntil)
+    {
+        erase(found->second);
+        ++_stats.misses;
+        return nullptr;
+    }
+    _lru.splice(_lru.begin(), _lru, found->second);
+    if (now < entry.freshUntil)
+    {
+        freshness = FRESH;
+        ++_stats.hits;
+    }
+    else
+    {
+        freshness = STALE;
+        ++_stats.staleHits;
+    }
+    return found->second->second;
+}
+
+void CGICache::store(const std::string &key, Headers headers, std::string body, const Lifetime &lifetime)
+{
+    if (!isEnabled() || body.size() > _max_object)
+        return;
+    auto entry{std::make_shared<Entry>()};
+    // The length is the one of the stored body (which is gzipped for each client that accepts it, or not)
+    headers.erase("content-length");
+    entry->headers = std::move(headers);
+    entry->body = std::move(body);
+    entry->storedAt = std::chrono::steady_clock::now();
+    entry->freshUntil = entry->storedAt + std::chrono::seconds(lifetime.fresh);
+    entry->staleUntil = entry->freshUntil + std::chrono::seconds(lifetime.stale);
+
+    if (footprint(key, *entry) > _capacity)
+        return;
+    auto found{_index.find(key)};
+    if (found != _index.end())
+        erase(found->second);
+
+    _size += footprint(key, *entry);
+    _lru.emplace_front(key, std::move(entry));
+    _index.emplace(key, _lru.begin());
+    ++_stats.stores;
+
+    while (_size > _capacity)
+    {
+        erase(std::prev(_lru.end()));
+        ++_stats.evictions;
+    }
+}
+
+bool CGICache::startRefresh(const std::string &key)
+{
+    if (!_refreshing.insert(key).second)
+        return false;
+    ++_stats.refreshes;
+    return true;
+}
+
+void CGICache::endRefresh(const std::string &key)
+{
+    _refreshing.erase(key);
+}
+
+const CGICache::Stats &CGICache::getStats() const
+{
+    return _stats;
+}
+
+std::size_t CGICache::getSize() const
+{
+    return _size;
+}
+
+std::size_t CGICache::getEntryCount() const
+{
+    return _lru.size();
+}
+
+void CGICache::erase(LRUList::iterator it)
+{
+    _size -= footprint(it->first, *it->second);
+    _index.erase(it->first);
+    _lru.erase(it);
+}
+
+std::size_t CGICache::footprint(const std::string &key, const Entry &entry)
+{
+    std::size_t size{key.size() + entry.body.size() + sizeof(Entry)};
+    for (const auto &[name, value] : entry.headers)
+        size += name.size() + value.size();
+    return size;
+}
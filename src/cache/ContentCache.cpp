@@ -0,0 +1,156 @@
+#include "ContentCache.hpp"
+#include "utils.hpp"
+
+namespace
+{
+constexpr std::string_view FRESH_HEAD_START{"HTTP/1.1 200 OK\r\nDate: "};
+constexpr std::size_t      HTTP_DATE_LENGTH{29}; // e.g., "Sun, 06 Nov 1994 08:49:37 GMT"
+} // namespace
+
+ContentCache::ContentCache(std::size_t capacity, std::size_t maxObject, long valid)
+    : _capacity(capacity)
+    , _max_object(maxObject)
+    , _valid(valid)
+{
+}
+
+bool ContentCache::Key::operator==(const Key &other) const
+{
+    return server == other.server && path == other.path;
+}
+
+std::size_t ContentCache::KeyHash::operator()(const Key &key) const
+{
+    return std::hash<std::string>{}(key.path) ^ std::hash<const void *>{}(key.server);
+}
+
+bool ContentCache::isCacheableRequest(const HTTPRequestData &data)
+{
+    if (data.method != GET && data.method != HEAD)
+        return false;
+    // Conditional and partial requests get responses that depend on more than the path
+    for (const char *header : {"range", "if-range", "if-none-match", "if-modified-since", "if-match", "if-unmodified-since"})
+    {
+        if (data.headers.find(header) != data.headers.end())
+            return false;
+    }
+    return true;
+}
+
+bool ContentCache::admits(std::size_t bodySize) const
+{
+    return isEnabled() && bodySize <= _max_object;
+}
+
+bool ContentCache::isEnabled() const
+{
+    return _capacity != 0;
+}
+
+ContentCache::EntryPtr ContentCache::lookup(const void *server, std::string_view path)
+{
+    auto found{_index.find(Key{server, std::string(path)})};
+    if (found == _index.end())
+    {
+        ++_stats.misses;
+        return nullptr;
+    }
+    if (std::chrono::steady_clock::now() >= found->second->second->validUntil)
+    {
+        erase(found->second);
+        ++_stats.misses;
+        return nullptr;
+    }
+    _lru.splice(_lru.begin(), _lru, found->second);
+    ++_stats.hits;
+    return found->second->second;
+}
+
+void ContentCache::store(const void *server, std::string_view path, const std::string &response, const std::string &file)
+{
+    // Only the Date line has to be rendered again for each hit
+    if (response.compare(0, FRESH_HEAD_START.size(), FRESH_HEAD_START) != 0)
+        return;
+    const std::size_t tailStart{FRESH_HEAD_START.size() + HTTP_DATE_LENGTH + 2};
+    const std::size_t headersEnd{response.find("\r\n\r\n")};
+    if (headersEnd == std::string::npos || headersEnd + 2 < tailStart)
+        return;
+
+    auto entry{std::make_shared<Entry>()};
+    entry->tail = response.substr(tailStart);
+    entry->headersSize = headersEnd + 4 - tailStart;
+    entry->file = file;
+    entry->validUntil = std::chrono::steady_clock::now() + _valid;
+
+    Key key{server, std::string(path)};
+    if (footprint(key, *entry) > _capacity)
+        return;
+    auto found{_index.find(key)};
+    if (found != _index.end())
+        erase(found->second);
+
+    _size += footprint(key, *entry);
+    _lru.emplace_front(key, std::move(entry));
+    _index.emplace(std::move(key), _lru.begin());
+    ++_stats.stores;
+
+    while (_size > _capacity)
+    {
+        erase(std::prev(_lru.end()));
+        ++_stats.evictions;
+    }
+}
+
+void ContentCache::invalidateFile(const std::string &file)
+{
+    // Linear, but files change rarely compared to how often the cache is read
+    for (auto it{_lru.begin()}; it != _lru.end();)
+    {
+        if (it->second->file == file)
+            erase(it++);
+        else
+            ++it;
+    }
+}
+
+void ContentCache::clear()
+{
+    _index.clear();
+    _lru.clear();
+    _size = 0;
+}
+
+void ContentCache::renderFreshHead(std::string &out)
+{
+    out.reserve(out.size() + FRESH_HEAD_START.size() + HTTP_DATE_LENGTH + 2);
+    out.append(FRESH_HEAD_START);
+    out.append(getCachedGMTString());
+    out.append("\r\n");
+}
+
+const ContentCache::Stats &ContentCache::getStats() const
+{
+    return _stats;
+}
+
+std::size_t ContentCache::getSize() const
+{
+    return _size;
+}
+
+std::size_t ContentCache::getEntryCount() const
+{
+    return _lru.size();
+}
+
+void ContentCache::erase(LRUList::iterator it)
+{
+    _size -= footprint(it->first, *it->second);
+    _index.erase(it->first);
+    _lru.erase(it);
+}
+
+std::size_t ContentCache::footprint(const Key &key, const Entry &entry)
+{
+    return key.path.size() + entry.tail.size() + entry.file.size() + sizeof(Entry) + sizeof(Key);
+}
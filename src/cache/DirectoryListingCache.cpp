@@ -0,0 +1,146 @@
+#include "DirectoryListingCache.hpp"
+
+#include <algorithm> /* std::sort() */
+#include <dirent.h>  /* opendir(), readdir(), closedir() */
+#include <fcntl.h>   /* AT_* */
+#include <sys/stat.h>
+
+DirectoryListingCache::DirectoryListingCache(std::size_t max, long valid, std::size_t size)
+    : _max(max)
+    , _valid(valid)
+    , _capacity(size)
+{
+}
+
+DirectoryListingCache::ListingPtr DirectoryListingCache::lookup(const std::string &dirPath)
+{
+    struct stat dirStat;
+    if (stat(dirPath.c_str(), &dirStat) == -1 || !S_ISDIR(dirStat.st_mode))
+    {
+        invalidate(dirPath);
+        return nullptr;
+    }
+
+    auto found{_index.find(dirPath)};
+    if (found != _index.end())
+    {
+        const Listing &listing{*found->second->second};
+        if (listing.mtimeSec == dirStat.st_mtim.tv_sec && listing.mtimeNsec == dirStat.st_mtim.tv_nsec &&
+            std::chrono::steady_clock::now() < listing.validUntil)
+        {
+            _lru.splice(_lru.begin(), _lru, found->second);
+            return found->second->second;
+        }
+        erase(found->second);
+    }
+
+    ListingPtr listing{load(dirPath)};
+    if (listing == nullptr)
+        return nullptr;
+    // The directory may have changed while it was read; the next lookup then sees a newer mtime and reads it again
+    listing->mtimeSec = dirStat.st_mtim.tv_sec;
+    listing->mtimeNsec = dirStat.st_mtim.tv_nsec;
+    if (_max == 0 || _capacity == 0)
+        return listing;
+    listing->footprint = dirPath.size() + sizeof(Listing);
+    for (const Item &item : listing->items)
+        listing->footprint += sizeof(Item) + item.name.size();
+    // A directory too large for the whole cache is read for every request
+    if (listing->footprint > _capacity)
+        return listing;
+    _size += listing->footprint;
+    _lru.emplace_front(dirPath, listing);
+    _index[dirPath] = _lru.begin();
+    evict();
+    return listing;
+}
+
+void DirectoryListingCache::storePage(const std::string &dirPath, const ListingPtr &listing, const std::string &key,
+                                      std::string html)
+{
+    auto found{_index.find(dirPath)};
+    if (found == _index.end() || found->second->second != listing)
+        return;
+    const std::size_t pageSize{key.size() + html.size()};
+    if (listing->footprint + pageSize > _capacity)
+        return;
+    if (!listing->pages.emplace(key, std::move(html)).second)
+        return;
+    listing->footprint += pageSize;
+    _size += pageSize;
+    // The page is of the listing just looked up, which stays
+    _lru.splice(_lru.begin(), _lru, found->second);
+    evict();
+}
+
+void DirectoryListingCache::invalidate(const std::string &dirPath)
+{
+    auto found{_index.find(dirPath)};
+    if (found == _index.end())
+        return;
+    erase(found->second);
+}
+
+void DirectoryListingCache::clear()
+{
+    _index.clear();
+    _lru.clear();
+    _size = 0;
+}
+
+std::size_t DirectoryListingCache::getSize() const
+{
+    return _size;
+}
+
+std::string DirectoryListingCache::pageKey(const std::string &uriPath, std::size_t page)
+{
+    return std::to_string(page) + ' ' + uriPath;
+}
+
+DirectoryListingCache::ListingPtr DirectoryListingCache::load(const std::string &dirPath) const
+{
+    DIR *dir{opendir(dirPath.c_str())};
+    if (dir == nullptr)
+        return nullptr;
+
+    auto listing{std::make_shared<Listing>()};
+    listing->validUntil = std::chrono::steady_clock::now() + _valid;
+    while (const struct dirent *entry = readdir(dir))
+    {
+        std::string name{entry->d_name};
+        if (name == "." || name == "..")
+            continue;
+        bool isDirectory{entry->d_type == DT_DIR};
+        // Symlinks are shown as what they point to; some filesystems don't report types at all
+        if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN)
+        {
+            struct stat entryStat;
+            isDirectory = fstatat(dirfd(dir), entry->d_name, &entryStat, 0) == 0 && S_ISDIR(entryStat.st_mode);
+        }
+        listing->items.push_back({std::move(name), isDirectory});
+    }
+    closedir(dir);
+
+    std::sort(listing->items.begin(), listing->items.end(),
+              [](const Item &a, const Item &b)
+              {
+                  if (a.isDirectory != b.isDirectory)
+                      return a.isDirectory; // directories first
+                  return a.name < b.name;   // then alphabetically
+              });
+    return listing;
+}
+
+void DirectoryListingCache::erase(LRUList::iterator it)
+{
+    _size -= it->second->footprint;
+    _index.erase(it->first);
+    _lru.erase(it);
+}
+
+void DirectoryListingCache::evict()
+{
+    while (_lru.size() > 1 && (_lru.size() > _max || _size > _capacity))
+        erase(std::prev(_lru.end()));
+}
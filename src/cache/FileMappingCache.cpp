@@ -0,0 +1,76 @@
+#include "FileMappingCache.hpp"
+
+#include <sys/mman.h> /* mmap(), madvise(), munmap() */
+
+FileMappingCache::Mapping::~Mapping()
+{
+    if (data != nullptr)
+        munmap(const_cast<char *>(data), size);
+}
+
+FileMappingCache::FileMappingCache(std::size_t capacity, std::size_t minSize, std::size_t maxSize)
+    : _capacity(capacity)
+    , _min_size(minSize)
+    , _max_size(maxSize)
+{
+}
+
+bool FileMappingCache::selects(std::size_t fileSize) const
+{
+    return _capacity != 0 && fileSize > _min_size && fileSize <= _max_size && fileSize <= _capacity;
+}
+
+FileMappingCache::MappingPtr FileMappingCache::map(const OpenFileCache::Entry &file)
+{
+    if (file.fd == -1 || file.size == 0)
+        return nullptr;
+
+    Key  key{file.dev, file.ino};
+    auto found{_index.find(key)};
+    if (found != _index.end())
+    {
+        const Mapping &mapping{*found->second->second};
+        if (mapping.size == file.size && mapping.mtime == file.mtime)
+        {
+            _lru.splice(_lru.begin(), _lru, found->second);
+            return found->second->second;
+        }
+        erase(found->second); // The file has changed since it was mapped
+    }
+
+    void *addr{mmap(nullptr, file.size, PROT_READ, MAP_SHARED, file.fd, 0)};
+    if (addr == MAP_FAILED)
+    {
+        std::cerr << "mmap() failed: " << strerror(errno) << '\n';
+        return nullptr;
+    }
+    // Responses read the mapping front to back, and it's going to be read soon
+    madvise(addr, file.size, MADV_SEQUENTIAL);
+    madvise(addr, file.size, MADV_WILLNEED);
+
+    auto mapping{std::make_shared<Mapping>()};
+    mapping->data = static_cast<const char *>(addr);
+    mapping->size = file.size;
+    mapping->mtime = file.mtime;
+
+    _size += mapping->size;
+    _lru.emplace_front(key, mapping);
+    _index[key] = _lru.begin();
+    while (_size > _capacity)
+        erase(std::prev(_lru.end()));
+    return mapping;
+}
+
+void FileMappingCache::clear()
+{
+    _index.clear();
+    _lru.clear();
+    _size = 0;
+}
+
+void FileMappingCache::erase(LRUList::iterator it)
+{
+    _size -= it->second->size;
+    _index.erase(it->first);
+    _lru.erase(it);
+}
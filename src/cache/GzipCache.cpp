@@ -0,0 +1,72 @@
+#include "GzipCache.hpp"
+
+GzipCache::GzipCache(std::size_t capacity, std::size_t maxObject)
+    : _capacity(capacity)
+    , _max_object(maxObject)
+{
+}
+
+bool GzipCache::admits(std::size_t fileSize) const
+{
+    return fileSize <= _max_object;
+}
+
+GzipCache::BodyPtr GzipCache::get(const std::string &path, const OpenFileCache::Entry &file, int level)
+{
+    if (file.fd == -1 || !admits(file.size))
+        return nullptr;
+
+    BodyPtr cached{lookup(path, file, level)};
+    if (cached != nullptr)
+        return cached;
+
+    std::string content;
+    if (!readWholeFile(file.fd, file.size, content))
+        return nullptr;
+    BodyPtr body{std::make_shared<const std::string>(GzipEncoder::compress(content, level))};
+
+    if (body->size() > _capacity)
+        return body;
+    _size += body->size();
+    _lru.emplace_front(path, Entry{body, file.size, file.mtime, level});
+    _index[path] = _lru.begin();
+    while (_size > _capacity)
+        erase(std::prev(_lru.end()));
+    return body;
+}
+
+GzipCache::BodyPtr GzipCache::lookup(const std::string &path, const OpenFileCache::Entry &file, int level)
+{
+    auto found{_index.find(path)};
+    if (found == _index.end())
+        return nullptr;
+    const Entry &entry{found->second->second};
+    if (entry.size == file.size && entry.mtime == file.mtime && entry.level == level)
+    {
+        _lru.splice(_lru.begin(), _lru, found->second);
+        return entry.body;
+    }
+    erase(found->second); // The file has changed since it was compressed
+    return nullptr;
+}
+
+void GzipCache::invalidate(const std::string &path)
+{
+    auto found{_index.find(path)};
+    if (found != _index.end())
+        erase(found->second);
+}
+
+void GzipCache::clear()
+{
+    _index.clear();
+    _lru.clear();
+    _size = 0;
+}
+
+void GzipCache::erase(LRUList::iterator it)
+{
+    _size -= it->second.body->size();
+    _index.erase(it->first);
+    _lru.erase(it);
+}
@@ -0,0 +1,110 @@
+#include "OpenFileCache.hpp"
+
+OpenFileCache::Entry::~Entry()
+{
+    if (fd != -1)
+        close(fd);
+}
+
+OpenFileCache::OpenFileCache(std::size_t max, long valid)
+    : _max(max)
+    , _valid(valid)
+{
+}
+
+bool OpenFileCache::isEnabled() const
+{
+    return _max != 0;
+}
+
+OpenFileCache::EntryPtr OpenFileCache::lookup(const std::string &path)
+{
+    if (!isEnabled())
+        return load(path);
+
+    auto now{std::chrono::steady_clock::now()};
+    auto found{_index.find(path)};
+    if (found != _index.end())
+    {
+        if (now < found->second->second->validUntil)
+        {
+            _lru.splice(_lru.begin(), _lru, found->second);
+            return found->second->second;
+        }
+        _lru.erase(found->second);
+        _index.erase(found);
+    }
+
+    EntryPtr entry{load(path)};
+    _lru.emplace_front(path, entry);
+    _index[path] = _lru.begin();
+    if (_lru.size() > _max)
+    {
+        _index.erase(_lru.back().first);
+        _lru.pop_back();
+    }
+    return entry;
+}
+
+void OpenFileCache::invalidate(const std::string &path)
+{
+    auto found{_index.find(path)};
+    if (found == _index.end())
+        return;
+    _lru.erase(found->second);
+    _index.erase(found);
+}
+
+void OpenFileCache::clear()
+{
+    _index.clear();
+    _lru.clear();
+}
+
+OpenFileCache::EntryPtr OpenFileCache::load(const std::string &path) const
+{
+    auto entry{std::make_shared<Entry>()};
+    entry->validUntil = std::chrono::steady_clock::now() + _valid;
+
+    // Opening first and then using fstat() is one syscall less than stat() + open() for the common case.
+    // O_NONBLOCK keeps open() from hanging on a FIFO
+    int fd{open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC)};
+    if (fd == -1)
+    {
+        int         openError{errno};
+        struct stat pathStat;
+        if (openError == ENOENT || openError == ENOTDIR || stat(path.c_str(), &pathStat) == -1)
+            return entry; // Doesn't exist (negative entry)
+        entry->exists = true;
+        entry->isDirectory = S_ISDIR(pathStat.st_mode);
+        entry->error = openError;
+        return entry;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == -1)
+    {
+        entry->exists = true;
+        entry->error = errno;
+        close(fd);
+        return entry;
+    }
+    entry->exists = true;
+    if (!S_ISREG(fileStat.st_mode))
+    {
+        entry->isDirectory = S_ISDIR(fileStat.st_mode);
+        entry->error = entry->isDirectory ? EISDIR : EACCES;
+        close(fd);
+        return entry;
+    }
+
+    entry->fd = fd;
+    entry->size = static_cast<std::size_t>(fileStat.st_size);
+    entry->mtime = fileStat.st_mtime;
+    entry->dev = fileStat.st_dev;
+    entry->ino = fileStat.st_ino;
+    entry->lastModified = formatHTTPDate(fileStat.st_mtime);
+    entry->etag = makeETag(fileStat);
+    entry->mimeType = MimeTypes::getMimeType(std::filesystem::path(path).extension().string());
+    return entry;
+}
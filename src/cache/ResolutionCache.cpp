@@ -0,0 +1,103 @@
+#include "ResolutionCache.hpp"
+#include "LocationConfig.hpp"
+#include "utils.hpp"
+
+ResolutionCache::ResolutionCache(std::size_t max, long indexValid)
+    : _max(max)
+    , _index_valid(indexValid)
+{
+}
+
+bool ResolutionCache::Key::operator==(const Key &other) const
+{
+    return server == other.server && path == other.path;
+}
+
+std::size_t ResolutionCache::KeyHash::operator()(const Key &key) const
+{
+    return std::hash<std::string>{}(key.path) ^ std::hash<const void *>{}(key.server);
+}
+
+ResolutionCache::EntryPtr ResolutionCache::lookup(const void *server, const std::string &path)
+{
+    auto found{_index.find(Key{server, path})};
+    if (found == _index.end())
+        return nullptr;
+    _lru.splice(_lru.begin(), _lru, found->second);
+    return found->second->second;
+}
+
+void ResolutionCache::store(const void *server, const std::string &path, EntryPtr entry)
+{
+    if (_max == 0)
+        return;
+
+    Key  key{server, path};
+    auto found{_index.find(key)};
+    if (found != _index.end())
+    {
+        found->second->second = std::move(entry);
+        _lru.splice(_lru.begin(), _lru, found->second);
+        return;
+    }
+    _lru.emplace_front(key, std::move(entry));
+    _index.emplace(std::move(key), _lru.begin());
+    if (_lru.size() > _max)
+    {
+        _index.erase(_lru.back().first);
+        _lru.pop_back();
+    }
+}
+
+void ResolutionCache::clear()
+{
+    _index.clear();
+    _lru.clear();
+}
+
+ResolutionCache::EntryPtr ResolutionCache::resolve(const LocationConfig *location, const std::string &path)
+{
+    auto entry{std::make_shared<Entry>()};
+    entry->location = location;
+    if (location == nullptr)
+        return entry;
+
+    std::string uri{path};
+    removeLeadingSlash(uri);
+    std::filesystem::path normalized;
+    entry->underRoot = normalizeUnderRoot(location->getRoot(), std::filesystem::path(location->getRoot()) / uri, normalized);
+    if (!entry->underRoot)
+        return entry;
+    entry->filePath = normalized.string();
+    entry->cgiInterpreter = findCGIInterpreter(location, entry->filePath);
+    return entry;
+}
+
+bool ResolutionCache::hasIndexFile(const Entry &entry) const
+{
+    return entry.indexGeneration == _index_generation && std::chrono::steady_clock::now() < entry.indexValidUntil;
+}
+
+void ResolutionCache::setIndexFile(Entry &entry, std::string indexFile) const
+{
+    entry.indexCGIInterpreter = indexFile.empty() ? nullptr : findCGIInterpreter(entry.location, indexFile);
+    entry.indexFile = std::move(indexFile);
+    entry.indexGeneration = _index_generation;
+    entry.indexValidUntil = std::chrono::steady_clock::now() + _index_valid;
+}
+
+void ResolutionCache::forgetIndexFiles()
+{
+    ++_index_generation;
+}
+
+const std::string *ResolutionCache::findCGIInterpreter(const LocationConfig *location, const std::string &path)
+{
+    const std::string extension{std::filesystem::path(path).extension().string()};
+    for (const auto &[handledExtension, interpreter] : location->getCGIHandlersMap())
+    {
+        if (extension == handledExtension)
+            return &interpreter;
+    }
+    return nullptr;
+}
@@ -0,0 +1,293 @@
+#include "RootIndex.hpp"
+
+#include <cerrno>
+#include <cstring>  /* strerror() */
+#include <dirent.h> /* opendir(), readdir(), closedir() */
+#include <fcntl.h>  /* AT_SYMLINK_NOFOLLOW */
+#include <filesystem>
+#include <iostream>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h> /* read(), close() */
+
+namespace
+{
+// Everything that changes what exists under a directory or what a file contains
+constexpr uint32_t WATCH_MASK{IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                              IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW};
+
+std::string joinPath(const std::string &dir, const char *name)
+{
+    std::string path{dir};
+    if (path.empty() || path.back() != '/')
+        path += '/';
+    path += name;
+    return path;
+}
+
+bool isUnder(const std::string &path, const std::string &dir)
+{
+    return path.size() > dir.size() && path.compare(0, dir.size(), dir) == 0 && (dir.back() == '/' || path[dir.size()] == '/');
+}
+} // namespace
+
+RootIndex::RootIndex(std::size_t max)
+    : _max(max)
+{
+    if (_max == 0)
+        return;
+    _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_fd == -1)
+        std::cerr << "Root index disabled: inotify_init1() failed: " << strerror(errno) << '\n';
+}
+
+RootIndex::~RootIndex()
+{
+    if (_fd != -1)
+        close(_fd);
+}
+
+void RootIndex::addRoot(const std::string &root)
+{
+    if (_fd == -1)
+        return;
+
+    std::string normalized{std::filesystem::path(root).lexically_normal().string()};
+    while (normalized.size() > 1 && normalized.back() == '/')
+        normalized.pop_back();
+    for (const auto &indexed : _roots)
+    {
+        if (normalized == indexed || isUnder(normalized, indexed))
+            return; // Already covered
+    }
+    _roots.push_back(normalized);
+
+    struct stat rootStat;
+    if (lstat(normalized.c_str(), &rootStat) == -1)
+        return; // Nothing is known about a missing root
+    if (!S_ISDIR(rootStat.st_mode))
+        _nodes[normalized] = KIND_OTHER;
+    else
+        indexDirectory(normalized);
+}
+
+RootIndex::State RootIndex::lookup(const std::string &path) const
+{
+    if (_fd == -1)
+        return UNKNOWN;
+
+    std::string key{path};
+    while (key.size() > 1 && key.back() == '/')
+        key.pop_back();
+    auto found{_nodes.find(key)};
+    if (found != _nodes.end())
+    {
+        if (found->second == KIND_FILE)
+            return FILE;
+        return found->second == KIND_DIRECTORY ? DIRECTORY : UNKNOWN;
+    }
+
+    // Not indexed: missing if the closest indexed ancestor is a directory whose contents are known (or a file)
+    while (true)
+    {
+        std::size_t slash{key.rfind('/')};
+        if (slash == std::string::npos || slash == 0)
+            return UNKNOWN;
+        key.resize(slash);
+        found = _nodes.find(key);
+        if (found != _nodes.end())
+            return found->second == KIND_OTHER ? UNKNOWN : MISSING;
+    }
+}
+
+std::size_t RootIndex::getPathCount() const
+{
+    return _nodes.size();
+}
+
+int RootIndex::getFd() const
+{
+    return _fd;
+}
+
+bool RootIndex::isEnabled() const
+{
+    return _fd != -1;
+}
+
+bool RootIndex::processEvents(std::vector<std::string> &changed)
+{
+    alignas(struct inotify_event) char buf[16384];
+    bool                               complete{true};
+
+    while (_fd != -1)
+    {
+        ssize_t length{read(_fd, buf, sizeof(buf))};
+        if (length <= 0)
+            break; // EAGAIN: all pending events were read
+
+        for (char *pos{buf}; pos < buf + length && _fd != -1;)
+        {
+            const auto *event{reinterpret_cast<const struct inotify_event *>(pos)};
+            pos += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                complete = false;
+                continue;
+            }
+            auto watched{_watchedDirs.find(event->wd)};
+            if (watched == _watchedDirs.end())
+                continue;
+            if (event->mask & IN_IGNORED)
+            {
+                _watchedDirs.erase(watched);
+                continue;
+            }
+
+            const std::string dir{watched->second};
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+            {
+                // Only matters for roots; anything below is also reported by its parent
+                removePath(dir);
+                changed.push_back(dir);
+                continue;
+            }
+            if (event->len == 0)
+                continue;
+
+            std::string path{joinPath(dir, event->name)};
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                addPath(path);
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                removePath(path);
+            changed.push_back(std::move(path));
+        }
+    }
+
+    if (!complete && _fd != -1)
+    {
+        std::cerr << "Root index: inotify queue overflowed, rebuilding the index" << '\n';
+        rebuild();
+    }
+    return complete;
+}
+
+void RootIndex::indexDirectory(const std::string &dirPath)
+{
+    std::vector<std::string> pending{dirPath};
+    _nodes[dirPath] = KIND_DIRECTORY;
+
+    while (!pending.empty() && _fd != -1)
+    {
+        std::string dirName{std::move(pending.back())};
+        pending.pop_back();
+
+        // Watch before reading, so nothing created in between goes unnoticed
+        int wd{inotify_add_watch(_fd, dirName.c_str(), WATCH_MASK)};
+        if (wd == -1)
+        {
+            if (errno == ENOSPC)
+                return disable("the inotify watch limit was reached");
+            _nodes[dirName] = KIND_OTHER;
+            continue;
+        }
+        _watchedDirs[wd] = dirName;
+
+        DIR *dir{opendir(dirName.c_str())};
+        if (dir == nullptr)
+        {
+            _nodes[dirName] = KIND_OTHER; // e.g., no permission to list it
+            continue;
+        }
+        while (const struct dirent *entry = readdir(dir))
+        {
+            if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0)
+                continue;
+            std::string path{joinPath(dirName, entry->d_name)};
+            Kind        kind{KIND_OTHER};
+            if (entry->d_type == DT_DIR)
+                kind = KIND_DIRECTORY;
+            else if (entry->d_type == DT_REG)
+                kind = KIND_FILE;
+            else if (entry->d_type == DT_UNKNOWN)
+            {
+                struct stat entryStat;
+                if (fstatat(dirfd(dir), entry->d_name, &entryStat, AT_SYMLINK_NOFOLLOW) == 0)
+                    kind = S_ISDIR(entryStat.st_mode) ? KIND_DIRECTORY : S_ISREG(entryStat.st_mode) ? KIND_FILE : KIND_OTHER;
+            }
+            if (kind == KIND_DIRECTORY)
+                pending.push_back(path);
+            _nodes[std::move(path)] = kind;
+        }
+        closedir(dir);
+
+        if (_nodes.size() > _max)
+            return disable("the roots hold more than " + std::to_string(_max) + " paths");
+    }
+}
+
+void RootIndex::addPath(const std::string &path)
+{
+    struct stat pathStat;
+    if (lstat(path.c_str(), &pathStat) == -1)
+        return removePath(path); // Already gone again
+
+    if (S_ISDIR(pathStat.st_mode))
+        return indexDirectory(path);
+    _nodes[path] = S_ISREG(pathStat.st_mode) ? KIND_FILE : KIND_OTHER;
+    if (_nodes.size() > _max)
+        disable("the roots hold more than " + std::to_string(_max) + " paths");
+}
+
+void RootIndex::removePath(const std::string &path)
+{
+    auto found{_nodes.find(path)};
+    if (found == _nodes.end())
+        return;
+    const bool isDirectory{found->second != KIND_FILE};
+    _nodes.erase(found);
+    if (!isDirectory)
+        return;
+
+    // A removed or moved away directory takes its whole subtree (and the watches on it) along
+    for (auto it{_nodes.begin()}; it != _nodes.end();)
+    {
+        if (isUnder(it->first, path))
+            it = _nodes.erase(it);
+        else
+            ++it;
+    }
+    for (auto it{_watchedDirs.begin()}; it != _watchedDirs.end();)
+    {
+        if (it->second == path || isUnder(it->second, path))
+        {
+            inotify_rm_watch(_fd, it->first);
+            it = _watchedDirs.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+void RootIndex::rebuild()
+{
+    for (const auto &[wd, _] : _watchedDirs)
+        inotify_rm_watch(_fd, wd);
+    _watchedDirs.clear();
+    _nodes.clear();
+
+    std::vector<std::string> roots{std::move(_roots)};
+    _roots.clear();
+    for (const auto &root : roots)
+        addRoot(root);
+}
+
+void RootIndex::disable(const std::string &reason)
+{
+    std::cerr << "Root index disabled: " << reason << '\n';
+    close(_fd); // Drops all watches
+    _fd = -1;
+    _watchedDirs.clear();
+    _nodes.clear();
+}
@@ -48,6 +48,106 @@ const std::vector<std::unique_ptr<ServerConfig>> &GlobalConfig::getServerConfigs
     return _serverConfigs;
 }
 
+std::size_t GlobalConfig::getOpenFileCacheMax() const
+{
+    return _open_file_cache_max;
+}
+
+long GlobalConfig::getOpenFileCacheValid() const
+{
+    return _open_file_cache_valid;
+}
+
+std::size_t GlobalConfig::getHotCacheSize() const
+{
+    return _hot_cache_size;
+}
+
+std::size_t GlobalConfig::getHotCacheMaxObject() const
+{
+    return _hot_cache_max_object;
+}
+
+long GlobalConfig::getHotCacheValid() const
+{
+    return _hot_cache_valid;
+}
+
+bool GlobalConfig::getHotCacheStats() const
+{
+    return _hot_cache_stats;
+}
+
+std::size_t GlobalConfig::getCGICacheSize() const
+{
+    return _cgi_cache_size;
+}
+
+std::size_t GlobalConfig::getCGICacheMaxObject() const
+{
+    return _cgi_cache_max_object;
+}
+
+std::size_t GlobalConfig::getMmapCacheSize() const
+{
+    return _mmap_cache_size;
+}
+
+std::size_t GlobalConfig::getMmapCacheMin() const
+{
+    return _mmap_cache_min;
+}
+
+std::size_t GlobalConfig::getMmapCacheMax() const
+{
+    return _mmap_cache_max;
+}
+
+std::size_t GlobalConfig::getGzipCacheSize() const
+{
+    return _gzip_cache_size;
+}
+
+std::size_t GlobalConfig::getGzipCacheMaxObject() const
+{
+    return _gzip_cache_max_object;
+}
+
+std::size_t GlobalConfig::getAutoIndexCacheMax() const
+{
+    return _autoindex_cache_max;
+}
+
+long GlobalConfig::getAutoIndexCacheValid() const
+{
+    return _autoindex_cache_valid;
+}
+
+std::size_t GlobalConfig::getAutoIndexCacheSize() const
+{
+    return _autoindex_cache_size;
+}
+
+std::size_t GlobalConfig::getRootIndexMax() const
+{
+    return _root_index_max;
+}
+
+std::size_t GlobalConfig::getResolutionCacheMax() const
+{
+    return _resolution_cache_max;
+}
+
+const std::map<std::string, CGIWorkerPool::Settings> &GlobalConfig::getCGIPools() const
+{
+    return _cgi_pools;
+}
+
+const CGIConcurrencyLimiter::Settings &GlobalConfig::getCGIConcurrency() const
+{
+    return _cgi_concurrency;
+}
+
 /* Parsing logic */
 
 void GlobalConfig::parseConfFile(std::ifstream &file_stream)
@@ -111,22 +211,39 @@ void GlobalConfig::setConfigurationValue(std::string directive)
 
     std::string server{"server"};
     std::string root{"root"};
+    std::string root_index{"root_index"};
     std::string client_max_body_size{"client_max_body_size"};
     std::string autoindex{"autoindex"};
+    std::string autoindex_cache{"autoindex_cache"};
     std::string error_page{"error_page"};
     std::string index{"index"};
+    std::string open_file_cache{"open_file_cache"};
+    std::string hot_cache{"hot_cache"};
+    std::string hot_cache_stats{"hot_cache_stats"};
+    std::string mmap_cache{"mmap_cache"};
+    std::string gzip_cache{"gzip_cache"};
+    std::string resolution_cache{"resolution_cache"};
+    std::string cgi_pool{"cgi_pool"};
+    std::string cgi_cache_zone{"cgi_cache_zone"};
+    std::string cgi_max_concurrency{"cgi_max_concurrency"};
 
     std::size_t nextWordPos;
 
     // Set server config (just save strings for now)
     if (firstWordEquals(directive, server, &nextWordPos))
         _serverConfigsStr.push_back(directive.substr(nextWordPos));
+    // Set root index on or off (checked before `root`, which is its prefix)
+    else if (firstWordEquals(directive, root_index, &nextWordPos))
+        setRootIndex(directive.substr(nextWordPos));
     // Set root
     else if (firstWordEquals(directive, root, &nextWordPos))
         setRoot(directive.substr(nextWordPos));
     // Set client_max_body_size
     else if (firstWordEquals(directive, client_max_body_size, &nextWordPos))
         setClientMaxBodySize(directive.substr(nextWordPos));
+    // Set directory listing cache size and validity (checked before `autoindex`, which is its prefix)
+    else if (firstWordEquals(directive, autoindex_cache, &nextWordPos))
+        setAutoIndexCache(directive.substr(nextWordPos));
     // Set autoindex on or off
     else if (firstWordEquals(directive, autoindex, &nextWordPos))
         setAutoIndex(directive.substr(nextWordPos));
@@ -136,6 +253,33 @@ void GlobalConfig::setConfigurationValue(std::string directive)
     // Set index files
     else if (firstWordEquals(directive, index, &nextWordPos))
         setIndex(directive.substr(nextWordPos));
+    // Set open file cache size and validity
+    else if (firstWordEquals(directive, open_file_cache, &nextWordPos))
+        setOpenFileCache(directive.substr(nextWordPos));
+    // Set hot cache statistics on or off (checked before `hot_cache`, which is its prefix)
+    else if (firstWordEquals(directive, hot_cache_stats, &nextWordPos))
+        setHotCacheStats(directive.substr(nextWordPos));
+    // Set hot (complete response) cache size, maximum object size and validity
+    else if (firstWordEquals(directive, hot_cache, &nextWordPos))
+        setHotCache(directive.substr(nextWordPos));
+    // Set size of the shared file mappings and which files use them
+    else if (firstWordEquals(directive, mmap_cache, &nextWordPos))
+        setMmapCache(directive.substr(nextWordPos));
+    // Set size of the compressed static file cache and the largest file compressed on the fly
+    else if (firstWordEquals(directive, gzip_cache, &nextWordPos))
+        setGzipCache(directive.substr(nextWordPos));
+    // Set how many request path resolutions are remembered
+    else if (firstWordEquals(directive, resolution_cache, &nextWordPos))
+        setResolutionCache(directive.substr(nextWordPos));
+    // Set size of the CGI output cache and the largest body stored in it
+    else if (firstWordEquals(directive, cgi_cache_zone, &nextWordPos))
+        setCGICacheZone(directive.substr(nextWordPos));
+    // Set a pool of CGI workers for an interpreter
+    else if (firstWordEquals(directive, cgi_pool, &nextWordPos))
+        setCGIPool(directive.substr(nextWordPos));
+    // Set how many CGI subprocesses run at once and the queue of the requests waiting for them
+    else if (firstWordEquals(directive, cgi_max_concurrency, &nextWordPos))
+        setCGIMaxConcurrency(directive.substr(nextWordPos));
     else
         throw std::runtime_error("Config file syntax error: Disallowed directive in global context: " + directive);
 }
@@ -282,3 +426,438 @@ void GlobalConfig::setIndex(std::string directive)
         _index_files_vec.push_back(elem);
     }
 }
+
+void GlobalConfig::setOpenFileCache(std::string directive)
+{
+    if (_seen_open_file_cache)
+        throw std::runtime_error("Config file syntax error: 'open_file_cache' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.empty() || args.size() > 2)
+        throw std::runtime_error("Config file syntax error: 'open_file_cache' directive invalid number of arguments: " + directive);
+
+    _seen_open_file_cache = true;
+    if (args.size() == 1 && args[0] == "off")
+    {
+        _open_file_cache_max = 0;
+        return;
+    }
+
+    // `max=N [valid=time]`
+    if (args[0].compare(0, 4, "max=") != 0)
+        throw std::runtime_error("Config file syntax error: 'open_file_cache' directive first argument should be "
+                                 "'max=N' or 'off': " +
+                                 directive);
+    std::size_t remainingPos;
+    try
+    {
+        _open_file_cache_max = std::stoul(args[0].substr(4), &remainingPos);
+    }
+    catch (const std::exception &)
+    {
+        throw std::runtime_error("Config file syntax error: Invalid 'open_file_cache' directive value: " + directive);
+    }
+    if (remainingPos != args[0].length() - 4 || _open_file_cache_max == 0)
+        throw std::runtime_error("Config file syntax error: Invalid 'open_file_cache' directive value: " + directive);
+
+    if (args.size() == 2)
+    {
+        if (args[1].compare(0, 6, "valid=") != 0 || !parseTimeDuration(args[1].substr(6), _open_file_cache_valid) ||
+            _open_file_cache_valid < 0)
+            throw std::runtime_error("Config file syntax error: Invalid 'open_file_cache' directive value: " + directive);
+    }
+}
+
+void GlobalConfig::setHotCache(std::string directive)
+{
+    if (_seen_hot_cache)
+        throw std::runtime_error("Config file syntax error: 'hot_cache' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.empty() || args.size() > 3)
+        throw std::runtime_error("Config file syntax error: 'hot_cache' directive invalid number of arguments: " + directive);
+
+    _seen_hot_cache = true;
+    if (args.size() == 1 && args[0] == "off")
+    {
+        _hot_cache_size = 0;
+        return;
+    }
+
+    // `size=N [max_object=N] [valid=time]`
+    if (args[0].compare(0, 5, "size=") != 0 || !parseByteSize(args[0].substr(5), _hot_cache_size) || _hot_cache_size == 0)
+        throw std::runtime_error("Config file syntax error: 'hot_cache' directive first argument should be 'size=N' or "
+                                 "'off': " +
+                                 directive);
+    for (std::size_t i{1}; i < args.size(); ++i)
+    {
+        bool valid;
+        if (args[i].compare(0, 11, "max_object=") == 0)
+            valid = parseByteSize(args[i].substr(11), _hot_cache_max_object);
+        else if (args[i].compare(0, 6, "valid=") == 0)
+            valid = parseTimeDuration(args[i].substr(6), _hot_cache_valid) && _hot_cache_valid >= 0;
+        else
+            valid = false;
+        if (!valid)
+            throw std::runtime_error("Config file syntax error: Invalid 'hot_cache' directive value: " + directive);
+    }
+}
+
+void GlobalConfig::setHotCacheStats(std::string directive)
+{
+    if (_seen_hot_cache_stats)
+        throw std::runtime_error("Config file syntax error: 'hot_cache_stats' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+    trimOuterSpacesAndQuotes(directive);
+    // Convert string to lowercase
+    std::transform(directive.begin(), directive.end(), directive.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    if (directive == "on")
+        _hot_cache_stats = true;
+    else if (directive == "off")
+        _hot_cache_stats = false;
+    else
+        throw std::runtime_error("Config file syntax error: Invalid 'hot_cache_stats' directive value: " + directive);
+    _seen_hot_cache_stats = true;
+}
+
+void GlobalConfig::setCGICacheZone(std::string directive)
+{
+    if (_seen_cgi_cache_zone)
+        throw std::runtime_error("Config file syntax error: 'cgi_cache_zone' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.empty() || args.size() > 2)
+        throw std::runtime_error("Config file syntax error: 'cgi_cache_zone' directive invalid number of arguments: " +
+                                 directive);
+
+    _seen_cgi_cache_zone = true;
+    if (args.size() == 1 && args[0] == "off")
+    {
+        _cgi_cache_size = 0;
+        return;
+    }
+
+    // `size=N [max_object=N]`
+    if (args[0].compare(0, 5, "size=") != 0 || !parseByteSize(args[0].substr(5), _cgi_cache_size) || _cgi_cache_size == 0)
+        throw std::runtime_error("Config file syntax error: 'cgi_cache_zone' directive first argument should be 'size=N' "
+                                 "or 'off': " +
+                                 directive);
+    if (args.size() == 2 &&
+        (args[1].compare(0, 11, "max_object=") != 0 || !parseByteSize(args[1].substr(11), _cgi_cache_max_object)))
+        throw std::runtime_error("Config file syntax error: Invalid 'cgi_cache_zone' directive value: " + directive);
+}
+
+void GlobalConfig::setMmapCache(std::string directive)
+{
+    if (_seen_mmap_cache)
+        throw std::runtime_error("Config file syntax error: 'mmap_cache' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.empty() || args.size() > 3)
+        throw std::runtime_error("Config file syntax error: 'mmap_cache' directive invalid number of arguments: " + directive);
+
+    _seen_mmap_cache = true;
+    if (args.size() == 1 && args[0] == "off")
+    {
+        _mmap_cache_size = 0;
+        return;
+    }
+
+    // `size=N [min=N] [max=N]`
+    if (args[0].compare(0, 5, "size=") != 0 || !parseByteSize(args[0].substr(5), _mmap_cache_size) || _mmap_cache_size == 0)
+        throw std::runtime_error("Config file syntax error: 'mmap_cache' directive first argument should be 'size=N' "
+                                 "or 'off': " +
+                                 directive);
+    for (std::size_t i{1}; i < args.size(); ++i)
+    {
+        bool valid;
+        if (args[i].compare(0, 4, "min=") == 0)
+            valid = parseByteSize(args[i].substr(4), _mmap_cache_min);
+        else if (args[i].compare(0, 4, "max=") == 0)
+            valid = parseByteSize(args[i].substr(4), _mmap_cache_max);
+        else
+            valid = false;
+        if (!valid)
+            throw std::runtime_error("Config file syntax error: Invalid 'mmap_cache' directive value: " + directive);
+    }
+    if (_mmap_cache_min >= _mmap_cache_max)
+        throw std::runtime_error("Config file syntax error: 'mmap_cache' directive 'min' should be less than 'max': " + directive);
+}
+
+void GlobalConfig::setGzipCache(std::string directive)
+{
+    if (_seen_gzip_cache)
+        throw std::runtime_error("Config file syntax error: 'gzip_cache' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.empty() || args.size() > 2)
+        throw std::runtime_error("Config file syntax error: 'gzip_cache' directive invalid number of arguments: " + directive);
+
+    _seen_gzip_cache = true;
+    if (args.size() == 1 && args[0] == "off")
+    {
+        _gzip_cache_size = 0;
+        return;
+    }
+
+    // `size=N [max_object=N]`
+    if (args[0].compare(0, 5, "size=") != 0 || !parseByteSize(args[0].substr(5), _gzip_cache_size) || _gzip_cache_size == 0)
+        throw std::runtime_error("Config file syntax error: 'gzip_cache' directive first argument should be 'size=N' "
+                                 "or 'off': " +
+                                 directive);
+    if (args.size() == 2 &&
+        (args[1].compare(0, 11, "max_object=") != 0 || !parseByteSize(args[1].substr(11), _gzip_cache_max_object)))
+        throw std::runtime_error("Config file syntax error: Invalid 'gzip_cache' directive value: " + directive);
+}
+
+void GlobalConfig::setAutoIndexCache(std::string directive)
+{
+    if (_seen_autoindex_cache)
+        throw std::runtime_error("Config file syntax error: 'autoindex_cache' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.empty() || args.size() > 3)
+        throw std::runtime_error("Config file syntax error: 'autoindex_cache' directive invalid number of arguments: " + directive);
+
+    _seen_autoindex_cache = true;
+    if (args.size() == 1 && args[0] == "off")
+    {
+        _autoindex_cache_max = 0;
+        return;
+    }
+
+    // `max=N [valid=time] [size=N]`
+    if (args[0].compare(0, 4, "max=") != 0)
+        throw std::runtime_error("Config file syntax error: 'autoindex_cache' directive first argument should be "
+                                 "'max=N' or 'off': " +
+                                 directive);
+    std::size_t remainingPos;
+    try
+    {
+        _autoindex_cache_max = std::stoul(args[0].substr(4), &remainingPos);
+    }
+    catch (const std::exception &)
+    {
+        throw std::runtime_error("Config file syntax error: Invalid 'autoindex_cache' directive value: " + directive);
+    }
+    if (remainingPos != args[0].length() - 4 || _autoindex_cache_max == 0)
+        throw std::runtime_error("Config file syntax error: Invalid 'autoindex_cache' directive value: " + directive);
+
+    for (std::size_t i{1}; i < args.size(); ++i)
+    {
+        bool valid{false};
+        if (args[i].compare(0, 6, "valid=") == 0)
+            valid = parseTimeDuration(args[i].substr(6), _autoindex_cache_valid) && _autoindex_cache_valid >= 0;
+        else if (args[i].compare(0, 5, "size=") == 0)
+            valid = parseByteSize(args[i].substr(5), _autoindex_cache_size) && _autoindex_cache_size != 0;
+        if (!valid)
+            throw std::runtime_error("Config file syntax error: Invalid 'autoindex_cache' directive value: " + directive);
+    }
+}
+
+void GlobalConfig::setRootIndex(std::string directive)
+{
+    if (_seen_root_index)
+        throw std::runtime_error("Config file syntax error: 'root_index' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.size() != 1)
+        throw std::runtime_error("Config file syntax error: 'root_index' directive invalid number of arguments: " + directive);
+
+    _seen_root_index = true;
+    if (args[0] == "off")
+    {
+        _root_index_max = 0;
+        return;
+    }
+    if (args[0] == "on")
+    {
+        _root_index_max = ROOT_INDEX_DEFAULT_MAX;
+        return;
+    }
+
+    // `max=N`
+    if (args[0].compare(0, 4, "max=") != 0)
+        throw std::runtime_error("Config file syntax error: 'root_index' directive argument should be 'on', 'off' or "
+                                 "'max=N': " +
+                                 directive);
+    std::size_t remainingPos;
+    try
+    {
+        _root_index_max = std::stoul(args[0].substr(4), &remainingPos);
+    }
+    catch (const std::exception &)
+    {
+        throw std::runtime_error("Config file syntax error: Invalid 'root_index' directive value: " + directive);
+    }
+    if (remainingPos != args[0].length() - 4 || _root_index_max == 0)
+        throw std::runtime_error("Config file syntax error: Invalid 'root_index' directive value: " + directive);
+}
+
+void GlobalConfig::setResolutionCache(std::string directive)
+{
+    if (_seen_resolution_cache)
+        throw std::runtime_error("Config file syntax error: 'resolution_cache' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.size() != 1)
+        throw std::runtime_error("Config file syntax error: 'resolution_cache' directive invalid number of arguments: " +
+                                 directive);
+
+    _seen_resolution_cache = true;
+    if (args[0] == "off")
+    {
+        _resolution_cache_max = 0;
+        return;
+    }
+
+    // `max=N`
+    if (args[0].compare(0, 4, "max=") != 0)
+        throw std::runtime_error("Config file syntax error: 'resolution_cache' directive argument should be 'max=N' or "
+                                 "'off': " +
+                                 directive);
+    std::size_t remainingPos;
+    try
+    {
+        _resolution_cache_max = std::stoul(args[0].substr(4), &remainingPos);
+    }
+    catch (const std::exception &)
+    {
+        throw std::runtime_error("Config file syntax error: Invalid 'resolution_cache' directive value: " + directive);
+    }
+    if (remainingPos != args[0].length() - 4 || _resolution_cache_max == 0)
+        throw std::runtime_error("Config file syntax error: Invalid 'resolution_cache' directive value: " + directive);
+}
+
+void GlobalConfig::setCGIPool(std::string directive)
+{
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    // `interpreter worker [size=N] [max_requests=N]`
+    if (args.size() < 2 || args.size() > 4)
+        throw std::runtime_error("Config file syntax error: 'cgi_pool' directive invalid number of arguments: " + directive);
+
+    const std::string &interpreter{args[0]};
+    if (_cgi_pools.find(interpreter) != _cgi_pools.end())
+        throw std::runtime_error("Config file syntax error: 'cgi_pool' directive is duplicate: " + directive);
+    if (access(interpreter.c_str(), X_OK) != 0)
+        throw std::runtime_error("Config file error: 'cgi_pool' interpreter either does not exist or is not executable: " +
+                                 directive);
+    if (access(args[1].c_str(), R_OK) != 0)
+        throw std::runtime_error("Config file error: 'cgi_pool' worker program either does not exist or is not readable: " +
+                                 directive);
+
+    CGIWorkerPool::Settings settings;
+    settings.worker = std::filesystem::absolute(args[1]).string();
+    for (std::size_t i{2}; i < args.size(); ++i)
+    {
+        std::size_t *value{nullptr};
+        std::size_t  nameLength{0};
+        if (args[i].compare(0, 5, "size=") == 0)
+        {
+            value = &settings.size;
+            nameLength = 5;
+        }
+        else if (args[i].compare(0, 13, "max_requests=") == 0)
+        {
+            value = &settings.maxRequests;
+            nameLength = 13;
+        }
+        else
+            throw std::runtime_error("Config file syntax error: 'cgi_pool' directive arguments after the worker should be "
+                                     "'size=N' or 'max_requests=N': " +
+                                     directive);
+        std::size_t remainingPos;
+        try
+        {
+            *value = std::stoul(args[i].substr(nameLength), &remainingPos);
+        }
+        catch (const std::exception &)
+        {
+            throw std::runtime_error("Config file syntax error: Invalid 'cgi_pool' directive value: " + directive);
+        }
+        if (remainingPos != args[i].length() - nameLength || *value == 0)
+            throw std::runtime_error("Config file syntax error: Invalid 'cgi_pool' directive value: " + directive);
+    }
+    _cgi_pools.emplace(interpreter, std::move(settings));
+}
+
+void GlobalConfig::setCGIMaxConcurrency(std::string directive)
+{
+    if (_seen_cgi_max_concurrency)
+        throw std::runtime_error("Config file syntax error: 'cgi_max_concurrency' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    // `N [queue=N] [queue_timeout=time] [retry_after=time]`
+    if (args.empty() || args.size() > 4)
+        throw std::runtime_error("Config file syntax error: 'cgi_max_concurrency' directive invalid number of arguments: " +
+                                 directive);
+
+    _seen_cgi_max_concurrency = true;
+    std::size_t remainingPos;
+    try
+    {
+        _cgi_concurrency.maxConcurrency = std::stoul(args[0], &remainingPos);
+    }
+    catch (const std::exception &)
+    {
+        throw std::runtime_error("Config file syntax error: Invalid 'cgi_max_concurrency' directive value: " + directive);
+    }
+    if (remainingPos != args[0].length() || _cgi_concurrency.maxConcurrency == 0)
+        throw std::runtime_error("Config file syntax error: Invalid 'cgi_max_concurrency' directive value: " + directive);
+
+    for (std::size_t i{1}; i < args.size(); ++i)
+    {
+        bool valid{false};
+        if (args[i].compare(0, 6, "queue=") == 0)
+        {
+            try
+            {
+                // A queue of 0 rejects every request beyond the limit right away
+                _cgi_concurrency.queueSize = std::stoul(args[i].substr(6), &remainingPos);
+                valid = remainingPos == args[i].length() - 6;
+            }
+            catch (const std::exception &)
+            {
+            }
+        }
+        else if (args[i].compare(0, 14, "queue_timeout=") == 0)
+            valid = parseTimeDuration(args[i].substr(14), _cgi_concurrency.queueTimeout) &&
+                    _cgi_concurrency.queueTimeout > 0;
+        else if (args[i].compare(0, 12, "retry_after=") == 0)
+            valid = parseTimeDuration(args[i].substr(12), _cgi_concurrency.retryAfter) && _cgi_concurrency.retryAfter >= 0;
+        if (!valid)
+            throw std::runtime_error("Config file syntax error: Invalid 'cgi_max_concurrency' directive value: " + directive);
+    }
+}
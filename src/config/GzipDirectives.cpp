@@ -0,0 +1,83 @@
+#include "GzipDirectives.hpp"
+
+#include <algorithm> /* std::transform() */
+#include <cctype>
+
+namespace
+{
+std::string toLower(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return std::tolower(c); });
+    return str;
+}
+} // namespace
+
+void GzipDirectives::setEnabled(const std::string &directive)
+{
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.size() != 1)
+        throw std::runtime_error("Config file syntax error: 'gzip' directive invalid number of arguments: " + directive);
+
+    std::string value{toLower(args[0])};
+    if (value == "on")
+        _enabled = true;
+    else if (value == "off")
+        _enabled = false;
+    else
+        throw std::runtime_error("Config file syntax error: Invalid 'gzip' directive value: " + directive);
+}
+
+void GzipDirectives::setCompLevel(const std::string &directive)
+{
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.size() != 1)
+        throw std::runtime_error("Config file syntax error: 'gzip_comp_level' directive invalid number of arguments: " +
+                                 directive);
+    if (args[0].size() != 1 || args[0][0] < '1' || args[0][0] > '9')
+        throw std::runtime_error("Config file syntax error: 'gzip_comp_level' directive value should be 1 to 9: " + directive);
+    _comp_level = args[0][0] - '0';
+}
+
+void GzipDirectives::setTypes(const std::string &directive)
+{
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.empty())
+        throw std::runtime_error("Config file syntax error: 'gzip_types' directive invalid number of arguments: " + directive);
+
+    _all_types = false;
+    _types = {"text/html"};
+    for (const auto &type : args)
+    {
+        if (type == "*")
+            _all_types = true;
+        else if (type.find('/') == std::string::npos)
+            throw std::runtime_error("Config file syntax error: 'gzip_types' directive invalid MIME type: " + directive);
+        else
+            _types.insert(toLower(type));
+    }
+}
+
+bool GzipDirectives::isEnabled() const
+{
+    return _enabled;
+}
+
+int GzipDirectives::getCompLevel() const
+{
+    return _comp_level;
+}
+
+bool GzipDirectives::compressesType(std::string_view contentType) const
+{
+    if (contentType.empty())
+        return false;
+    if (_all_types)
+        return true;
+    contentType = contentType.substr(0, contentType.find(';'));
+    while (!contentType.empty() && (contentType.back() == ' ' || contentType.back() == '\t'))
+        contentType.remove_suffix(1);
+    return _types.find(toLower(std::string(contentType))) != _types.end();
+}
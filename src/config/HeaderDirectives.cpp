@@ -0,0 +1,144 @@
+#include "HeaderDirectives.hpp"
+
+#include <cctype>
+
+namespace
+{
+bool isValidHeaderName(const std::string &name)
+{
+    if (name.empty())
+        return false;
+    for (unsigned char c : name)
+    {
+        if (!std::isalnum(c) && std::string_view{"!#$%&'*+-.^_`|~"}.find(c) == std::string_view::npos)
+            return false;
+    }
+    return true;
+}
+} // namespace
+
+void HeaderDirectives::setExpires(const std::string &directive)
+{
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.size() != 1)
+        throw std::runtime_error("Config file syntax error: 'expires' directive invalid number of arguments: " + directive);
+
+    const std::string &value{args[0]};
+    _expires_formatted_at = -1;
+    if (value == "off")
+    {
+        _expires_mode = EXPIRES_OFF;
+        _cache_control.clear();
+        _expires.clear();
+    }
+    else if (value == "epoch")
+    {
+        _expires_mode = EXPIRES_FIXED;
+        _cache_control = "no-cache";
+        _expires = "Thu, 01 Jan 1970 00:00:01 GMT";
+    }
+    else if (value == "max")
+    {
+        _expires_mode = EXPIRES_FIXED;
+        _cache_control = "max-age=315360000";
+        _expires = "Thu, 31 Dec 2037 23:55:55 GMT";
+    }
+    else
+    {
+        long seconds;
+        if (!parseTimeDuration(value, seconds))
+            throw std::runtime_error("Config file syntax error: Invalid 'expires' directive value: " + directive);
+        _expires_mode = EXPIRES_RELATIVE;
+        _expires_seconds = seconds;
+        _cache_control = seconds < 0 ? "no-cache" : "max-age=" + std::to_string(seconds);
+        _expires.clear();
+    }
+}
+
+void HeaderDirectives::addHeader(const std::string &directive)
+{
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.size() != 2 && args.size() != 3)
+        throw std::runtime_error("Config file syntax error: 'add_header' directive invalid number of arguments: " + directive);
+    if (args.size() == 3 && args[2] != "always")
+        throw std::runtime_error("Config file syntax error: 'add_header' directive invalid third argument (only "
+                                 "'always' is allowed): " +
+                                 directive);
+    if (!isValidHeaderName(args[0]))
+        throw std::runtime_error("Config file syntax error: 'add_header' directive invalid header name: " + directive);
+    if (args[1].find_first_of("\r\n") != std::string::npos)
+        throw std::runtime_error("Config file syntax error: 'add_header' directive invalid header value: " + directive);
+
+    std::string &lines{args.size() == 3 ? _added_headers_always : _added_headers};
+    lines += args[0];
+    lines += ": ";
+    lines += args[1];
+    lines += "\r\n";
+}
+
+void HeaderDirectives::clearAddedHeaders()
+{
+    _added_headers.clear();
+    _added_headers_always.clear();
+}
+
+bool HeaderDirectives::empty() const
+{
+    return _expires_mode == EXPIRES_OFF && _added_headers.empty() && _added_headers_always.empty();
+}
+
+bool HeaderDirectives::appliesToStatus(int statusCode)
+{
+    switch (statusCode)
+    {
+    case 200:
+    case 201:
+    case 204:
+    case 206:
+    case 301:
+    case 302:
+    case 303:
+    case 304:
+    case 307:
+    case 308:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool HeaderDirectives::hasExpires() const
+{
+    return _expires_mode != EXPIRES_OFF;
+}
+
+std::string_view HeaderDirectives::getCacheControl() const
+{
+    return _cache_control;
+}
+
+std::string_view HeaderDirectives::getExpires() const
+{
+    if (_expires_mode != EXPIRES_RELATIVE)
+        return _expires;
+
+    std::time_t now{std::time(nullptr)};
+    if (now != _expires_formatted_at)
+    {
+        _expires_formatted = formatHTTPDate(now + _expires_seconds);
+        _expires_formatted_at = now;
+    }
+    return _expires_formatted;
+}
+
+std::string_view HeaderDirectives::getAddedHeaders() const
+{
+    return _added_headers;
+}
+
+std::string_view HeaderDirectives::getAddedHeadersAlways() const
+{
+    return _added_headers_always;
+}
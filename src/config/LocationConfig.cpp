@@ -6,8 +6,12 @@ LocationConfig::LocationConfig(const std::string &location_block_str, const Serv
     , _index_files_vec{server_config.getIndexFilesVec()}
     , _client_max_body_size{server_config.getClientMaxBodySize()}
     , _autoindex{server_config.getAutoIndex()}
+    , _gzip_static{server_config.getGzipStatic()}
+    , _brotli_static{server_config.getBrotliStatic()}
     , _error_pages_map{server_config.getErrorPagesMap()}
     , _cgi_handlers_map{server_config.getCGIHandlersMap()}
+    , _header_directives{server_config.getHeaderDirectives()}
+    , _gzip_directives{server_config.getGzipDirectives()}
 {
     parseLocationConfig(location_block_str);
 }
@@ -34,6 +38,16 @@ bool LocationConfig::getAutoIndex() const
     return _autoindex;
 }
 
+bool LocationConfig::getGzipStatic() const
+{
+    return _gzip_static;
+}
+
+bool LocationConfig::getBrotliStatic() const
+{
+    return _brotli_static;
+}
+
 const std::map<int, std::string> &LocationConfig::getErrorPagesMap() const
 {
     return _error_pages_map;
@@ -59,6 +73,41 @@ const std::map<std::string, std::string> &LocationConfig::getCGIHandlersMap() co
     return _cgi_handlers_map;
 }
 
+const HeaderDirectives &LocationConfig::getHeaderDirectives() const
+{
+    return _header_directives;
+}
+
+const GzipDirectives &LocationConfig::getGzipDirectives() const
+{
+    return _gzip_directives;
+}
+
+const std::vector<std::string> &LocationConfig::getPreloadPatterns() const
+{
+    return _preload_patterns;
+}
+
+const std::string &LocationConfig::getFastCGIPass() const
+{
+    return _fastcgi_pass;
+}
+
+const CGICache::Settings &LocationConfig::getCGICache() const
+{
+    return _cgi_cache;
+}
+
+std::size_t LocationConfig::getCGIMaxConcurrency() const
+{
+    return _cgi_max_concurrency;
+}
+
+bool LocationConfig::getMetrics() const
+{
+    return _metrics;
+}
+
 /* Parsing logic */
 
 void LocationConfig::parseLocationConfig(std::string location_block_str)
@@ -125,12 +174,24 @@ void LocationConfig::setConfigurationValue(std::string directive)
     std::string root{"root"};
     std::string client_max_body_size{"client_max_body_size"};
     std::string autoindex{"autoindex"};
+    std::string gzip_static{"gzip_static"};
+    std::string brotli_static{"brotli_static"};
+    std::string gzip_comp_level{"gzip_comp_level"};
+    std::string gzip_types{"gzip_types"};
+    std::string gzip{"gzip"};
     std::string error_page{"error_page"};
     std::string cgi_handler{"cgi_handler"};
+    std::string cgi_cache{"cgi_cache"};
+    std::string cgi_max_concurrency{"cgi_max_concurrency"};
     std::string index{"index"};
     std::string limit_except{"limit_except"};
     std::string upload_store{"upload_store"};
     std::string return_directive{"return"};
+    std::string expires{"expires"};
+    std::string add_header{"add_header"};
+    std::string preload{"preload"};
+    std::string fastcgi_pass{"fastcgi_pass"};
+    std::string metrics{"metrics"};
 
     std::size_t nextWordPos;
 
@@ -144,12 +205,33 @@ void LocationConfig::setConfigurationValue(std::string directive)
     // Set autoindex on or off
     else if (firstWordEquals(directive, autoindex, &nextWordPos))
         setAutoIndex(directive.substr(nextWordPos));
+    // Set gzip_static on or off
+    else if (firstWordEquals(directive, gzip_static, &nextWordPos))
+        setGzipStatic(directive.substr(nextWordPos));
+    // Set brotli_static on or off
+    else if (firstWordEquals(directive, brotli_static, &nextWordPos))
+        setBrotliStatic(directive.substr(nextWordPos));
+    // Set gzip compression level
+    else if (firstWordEquals(directive, gzip_comp_level, &nextWordPos))
+        setGzipCompLevel(directive.substr(nextWordPos));
+    // Set MIME types to compress
+    else if (firstWordEquals(directive, gzip_types, &nextWordPos))
+        setGzipTypes(directive.substr(nextWordPos));
+    // Set gzip on or off (checked after the other `gzip_` directives, since it's their prefix)
+    else if (firstWordEquals(directive, gzip, &nextWordPos))
+        setGzip(directive.substr(nextWordPos));
     // Set error pages
     else if (firstWordEquals(directive, error_page, &nextWordPos))
         setErrorPage(directive.substr(nextWordPos));
     // Set CGI handler
     else if (firstWordEquals(directive, cgi_handler, &nextWordPos))
         setCGIHandler(directive.substr(nextWordPos));
+    // Set caching of the output of CGI scripts
+    else if (firstWordEquals(directive, cgi_cache, &nextWordPos))
+        setCGICache(directive.substr(nextWordPos));
+    // Set how many scripts of the location run at once
+    else if (firstWordEquals(directive, cgi_max_concurrency, &nextWordPos))
+        setCGIMaxConcurrency(directive.substr(nextWordPos));
     // Set index files
     else if (firstWordEquals(directive, index, &nextWordPos))
         setIndex(directive.substr(nextWordPos));
@@ -162,6 +244,21 @@ void LocationConfig::setConfigurationValue(std::string directive)
     // Set return directive
     else if (firstWordEquals(directive, return_directive, &nextWordPos))
         setReturn(directive.substr(nextWordPos));
+    // Set expires (Cache-Control and Expires headers)
+    else if (firstWordEquals(directive, expires, &nextWordPos))
+        setExpires(directive.substr(nextWordPos));
+    // Add a response header
+    else if (firstWordEquals(directive, add_header, &nextWordPos))
+        setAddHeader(directive.substr(nextWordPos));
+    // Add files to load into the caches at startup
+    else if (firstWordEquals(directive, preload, &nextWordPos))
+        setPreload(directive.substr(nextWordPos));
+    // Pass requests to a FastCGI responder
+    else if (firstWordEquals(directive, fastcgi_pass, &nextWordPos))
+        setFastCGIPass(directive.substr(nextWordPos));
+    // Set the metrics endpoint on or off
+    else if (firstWordEquals(directive, metrics, &nextWordPos))
+        setMetrics(directive.substr(nextWordPos));
     else
         throw std::runtime_error("Config file syntax error: Disallowed directive in location context: " + directive);
 }
@@ -365,7 +462,7 @@ void LocationConfig::setLimitExcept(std::string directive)
         std::transform(elem.begin(), elem.end(), elem.begin(), [](unsigned char c) { return std::tolower(c); });
 
         // check if HTTP method is valid
-        if (elem != "get" && elem != "post" && elem != "delete")
+        if (elem != "get" && elem != "head" && elem != "post" && elem != "delete")
             throw std::runtime_error("Config file syntax error: 'limit_except' directive invalid method: " + elem);
 
         _limit_except.insert(elem);
@@ -423,3 +520,242 @@ void LocationConfig::setReturn(std::string directive)
 
     _seen_return = true;
 }
+
+void LocationConfig::setExpires(std::string directive)
+{
+    if (_seen_expires)
+        throw std::runtime_error("Config file syntax error: 'expires' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    // Overrides the inherited value
+    _header_directives.setExpires(directive);
+    _seen_expires = true;
+}
+
+void LocationConfig::setAddHeader(std::string directive)
+{
+    trim(directive, ";");
+
+    // Remove any headers inherited from server context to override them
+    if (!_seen_add_header)
+        _header_directives.clearAddedHeaders();
+    _seen_add_header = true;
+
+    _header_directives.addHeader(directive);
+}
+
+void LocationConfig::setGzipStatic(std::string directive)
+{
+    if (_seen_gzip_static)
+        throw std::runtime_error("Config file syntax error: 'gzip_static' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+    trimOuterSpacesAndQuotes(directive);
+
+    // Convert string to lowercase
+    std::transform(directive.begin(), directive.end(), directive.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    if (directive == "on")
+        _gzip_static = true;
+    else if (directive == "off")
+        _gzip_static = false;
+    else
+        throw std::runtime_error("Config file syntax error: Invalid 'gzip_static' directive value: " + directive);
+    _seen_gzip_static = true;
+}
+
+void LocationConfig::setBrotliStatic(std::string directive)
+{
+    if (_seen_brotli_static)
+        throw std::runtime_error("Config file syntax error: 'brotli_static' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+    trimOuterSpacesAndQuotes(directive);
+
+    // Convert string to lowercase
+    std::transform(directive.begin(), directive.end(), directive.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    if (directive == "on")
+        _brotli_static = true;
+    else if (directive == "off")
+        _brotli_static = false;
+    else
+        throw std::runtime_error("Config file syntax error: Invalid 'brotli_static' directive value: " + directive);
+    _seen_brotli_static = true;
+}
+
+void LocationConfig::setGzip(std::string directive)
+{
+    if (_seen_gzip)
+        throw std::runtime_error("Config file syntax error: 'gzip' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    _gzip_directives.setEnabled(directive);
+    _seen_gzip = true;
+}
+
+void LocationConfig::setGzipCompLevel(std::string directive)
+{
+    if (_seen_gzip_comp_level)
+        throw std::runtime_error("Config file syntax error: 'gzip_comp_level' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    _gzip_directives.setCompLevel(directive);
+    _seen_gzip_comp_level = true;
+}
+
+void LocationConfig::setGzipTypes(std::string directive)
+{
+    if (_seen_gzip_types)
+        throw std::runtime_error("Config file syntax error: 'gzip_types' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    _gzip_directives.setTypes(directive);
+    _seen_gzip_types = true;
+}
+
+void LocationConfig::setPreload(std::string directive)
+{
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.empty())
+        throw std::runtime_error("Config file syntax error: 'preload' directive invalid number of arguments: " + directive);
+
+    for (auto &elem : args)
+    {
+        if (elem.empty() || elem[0] != '/')
+            throw std::runtime_error("Config file syntax error: 'preload' directive pattern should start with '/': " + directive);
+        _preload_patterns.push_back(elem);
+    }
+}
+
+void LocationConfig::setFastCGIPass(std::string directive)
+{
+    if (_seen_fastcgi_pass)
+        throw std::runtime_error("Config file syntax error: 'fastcgi_pass' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.size() != 1)
+        throw std::runtime_error("Config file syntax error: 'fastcgi_pass' directive invalid number of arguments: " + directive);
+
+    const std::string &address{args[0]};
+    if (address.compare(0, 5, "unix:") == 0)
+    {
+        if (address.size() < 7 || address[5] != '/')
+            throw std::runtime_error("Config file syntax error: 'fastcgi_pass' socket path should be absolute: " + directive);
+    }
+    else
+    {
+        std::size_t colonPos{address.rfind(':')};
+        if (colonPos == std::string::npos || colonPos == 0 || colonPos + 1 == address.size() ||
+            address.find_first_not_of("0123456789", colonPos + 1) != std::string::npos || address.size() - colonPos > 6 ||
+            std::stoul(address.substr(colonPos + 1)) == 0 || std::stoul(address.substr(colonPos + 1)) > 65535)
+            throw std::runtime_error("Config file syntax error: 'fastcgi_pass' address should be 'unix:/path' or 'host:port': " + directive);
+    }
+    _fastcgi_pass = address;
+    _seen_fastcgi_pass = true;
+}
+
+void LocationConfig::setCGICache(std::string directive)
+{
+    if (_seen_cgi_cache)
+        throw std::runtime_error("Config file syntax error: 'cgi_cache' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.empty() || args.size() > 3)
+        throw std::runtime_error("Config file syntax error: 'cgi_cache' directive invalid number of arguments: " + directive);
+
+    _seen_cgi_cache = true;
+    if (args.size() == 1 && args[0] == "off")
+        return;
+
+    // `valid=time [stale=time] [key=header,...]`
+    if (args[0].compare(0, 6, "valid=") != 0 || !parseTimeDuration(args[0].substr(6), _cgi_cache.valid) ||
+        _cgi_cache.valid <= 0)
+        throw std::runtime_error("Config file syntax error: 'cgi_cache' directive first argument should be 'valid=time' "
+                                 "or 'off': " +
+                                 directive);
+    for (std::size_t i{1}; i < args.size(); ++i)
+    {
+        bool valid{true};
+        if (args[i].compare(0, 6, "stale=") == 0)
+            valid = parseTimeDuration(args[i].substr(6), _cgi_cache.stale) && _cgi_cache.stale >= 0;
+        else if (args[i].compare(0, 4, "key=") == 0)
+        {
+            std::string names{args[i].substr(4)};
+            std::transform(names.begin(), names.end(), names.begin(), [](unsigned char c) { return std::tolower(c); });
+            std::size_t start{0};
+            while (valid && start <= names.size())
+            {
+                std::size_t end{names.find(',', start)};
+                if (end == std::string::npos)
+                    end = names.size();
+                valid = end > start;
+                _cgi_cache.keyHeaders.push_back(names.substr(start, end - start));
+                start = end + 1;
+            }
+        }
+        else
+            valid = false;
+        if (!valid)
+            throw std::runtime_error("Config file syntax error: Invalid 'cgi_cache' directive value: " + directive);
+    }
+}
+
+void LocationConfig::setCGIMaxConcurrency(std::string directive)
+{
+    if (_seen_cgi_max_concurrency)
+        throw std::runtime_error("Config file syntax error: 'cgi_max_concurrency' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.size() != 1)
+        throw std::runtime_error("Config file syntax error: 'cgi_max_concurrency' directive invalid number of arguments: " +
+                                 directive);
+
+    std::size_t remainingPos;
+    try
+    {
+        _cgi_max_concurrency = std::stoul(args[0], &remainingPos);
+    }
+    catch (const std::exception &)
+    {
+        throw std::runtime_error("Config file syntax error: Invalid 'cgi_max_concurrency' directive value: " + directive);
+    }
+    if (remainingPos != args[0].length() || _cgi_max_concurrency == 0)
+        throw std::runtime_error("Config file syntax error: Invalid 'cgi_max_concurrency' directive value: " + directive);
+    _seen_cgi_max_concurrency = true;
+}
+
+void LocationConfig::setMetrics(std::string directive)
+{
+    if (_seen_metrics)
+        throw std::runtime_error("Config file syntax error: 'metrics' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+    trimOuterSpacesAndQuotes(directive);
+    // Convert string to lowercase
+    std::transform(directive.begin(), directive.end(), directive.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    if (directive == "on")
+        _metrics = true;
+    else if (directive == "off")
+        _metrics = false;
+    else
+        throw std::runtime_error("Config file syntax error: Invalid 'metrics' directive value: " + directive);
+    _seen_metrics = true;
+}
@@ -60,6 +60,16 @@ bool ServerConfig::getAutoIndex() const
     return _autoindex;
 }
 
+bool ServerConfig::getGzipStatic() const
+{
+    return _gzip_static;
+}
+
+bool ServerConfig::getBrotliStatic() const
+{
+    return _brotli_static;
+}
+
 const std::map<int, std::string> &ServerConfig::getErrorPagesMap() const
 {
     return _error_pages_map;
@@ -75,6 +85,21 @@ const std::map<std::string, std::string> &ServerConfig::getCGIHandlersMap() cons
     return _cgi_handlers_map;
 }
 
+const HeaderDirectives &ServerConfig::getHeaderDirectives() const
+{
+    return _header_directives;
+}
+
+const GzipDirectives &ServerConfig::getGzipDirectives() const
+{
+    return _gzip_directives;
+}
+
+const std::vector<std::string> &ServerConfig::getPreloadPatterns() const
+{
+    return _preload_patterns;
+}
+
 /* Parsing logic */
 
 void ServerConfig::parseServerConfig(std::string server_block_str)
@@ -143,8 +168,16 @@ void ServerConfig::setConfigurationValue(std::string directive)
     std::string root{"root"};
     std::string client_max_body_size{"client_max_body_size"};
     std::string autoindex{"autoindex"};
+    std::string gzip_static{"gzip_static"};
+    std::string brotli_static{"brotli_static"};
+    std::string gzip_comp_level{"gzip_comp_level"};
+    std::string gzip_types{"gzip_types"};
+    std::string gzip{"gzip"};
     std::string error_page{"error_page"};
     std::string index{"index"};
+    std::string expires{"expires"};
+    std::string add_header{"add_header"};
+    std::string preload{"preload"};
 
     std::size_t nextWordPos{};
 
@@ -169,12 +202,36 @@ void ServerConfig::setConfigurationValue(std::string directive)
     // Set autoindex on or off
     else if (firstWordEquals(directive, autoindex, &nextWordPos))
         setAutoIndex(directive.substr(nextWordPos));
+    // Set gzip_static on or off
+    else if (firstWordEquals(directive, gzip_static, &nextWordPos))
+        setGzipStatic(directive.substr(nextWordPos));
+    // Set brotli_static on or off
+    else if (firstWordEquals(directive, brotli_static, &nextWordPos))
+        setBrotliStatic(directive.substr(nextWordPos));
+    // Set gzip compression level
+    else if (firstWordEquals(directive, gzip_comp_level, &nextWordPos))
+        setGzipCompLevel(directive.substr(nextWordPos));
+    // Set MIME types to compress
+    else if (firstWordEquals(directive, gzip_types, &nextWordPos))
+        setGzipTypes(directive.substr(nextWordPos));
+    // Set gzip on or off (checked after the other `gzip_` directives, since it's their prefix)
+    else if (firstWordEquals(directive, gzip, &nextWordPos))
+        setGzip(directive.substr(nextWordPos));
     // Set error pages
     else if (firstWordEquals(directive, error_page, &nextWordPos))
         setErrorPage(directive.substr(nextWordPos));
     // Set index files
     else if (firstWordEquals(directive, index, &nextWordPos))
         setIndex(directive.substr(nextWordPos));
+    // Set expires (Cache-Control and Expires headers)
+    else if (firstWordEquals(directive, expires, &nextWordPos))
+        setExpires(directive.substr(nextWordPos));
+    // Add a response header
+    else if (firstWordEquals(directive, add_header, &nextWordPos))
+        setAddHeader(directive.substr(nextWordPos));
+    // Add files to load into the caches at startup
+    else if (firstWordEquals(directive, preload, &nextWordPos))
+        setPreload(directive.substr(nextWordPos));
     else
         throw std::runtime_error("Config file syntax error: Disallowed directive in server context: " + directive);
 }
@@ -547,3 +604,111 @@ void ServerConfig::setIndex(std::string directive)
         _index_files_vec.push_back(elem);
     }
 }
+
+void ServerConfig::setExpires(std::string directive)
+{
+    if (_seen_expires)
+        throw std::runtime_error("Config file syntax error: 'expires' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    _header_directives.setExpires(directive);
+    _seen_expires = true;
+}
+
+void ServerConfig::setAddHeader(std::string directive)
+{
+    trim(directive, ";");
+
+    _header_directives.addHeader(directive);
+}
+
+void ServerConfig::setGzipStatic(std::string directive)
+{
+    if (_seen_gzip_static)
+        throw std::runtime_error("Config file syntax error: 'gzip_static' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+    trimOuterSpacesAndQuotes(directive);
+
+    // Convert string to lowercase
+    std::transform(directive.begin(), directive.end(), directive.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    if (directive == "on")
+        _gzip_static = true;
+    else if (directive == "off")
+        _gzip_static = false;
+    else
+        throw std::runtime_error("Config file syntax error: Invalid 'gzip_static' directive value: " + directive);
+    _seen_gzip_static = true;
+}
+
+void ServerConfig::setBrotliStatic(std::string directive)
+{
+    if (_seen_brotli_static)
+        throw std::runtime_error("Config file syntax error: 'brotli_static' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+    trimOuterSpacesAndQuotes(directive);
+
+    // Convert string to lowercase
+    std::transform(directive.begin(), directive.end(), directive.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    if (directive == "on")
+        _brotli_static = true;
+    else if (directive == "off")
+        _brotli_static = false;
+    else
+        throw std::runtime_error("Config file syntax error: Invalid 'brotli_static' directive value: " + directive);
+    _seen_brotli_static = true;
+}
+
+void ServerConfig::setGzip(std::string directive)
+{
+    if (_seen_gzip)
+        throw std::runtime_error("Config file syntax error: 'gzip' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    _gzip_directives.setEnabled(directive);
+    _seen_gzip = true;
+}
+
+void ServerConfig::setGzipCompLevel(std::string directive)
+{
+    if (_seen_gzip_comp_level)
+        throw std::runtime_error("Config file syntax error: 'gzip_comp_level' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    _gzip_directives.setCompLevel(directive);
+    _seen_gzip_comp_level = true;
+}
+
+void ServerConfig::setGzipTypes(std::string directive)
+{
+    if (_seen_gzip_types)
+        throw std::runtime_error("Config file syntax error: 'gzip_types' directive is duplicate: " + directive);
+
+    trim(directive, ";");
+
+    _gzip_directives.setTypes(directive);
+    _seen_gzip_types = true;
+}
+
+void ServerConfig::setPreload(std::string directive)
+{
+    trim(directive, ";");
+
+    std::vector<std::string> args{splitStrExceptQuotes(directive)};
+
+    if (args.empty())
+        throw std::runtime_error("Config file syntax error: 'preload' directive invalid number of arguments: " + directive);
+
+    for (auto &elem : args)
+    {
+        if (elem.empty() || elem[0] != '/')
+            throw std::runtime_error("Config file syntax error: 'preload' directive pattern should start with '/': " + directive);
+        _preload_patterns.push_back(elem);
+    }
+}
@@ -26,6 +26,13 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    // A script that exits without reading all of its input, or a client gone, is an error of write(), not a signal
+    if (signal(SIGPIPE, SIG_IGN) == SIG_ERR)
+    {
+        std::cerr << "Failed to ignore SIGPIPE." << '\n';
+        return 1;
+    }
+
     if (argc != 1 && argc != 2)
     {
         std::cout << "Usage: ./webserv <configuration file>" << '\n';
@@ -44,6 +51,7 @@ int main(int argc, char **argv)
             configPath = argv[1];
 
         Server server{configPath};
+        server.preload();
         server.fillPollManager();
         server.run();
     }
@@ -7,9 +7,37 @@ HTTPRequest::HTTPRequest(HTTPRequestData data, const LocationConfig *location_co
 {
 }
 
+HTTPRequest::~HTTPRequest()
+{
+    // The connection is closed with the exchange (or the worker reused), it mustn't stay polled for this request
+    if (_upstreamFd != -1)
+        _server->unregisterUpstream(_upstreamFd);
+    // A worker given back lets the next request in line start
+    if (_upstream != nullptr)
+        _server->releasedUpstream();
+    // The subprocess closes its pidfd when it goes
+    if (_cgiSubprocess != nullptr && _cgiSubprocess->getPidFd() != -1)
+        _server->unregisterProcess(_cgiSubprocess->getPidFd());
+    // The script is stopped with the subprocess; its slot (or the place in the queue) goes to the next request
+    if (_cgiWaitingScript.has_value())
+        _server->getCGILimiter().leave(_clientFd, false);
+    releaseCGISlot();
+}
+
 bool HTTPRequest::isCloseConnection() const
 {
-    return _data.headers.find("Connection") != _data.headers.end() && _data.headers.at("Connection") == "close";
+    // Header names are lowercased by the parser
+    return _data.headers.find("connection") != _data.headers.end() && _data.headers.at("connection") == "close";
+}
+
+void HTTPRequest::setResolution(ResolutionCache::EntryPtr resolution)
+{
+    _resolution = std::move(resolution);
+}
+
+void HTTPRequest::setBodyStream(std::shared_ptr<CGIBodyStream> bodyStream)
+{
+    _bodyStream = std::move(bodyStream);
 }
 
 bool HTTPRequest::fullResponseIsReady()
@@ -19,19 +47,90 @@ bool HTTPRequest::fullResponseIsReady()
 
 std::string HTTPRequest::getFullResponse()
 {
+    // Bodies built in memory (error pages, listings, CGI output) are dropped here, keeping their Content-Length
+    if (_data.method == HEAD)
+    {
+        auto headersEnd{_fullResponse.find("\r\n\r\n")};
+        if (headersEnd != std::string::npos)
+            _fullResponse.erase(headersEnd + 4);
+    }
     return _fullResponse;
 }
 
-std::string HTTPRequest::getURInoLeadingSlash() const
+std::vector<FileSegment> HTTPRequest::takeFileSegments()
 {
-    std::string result{_data.uri};
+    return std::move(_fileSegments);
+}
+
+std::shared_ptr<const std::string> HTTPRequest::takeSharedBody()
+{
+    return std::move(_sharedBody);
+}
 
-    removeLeadingSlash(result);
+std::string HTTPRequest::renderResponse(ResponseWriter &response, bool compressBody) const
+{
+    if (compressBody && _effective_config && _effective_config->getGzipDirectives().isEnabled())
+        gzipBody(response);
+    if (_effective_config && !_effective_config->getHeaderDirectives().empty())
+    {
+        const HeaderDirectives &directives{_effective_config->getHeaderDirectives()};
+        if (HeaderDirectives::appliesToStatus(response.getStatusCode()))
+        {
+            if (directives.hasExpires())
+            {
+                response.setHeader(ResponseWriter::EXPIRES, directives.getExpires());
+                response.setHeader(ResponseWriter::CACHE_CONTROL, directives.getCacheControl());
+            }
+            response.appendRawHeaders(directives.getAddedHeaders());
+        }
+        response.appendRawHeaders(directives.getAddedHeadersAlways());
+    }
+    return response.write();
+}
 
-    return result;
+void HTTPRequest::gzipBody(ResponseWriter &response) const
+{
+    if (!prepareGzip(response, response.getBody().size()))
+        return;
+    response.setBody(GzipEncoder::compress(response.getBody(), _effective_config->getGzipDirectives().getCompLevel()));
+    // A length given by a CGI script refers to the uncompressed body
+    if (!response.getHeader(ResponseWriter::CONTENT_LENGTH).empty())
+        response.setHeader(ResponseWriter::CONTENT_LENGTH, std::to_string(response.getBody().size()));
 }
 
-void HTTPRequest::errorResponse(int errorCode)
+bool HTTPRequest::prepareGzip(ResponseWriter &response, std::size_t bodySize) const
+{
+    const GzipDirectives &gzip{_effective_config->getGzipDirectives()};
+    const int             status{response.getStatusCode()};
+    if (status < 200 || status == 204 || status == 206 || status == 304 || bodySize < GZIP_MIN_LENGTH ||
+        !response.getHeader(ResponseWriter::CONTENT_ENCODING).empty() ||
+        !gzip.compressesType(response.getHeader(ResponseWriter::CONTENT_TYPE)))
+        return false;
+
+    // Caches must know the body depends on Accept-Encoding, even when it's sent as it is
+    std::string_view vary{response.getHeader(ResponseWriter::VARY)};
+    if (vary.empty())
+        response.setHeader(ResponseWriter::VARY, "Accept-Encoding");
+    else if (vary != "*" && vary.find("Accept-Encoding") == std::string_view::npos)
+        response.setHeader(ResponseWriter::VARY, std::string(vary) + ", Accept-Encoding");
+
+    if (!acceptsGzip())
+        return false;
+    response.setHeader(ResponseWriter::CONTENT_ENCODING, "gzip");
+    // The compressed bytes are a different representation, so a strong validator would be wrong
+    std::string_view etag{response.getHeader(ResponseWriter::ETAG)};
+    if (!etag.empty() && etag.compare(0, 2, "W/") != 0)
+        response.setHeader(ResponseWriter::ETAG, "W/" + std::string(etag));
+    return true;
+}
+
+bool HTTPRequest::acceptsGzip() const
+{
+    auto acceptEncoding{_data.headers.find("accept-encoding")};
+    return acceptEncoding != _data.headers.end() && acceptEncodingQuality(acceptEncoding->second, "gzip") > 0;
+}
+
+void HTTPRequest::errorResponse(int errorCode, std::initializer_list<ResponseWriter::HeaderField> extraHeaders)
 {
     try
     {
@@ -41,7 +140,7 @@ void HTTPRequest::errorResponse(int errorCode)
         std::filesystem::path errorPagePath{_effective_config->getRoot()};
         errorPagePath /= error_file; // errorPagePath = root + current location + error_file
 
-        openFileSetHeaders(errorPagePath);
+        openFileSetHeaders(errorPagePath, errorCode, extraHeaders);
 
         return;
     }
@@ -58,7 +157,9 @@ void HTTPRequest::errorResponse(int errorCode)
     std::string minimalResponseStr{getMinimalErrorDefaultBody(errorCode)};
 
     ResponseWriter response(errorCode, {{"Content-Type", "text/html"}}, minimalResponseStr);
-    _fullResponse = response.write();
+    for (const auto &[name, value] : extraHeaders)
+        response.addHeader(name, value);
+    _fullResponse = renderResponse(response);
     _responseState = READY;
 }
 
@@ -87,10 +188,25 @@ std::string HTTPRequest::getMinimalErrorDefaultBody(int errorCode) const
         return "<html><head><title>415 Unsupported Media Type</title></head>"
                "<body><h1>415 Unsupported Media Type</h1><p>The server does not support the requested media "
                "type.</p></body></html>";
+    case 416:
+        return "<html><head><title>416 Range Not Satisfiable</title></head>"
+               "<body><h1>416 Range Not Satisfiable</h1><p>None of the requested ranges can be "
+               "satisfied.</p></body></html>";
     case 501:
         return "<html><head><title>501 Not Implemented</title></head>"
                "<body><h1>501 Not Implemented</h1><p>The server does not support the facility "
                "required.</p></body></html>";
+    case 502:
+        return "<html><head><title>502 Bad Gateway</title></head>"
+               "<body><h1>502 Bad Gateway</h1><p>The server received an invalid response from the "
+               "upstream server.</p></body></html>";
+    case 503:
+        return "<html><head><title>503 Service Unavailable</title></head>"
+               "<body><h1>503 Service Unavailable</h1><p>The server is busy. Please try again "
+               "later.</p></body></html>";
+    case 504:
+        return "<html><head><title>504 Gateway Timeout</title></head>"
+               "<body><h1>504 Gateway Timeout</h1><p>The upstream server did not respond in time.</p></body></html>";
     case 500:
         return "<html><head><title>500 Internal Server Error</title></head>"
                "<body><h1>500 Internal Server Error</h1>"
@@ -102,186 +218,228 @@ std::string HTTPRequest::getMinimalErrorDefaultBody(int errorCode) const
     }
 }
 
-void HTTPRequest::openFileSetHeaders(const std::filesystem::path &filePath)
+void HTTPRequest::openFileSetHeaders(const std::filesystem::path &filePath, int statusCode,
+                                     std::initializer_list<ResponseWriter::HeaderField> extraHeaders)
 {
-    int fd = open(filePath.c_str(), O_RDONLY);
-    if (fd == -1)
-        throw std::runtime_error(strerror(errno));
-    setNonBlocking(fd);
-    OpenFile open_file;
-    open_file.fileType = OpenFile::READ;
-    open_file.size = std::filesystem::file_size(filePath);
-    open_file.lastReadWriteTime = std::chrono::steady_clock::now();
-    _clientData->openFiles[fd] = open_file;
-    _server->getOpenFilesToClientMap()[fd] = _clientFd;
-    _server->getPollManager().addReadFileFd(fd);
-
-    std::unordered_map<std::string, std::string> headers;
-    headers["Content-Type"] = MimeTypes::getMimeType(filePath.extension().string());
-    headers["Last-Modified"] = getLastModTimeHTTP(filePath);
-
-    _responseWithoutBody = std::make_unique<ResponseWriter>(200, headers, "");
+    OpenFileCache::EntryPtr file{_server->getOpenFileCache().lookup(filePath)};
+    if (file->fd == -1)
+        throw std::runtime_error(strerror(file->exists ? file->error : ENOENT));
+
+    ResponseWriter response(statusCode);
+    response.setHeader(ResponseWriter::CONTENT_TYPE, file->mimeType);
+    response.setHeader(ResponseWriter::CONTENT_LENGTH, std::to_string(file->size));
+    response.setHeader(ResponseWriter::LAST_MODIFIED, file->lastModified);
+    for (const auto &[name, value] : extraHeaders)
+        response.addHeader(name, value);
+    // HEAD gets the same headers, without the body
+    if (_data.method != HEAD)
+        _fileSegments.push_back({"", file->fd, 0, file->size});
+    _bodyFile = std::move(file);
+
+    _fullResponse = renderResponse(response);
+    _responseState = READY;
 }
 
-// Helper function for getDirectoryListingBody
-std::vector<HTTPRequest::FileInfo> listDirectory(const std::filesystem::path &dir_path)
+namespace
 {
-    std::vector<HTTPRequest::FileInfo> files;
+// "YYYY-MM-DD HH:MM:SS" (UTC) for a listing row, computed arithmetically instead of with a localtime() call per row
+void appendListingTime(std::string &out, std::time_t time)
+{
+    long days{static_cast<long>(time / 86400)};
+    long secondsOfDay{static_cast<long>(time % 86400)};
+    if (secondsOfDay < 0)
+    {
+        secondsOfDay += 86400;
+        --days;
+    }
+    // Civil date from days since the epoch (proleptic Gregorian calendar)
+    days += 719468;
+    const long     era{(days >= 0 ? days : days - 146096) / 146097};
+    const unsigned dayOfEra{static_cast<unsigned>(days - era * 146097)};
+    const unsigned yearOfEra{(dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365};
+    const unsigned dayOfYear{dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100)};
+    const unsigned shiftedMonth{(5 * dayOfYear + 2) / 153};
+    const unsigned day{dayOfYear - (153 * shiftedMonth + 2) / 5 + 1};
+    const unsigned month{shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9};
+    const long     year{static_cast<long>(yearOfEra) + era * 400 + (month <= 2)};
+
+    char buf[32];
+    int  length{std::snprintf(buf, sizeof(buf), "%04ld-%02u-%02u %02ld:%02ld:%02ld", year, month, day, secondsOfDay / 3600,
+                              secondsOfDay / 60 % 60, secondsOfDay % 60)};
+    out.append(buf, static_cast<std::size_t>(length));
+}
 
-    try
+void appendHTMLEscaped(std::string &out, std::string_view text)
+{
+    for (char c : text)
     {
-        // Check if directory exists
-        if (!std::filesystem::exists(dir_path) || !std::filesystem::is_directory(dir_path))
+        switch (c)
         {
-            std::cerr << "Directory does not exist or is not a directory: " << dir_path << std::endl;
-            return files;
+        case '&':
+            out += "&amp;";
+            break;
+        case '<':
+            out += "&lt;";
+            break;
+        case '>':
+            out += "&gt;";
+            break;
+        case '"':
+            out += "&quot;";
+            break;
+        default:
+            out += c;
         }
+    }
+}
 
-        // Iterate through directory entries
-        for (const auto &entry : std::filesystem::directory_iterator(dir_path))
+// Percent-encode a file name (or with `keepSlashes`, a path) for use in a link (everything but unreserved characters)
+void appendURIEscaped(std::string &out, std::string_view name, bool keepSlashes = false)
+{
+    static constexpr char HEX[]{"0123456789ABCDEF"};
+    for (unsigned char c : name)
+    {
+        if (std::isalnum(c) || c == '-' || c == '.' || c == '_' || c == '~' || (keepSlashes && c == '/'))
+            out += static_cast<char>(c);
+        else
         {
-            HTTPRequest::FileInfo info;
-            info.name = entry.path().filename().string();
-            info.is_directory = entry.is_directory();
-
-            // Get file size (0 for directories)
-            if (info.is_directory)
-            {
-                info.size = 0;
-            }
-            else
-            {
-                try
-                {
-                    info.size = entry.file_size();
-                }
-                catch (const std::filesystem::filesystem_error &)
-                {
-                    info.size = 0; // If can't get size
-                }
-            }
-
-            // Get last modification time
-            try
-            {
-                auto ftime = entry.last_write_time();
-                // Convert to system_clock time_point
-                auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(ftime - std::filesystem::file_time_type::clock::now() + std::chrono::system_clock::now());
-                info.modified_time = std::chrono::system_clock::to_time_t(sctp);
-            }
-            catch (const std::filesystem::filesystem_error &)
-            {
-                info.modified_time = 0; // If can't get time
-            }
-
-            files.push_back(info);
+            out += '%';
+            out += HEX[c >> 4];
+            out += HEX[c & 0xF];
         }
-
-        // Sort files: directories first, then by name
-        std::sort(files.begin(), files.end(),
-                  [](const HTTPRequest::FileInfo &a, const HTTPRequest::FileInfo &b)
-                  {
-                      if (a.is_directory != b.is_directory)
-                      {
-                          return a.is_directory; // directories first
-                      }
-                      return a.name < b.name; // then alphabetically
-                  });
     }
-    catch (const std::exception &e)
+}
+
+// Requested page of a listing (`?page=N`, 1-based); 0 if the query asks for an invalid one
+std::size_t listingPageFromQuery(const std::string &query)
+{
+    for (const auto &param : splitStr(query, "&"))
     {
-        std::cerr << "Filesystem error: " << e.what() << std::endl;
+        if (param.compare(0, 5, "page=") != 0)
+            continue;
+        const std::string number{param.substr(5)};
+        if (number.empty() || number.size() > 9 || number.find_first_not_of("0123456789") != std::string::npos)
+            return 0;
+        return std::stoul(number);
     }
-
-    return files;
+    return 1;
 }
+} // namespace
 
-std::string HTTPRequest::getDirectoryListingBody(const std::filesystem::path &dirPath) const
+bool HTTPRequest::getDirectoryListingBody(const std::filesystem::path &dirPath, std::string &body) const
 {
-    auto filesVec = listDirectory(dirPath);
+    DirectoryListingCache::ListingPtr listing{_server->getDirectoryListingCache().lookup(dirPath)};
+    if (listing == nullptr)
+        return false;
 
-    if (filesVec.empty())
-        return getMinimalErrorDefaultBody(404); // Should never happen but just to be safe
+    const std::string &uriPath{_data.path};
+    const std::string &query{_data.query};
+    const std::size_t itemCount{listing->items.size()};
+    const std::size_t pageCount{itemCount == 0 ? 1 : (itemCount + DIRECTORY_LISTING_PAGE_SIZE - 1) / DIRECTORY_LISTING_PAGE_SIZE};
+    const std::size_t page{listingPageFromQuery(query)};
+    if (page == 0 || page > pageCount)
+        return false;
 
-    std::string html = "<!DOCTYPE html>\n<html>\n<head>\n";
-    html += "<title>Index of " + _data.uri + "</title>\n";
-    html += "<style>\n";
-    html += "body { font-family: Arial, sans-serif; margin: 20px; }\n";
-    html += "table { border-collapse: collapse; width: 100%; }\n";
-    html += "th, td { text-align: left; padding: 8px; border-bottom: 1px solid #ddd; }\n";
-    html += "th { background-color: #f2f2f2; }\n";
-    html += "a { text-decoration: none; color: #0066cc; }\n";
-    html += "a:hover { text-decoration: underline; }\n";
-    html += ".dir { font-weight: bold; }\n";
-    html += "</style>\n</head>\n<body>\n";
+    const std::string pageKey{DirectoryListingCache::pageKey(uriPath, page)};
+    auto              rendered{listing->pages.find(pageKey)};
+    if (rendered != listing->pages.end())
+    {
+        body = rendered->second;
+        return true;
+    }
+
+    // Only the entries shown on this page are stat()ed, relative to the directory so paths aren't resolved again
+    int dirFd{open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+    if (dirFd == -1)
+        return false;
 
-    html += "<h1>Index of " + _data.uri + "</h1>\n";
-    html += "<table>\n<tr><th>Name</th><th>Size</th><th>Last Modified</th></tr>\n";
+    const std::size_t first{(page - 1) * DIRECTORY_LISTING_PAGE_SIZE};
+    const std::size_t last{std::min(itemCount, first + DIRECTORY_LISTING_PAGE_SIZE)};
+    std::string       base;
+    appendURIEscaped(base, uriPath, true); // The path is decoded, links need it encoded again
+    if (base.empty() || base.back() != '/')
+        base += '/';
+
+    std::string html;
+    html.reserve(1024 + (last - first) * 160);
+    html += "<!DOCTYPE html>\n<html>\n<head>\n<title>Index of ";
+    appendHTMLEscaped(html, uriPath);
+    html += "</title>\n"
+            "<style>\n"
+            "body { font-family: Arial, sans-serif; margin: 20px; }\n"
+            "table { border-collapse: collapse; width: 100%; }\n"
+            "th, td { text-align: left; padding: 8px; border-bottom: 1px solid #ddd; }\n"
+            "th { background-color: #f2f2f2; }\n"
+            "a { text-decoration: none; color: #0066cc; }\n"
+            "a:hover { text-decoration: underline; }\n"
+            ".dir { font-weight: bold; }\n"
+            "</style>\n</head>\n<body>\n<h1>Index of ";
+    appendHTMLEscaped(html, uriPath);
+    html += "</h1>\n<table>\n<tr><th>Name</th><th>Size</th><th>Last Modified (UTC)</th></tr>\n";
 
     // Add parent directory link if not root
-    if (_data.uri != "/")
-    {
+    if (uriPath != "/")
         html += "<tr><td><a href=\"../\" class=\"dir\">../</a></td><td>-</td><td>-</td></tr>\n";
-    }
 
-    for (const auto &file : filesVec)
+    for (std::size_t i{first}; i < last; ++i)
     {
-        html += "<tr><td>";
-        auto fileUri{std::filesystem::path(getURInoLeadingSlash()) / file.name};
-        if (file.is_directory)
-        {
-            html += "<a href=\"" + fileUri.string() + "/\" class=\"dir\">" + file.name + "/</a>";
-        }
+        const DirectoryListingCache::Item &item{listing->items[i]};
+        struct stat                         itemStat;
+        const bool                          statOk{fstatat(dirFd, item.name.c_str(), &itemStat, 0) == 0};
+
+        html += "<tr><td><a href=\"";
+        appendHTMLEscaped(html, base);
+        appendURIEscaped(html, item.name);
+        if (item.isDirectory)
+            html += "/\" class=\"dir\">";
         else
-        {
-            html += "<a href=\"" + fileUri.string() + "\">" + file.name + "</a>";
-        }
-        html += "</td><td>";
-
-        if (file.is_directory)
-        {
+            html += "\">";
+        appendHTMLEscaped(html, item.name);
+        html += item.isDirectory ? "/</a></td><td>" : "</a></td><td>";
+        if (item.isDirectory)
             html += "-";
-        }
         else
-        {
-            html += bytesToHumanReadable(file.size);
-        }
-
+            html += statOk ? bytesToHumanReadable(static_cast<std::size_t>(itemStat.st_size)) : "-";
         html += "</td><td>";
-        if (file.modified_time != 0)
-        {
-            char time_str[100];
-            std::strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", std::localtime(&file.modified_time));
-            html += time_str;
-        }
+        if (statOk)
+            appendListingTime(html, itemStat.st_mtime);
         else
-        {
             html += "Unknown";
-        }
         html += "</td></tr>\n";
     }
+    close(dirFd);
+    html += "</table>\n";
+
+    if (pageCount > 1)
+    {
+        html += "<p>Page " + std::to_string(page) + " of " + std::to_string(pageCount);
+        if (page > 1)
+            html += " &middot; <a href=\"?page=" + std::to_string(page - 1) + "\">previous</a>";
+        if (page < pageCount)
+            html += " &middot; <a href=\"?page=" + std::to_string(page + 1) + "\">next</a>";
+        html += "</p>\n";
+    }
+    html += "</body>\n</html>";
 
-    html += "</table>\n</body>\n</html>";
-    return html;
+    body = html;
+    _server->getDirectoryListingCache().storePage(dirPath, listing, pageKey, std::move(html));
+    return true;
 }
 
 void HTTPRequest::handleRedirection(const std::pair<int, std::string> &redirectInfo)
 {
-    std::string codeWithReasonPhrase{std::to_string(redirectInfo.first) + " " + reasonPhraseFromStatusCode(redirectInfo.first)};
+    std::string codeWithReasonPhrase{std::to_string(redirectInfo.first) + " " + std::string{reasonPhraseFromStatusCode(redirectInfo.first)}};
     std::string responseBody{"<html><head><title>"};
     responseBody += codeWithReasonPhrase;
     responseBody += "</title></head><body><h1>";
     responseBody += codeWithReasonPhrase;
     responseBody += "</h1></body></html>";
 
-    std::unordered_map<std::string, std::string> headers;
-    headers["Content-Type"] = "text/html";
-
+    ResponseWriter response(redirectInfo.first, {{"Content-Type", "text/html"}}, responseBody);
     if (!redirectInfo.second.empty())
-        headers["Location"] = redirectInfo.second;
-    ResponseWriter response(redirectInfo.first, headers, responseBody);
+        response.setHeader(ResponseWriter::LOCATION, redirectInfo.second);
 
-    _fullResponse = response.write();
+    _fullResponse = renderResponse(response);
     _responseState = READY;
 }
 
@@ -295,16 +453,15 @@ std::unordered_map<std::string, std::string> HTTPRequest::createCGIenvironment(c
     envMap["REQUEST_URI"] = _data.uri;
     envMap["SCRIPT_FILENAME"] = filePathAbs.string();
 
-    std::pair<std::string, std::string> splitUri{splitUriIntoPathAndQuery(_data.uri)};
-    envMap["SCRIPT_NAME"] = splitUri.first;
-    envMap["QUERY_STRING"] = splitUri.second;
+    envMap["SCRIPT_NAME"] = _data.path;
+    envMap["QUERY_STRING"] = _data.query;
 
     if (_data.headers.find("content-type") != _data.headers.end())
         envMap["CONTENT_TYPE"] = _data.headers.at("content-type");
     else
         envMap["CONTENT_TYPE"] = "";
 
-    envMap["CONTENT_LENGTH"] = std::to_string(_data.body.length());
+    envMap["CONTENT_LENGTH"] = std::to_string(_bodyStream != nullptr ? _bodyStream->getContentLength() : _data.body.length());
 
     if (_data.headers.find("host") != _data.headers.end())
         envMap["SERVER_NAME"] = _data.headers.at("host");
@@ -335,61 +492,127 @@ std::unordered_map<std::string, std::string> HTTPRequest::createCGIenvironment(c
 
 void HTTPRequest::cgiOutputToResponse(const std::string &cgi_output)
 {
-    // recycling isValidRequest to check if CGI response is valid
-    if (!HTTPRequestParser::isValidRequest(cgi_output))
+    std::unordered_map<std::string, std::string> headers;
+    std::string                                  body;
+    if (!HTTPRequestParser::parseCGIResponse(cgi_output, headers, body))
     {
         std::cout << "CGI returned invalid response" << '\n';
         return errorResponse(500);
     }
 
-    HTTPRequestData data{HTTPRequestParser::parse(cgi_output)};
-    auto            status_header = data.headers.find("status");
-    int             status_value{};
-    if (status_header == data.headers.end())
+    ResponseWriter     response{cgiHeadersToResponse(headers)};
+    CGICache::Lifetime lifetime;
+    // A response to HEAD may lack its body, so only GET stores one
+    if (!_cgiCacheKey.empty() && _data.method == GET &&
+        CGICache::getLifetime(response.getStatusCode(), headers, _effective_config->getCGICache(), lifetime))
+        _server->getCGICache().store(_cgiCacheKey, std::move(headers), body, lifetime);
+    response.setBody(std::move(body));
+    _fullResponse = renderResponse(response);
+    // _responseState = READY; // Set after child exits
+}
+
+ResponseWriter HTTPRequest::cgiHeadersToResponse(std::unordered_map<std::string, std::string> headers)
+{
+    auto status_header = headers.find("status");
+    int  status_value{};
+    if (status_header == headers.end())
         status_value = 200;
     else
     {
         std::istringstream iss{status_header->second};
         iss >> status_value;
     }
-    data.headers.erase("status");
-    ResponseWriter response(status_value, data.headers, data.body);
-    _fullResponse = response.write();
-    // _responseState = READY; // Set after child exits
+    headers.erase("status");
+    ResponseWriter response(status_value);
+    for (const auto &[key, value] : headers)
+        response.addHeader(key, value);
+    return response;
 }
 
 void HTTPRequest::serveCGI(const std::filesystem::path &filePath, const std::string &interpreter)
 {
-    if (!std::filesystem::exists(filePath))
+    if (!_server->getOpenFileCache().lookup(filePath)->exists)
         return errorResponse(404);
+    if (serveFromCGICache())
+        return;
 
     auto filePathAbs{std::filesystem::absolute(filePath)};
+    if (_server->getCGIWorkerPool().handles(interpreter))
+    {
+        try
+        {
+            _upstream = std::make_unique<CGIWorkerExchange>(_server->getCGIWorkerPool(), interpreter,
+                                                            createCGIenvironment(filePathAbs), _data.body);
+            syncUpstreamFd();
+            // For timeout (waiting for a worker included)
+            _cgiStartTime = std::chrono::steady_clock::now();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            _upstream = nullptr;
+            return errorResponse(500);
+        }
+        return;
+    }
+
+    // Scripts beyond `cgi_max_concurrency` wait for one of those running to exit
+    switch (_server->getCGILimiter().admit(_clientFd, _effective_config, _effective_config->getCGIMaxConcurrency()))
+    {
+    case CGIConcurrencyLimiter::ADMITTED:
+        _holdsCGISlot = true;
+        return startCGISubprocess(filePathAbs, interpreter);
+    case CGIConcurrencyLimiter::QUEUED:
+        _cgiWaitingScript.emplace(filePathAbs, interpreter);
+        // For the queue timeout
+        _cgiStartTime = std::chrono::steady_clock::now();
+        return;
+    case CGIConcurrencyLimiter::REJECTED:
+        return serviceUnavailable();
+    }
+}
+
+void HTTPRequest::startCGISubprocess(const std::filesystem::path &filePathAbs, const std::string &interpreter)
+{
     try
     {
         _cgiSubprocess = std::make_unique<CGISubprocess>();
         // CGISubprocess subprocess;
         _cgiSubprocess->setEnvironment(createCGIenvironment(filePathAbs));
         _cgiSubprocess->createSubprocess(filePathAbs, interpreter);
+        // Its exit is an event: the status is collected once, when it's reported
+        if (_cgiSubprocess->getPidFd() != -1)
+            _server->registerProcess(_cgiSubprocess->getPidFd(), _clientFd);
 
         // Register the write to CGI with poll
         OpenFile open_write_file;
         open_write_file.fileType = OpenFile::WRITE;
         open_write_file.isCGI = true;
-        open_write_file.content = _data.body;
-        open_write_file.size = _data.body.size();
         open_write_file.lastReadWriteTime = std::chrono::steady_clock::now();
         int writeToCgiFd{_cgiSubprocess->getWritePipeToCGI()};
+        if (_bodyStream != nullptr)
+        {
+            // The body is written as it arrives (and the pipe closed once all of it has been)
+            _bodyStream->attach(writeToCgiFd);
+            open_write_file.bodyStream = _bodyStream;
+        }
+        else
+        {
+            open_write_file.content = _data.body;
+            open_write_file.size = _data.body.size();
+        }
         _clientData->openFiles[writeToCgiFd] = open_write_file;
         _server->getOpenFilesToClientMap()[writeToCgiFd] = _clientFd;
         _server->getPollManager().addWriteFileFd(writeToCgiFd);
 
-        // Register the read from CGI with poll
+        // Register the read from CGI with poll; the server feeds what it reads to the relay
+        int readFromCgiFd{_cgiSubprocess->getReadPipeFromCGI()};
+        _cgiRelay = std::make_shared<CGIResponseRelay>(readFromCgiFd);
         OpenFile open_read_file;
         open_read_file.fileType = OpenFile::READ;
         open_read_file.isCGI = true;
-        open_read_file.size = std::string::npos; // Will be later updated (in Server) based on header returned
+        open_read_file.cgiRelay = _cgiRelay;
         open_read_file.lastReadWriteTime = std::chrono::steady_clock::now();
-        int readFromCgiFd{_cgiSubprocess->getReadPipeFromCGI()};
         _clientData->openFiles[readFromCgiFd] = open_read_file;
         _server->getOpenFilesToClientMap()[readFromCgiFd] = _clientFd;
         _server->getPollManager().addReadFileFd(readFromCgiFd);
@@ -400,52 +623,329 @@ void HTTPRequest::serveCGI(const std::filesystem::path &filePath, const std::str
     catch (const std::exception &e)
     {
         std::cerr << e.what() << '\n';
+        _cgiRelay = nullptr;
+        // A script that didn't start doesn't hold its slot
+        if (_cgiSubprocess == nullptr || _cgiSubprocess->childHasExited())
+            releaseCGISlot();
         return errorResponse(500);
     }
 }
 
-void HTTPRequest::checkCGIstatus()
+void HTTPRequest::continueWaitingForCGISlot()
 {
-    if (_cgiSubprocess->childHasExited())
+    CGIConcurrencyLimiter &limiter{_server->getCGILimiter()};
+    if (limiter.takeGrant(_clientFd))
     {
-        if (_cgiSubprocess->getChildExitStatus() == 0)
-            _responseState = READY;
-        else
-        {
-            std::cout << "Child exited with non-zero status code" << '\n';
-            return errorResponse(500); // child exited with non-zero status code
-        }
+        auto [filePathAbs, interpreter]{std::move(*_cgiWaitingScript)};
+        _cgiWaitingScript = std::nullopt;
+        _holdsCGISlot = true;
+        return startCGISubprocess(filePathAbs, interpreter);
     }
-    else // child has not exited yet
+    auto elapsed{std::chrono::steady_clock::now() - _cgiStartTime.value()};
+    if (elapsed < std::chrono::seconds(limiter.getSettings().queueTimeout))
+        return; // Keep _responseState IN_PROGRESS
+    std::cout << "No CGI slot has been free within the queue timeout." << '\n';
+    limiter.leave(_clientFd, true);
+    _cgiWaitingScript = std::nullopt;
+    _cgiStartTime = std::nullopt;
+    serviceUnavailable();
+}
+
+void HTTPRequest::releaseCGISlot()
+{
+    if (!_holdsCGISlot)
+        return;
+    _holdsCGISlot = false;
+    // The requests granted the slot are woken by the server, as this may run while the request is destroyed
+    _server->getCGILimiter().release(_effective_config);
+}
+
+void HTTPRequest::serviceUnavailable()
+{
+    const std::string retryAfter{std::to_string(_server->getCGILimiter().getSettings().retryAfter)};
+    errorResponse(503, {{"Retry-After", retryAfter}});
+}
+
+void HTTPRequest::serveFastCGI()
+{
+    if (!_resolution->underRoot)
+        return errorResponse(403);
+    if (serveFromCGICache())
+        return;
+
+    // Whether the script exists is up to the responder, as it may not share this filesystem
+    auto filePathAbs{std::filesystem::absolute(_resolution->filePath)};
+    try
+    {
+        _upstream = std::make_unique<FastCGIExchange>(_server->getFastCGIPool(), _effective_config->getFastCGIPass(),
+                                                      createCGIenvironment(filePathAbs), _data.body);
+        syncUpstreamFd();
+        // For timeout
+        _cgiStartTime = std::chrono::steady_clock::now();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        _upstream = nullptr;
+        return errorResponse(502);
+    }
+}
+
+bool HTTPRequest::serveFromCGICache()
+{
+    const CGICache::Settings &settings{_effective_config->getCGICache()};
+    CGICache                 &cache{_server->getCGICache()};
+    if (!settings.isEnabled() || !cache.isEnabled() || !CGICache::isCacheableRequest(_data))
+        return false;
+    // A refresh runs the script whatever is cached, and stores its output under the key that expired
+    if (!_clientData->cgiCacheRefresh.empty())
+    {
+        _cgiCacheKey = _clientData->cgiCacheRefresh;
+        return false;
+    }
+    _cgiCacheKey = CGICache::makeKey(_clientData->serverConfig, _data, settings);
+    CGICache::Freshness freshness;
+    CGICache::EntryPtr  entry{cache.lookup(_cgiCacheKey, freshness)};
+    if (entry == nullptr)
+        return false;
+    if (freshness == CGICache::STALE && cache.startRefresh(_cgiCacheKey))
+        _server->refreshCGICache(_clientFd, _data, _resolution, _cgiCacheKey);
+    _cgiCacheKey.clear();
+
+    ResponseWriter response{cgiHeadersToResponse(entry->headers)};
+    response.addHeader("Age", std::to_string(entry->getAge()));
+    response.setBody(entry->body);
+    _fullResponse = renderResponse(response);
+    _responseState = READY;
+    return true;
+}
+
+void HTTPRequest::continueUpstream()
+{
+    // A CGI worker may have been handed to a request waiting for one
+    syncUpstreamFd();
+    const int failureStatus{_upstream->isGateway() ? 502 : 500};
+    if (!_upstream->isDone())
     {
         auto elapsed{std::chrono::steady_clock::now() - _cgiStartTime.value()};
-        if (elapsed >= std::chrono::seconds(CGI_TIMEOUT)) // CGI process going on for too long
+        if (elapsed < std::chrono::seconds(CGI_TIMEOUT))
+            return; // Keep _responseState IN_PROGRESS
+        std::cout << "Upstream has not answered within the specified timeout." << '\n';
+        const int timeoutStatus{_upstream->isGateway() ? 504 : 500};
+        endUpstream();
+        return errorResponse(timeoutStatus);
+    }
+    if (_upstream->hasFailed())
+    {
+        endUpstream();
+        return errorResponse(failureStatus);
+    }
+    std::string output{_upstream->takeOutput()};
+    endUpstream();
+    cgiOutputToResponse(output);
+    _responseState = READY;
+}
+
+void HTTPRequest::syncUpstreamFd()
+{
+    const int fd{_upstream->getFd()};
+    if (fd == -1 && !_upstream->isDone())
+        _server->awaitUpstream(_clientFd);
+    if (fd == _upstreamFd)
+    {
+        if (fd != -1)
+            _server->getPollManager().setEvents(fd, _upstream->getEvents());
+        return;
+    }
+    if (_upstreamFd != -1)
+        _server->unregisterUpstream(_upstreamFd);
+    if (fd != -1)
+        _server->registerUpstream(fd, _clientFd, _upstream->getEvents());
+    _upstreamFd = fd;
+}
+
+void HTTPRequest::endUpstream()
+{
+    if (_upstreamFd != -1)
+        _server->unregisterUpstream(_upstreamFd);
+    _upstreamFd = -1;
+    _upstream->releaseConnection();
+    _upstream = nullptr;
+    _cgiStartTime = std::nullopt;
+    _server->releasedUpstream();
+}
+
+bool HTTPRequest::handleUpstreamEvents(short revents)
+{
+    if (_upstream == nullptr)
+        return false;
+    _upstream->handleEvents(revents);
+    syncUpstreamFd();
+    return true;
+}
+
+std::shared_ptr<CGIResponseRelay> HTTPRequest::getCGIRelay() const
+{
+    if (_cgiRelay == nullptr || _responseState != READY)
+        return nullptr;
+    return _cgiRelay;
+}
+
+void HTTPRequest::continueCGI()
+{
+    if (_cgiRelay->headersComplete())
+    {
+        // Nothing has been sent yet, so a script that has already failed still gets a 500 rather than a cut-off body
+        if (_cgiRelay->hasEndOfOutput() && _cgiSubprocess != nullptr)
         {
-            std::cout << "CGI process has continued for longer than the specified timeout. Killing it." << '\n';
-            _cgiSubprocess->killSubprocess(SIGKILL);
-            _cgiSubprocess = nullptr;
-            _cgiStartTime = std::nullopt;
-            return errorResponse(500);
+            _cgiSubprocess->collectExitStatus();
+            if (_cgiSubprocess->childHasExited() && _cgiSubprocess->getChildExitStatus() != 0)
+            {
+                std::cout << "Child exited with non-zero status code" << '\n';
+                releaseCGISlot();
+                _cgiRelay = nullptr;
+                _cgiStartTime = std::nullopt;
+                return errorResponse(500);
+            }
         }
-        // else, do nothing (keep _responseState to IN_PROGRESS)
+        return startCGIResponse();
+    }
+    if (_cgiRelay->hasEndOfOutput())
+    {
+        std::cout << "CGI returned invalid response" << '\n';
+        _cgiRelay = nullptr;
+        _cgiStartTime = std::nullopt;
+        return errorResponse(500);
+    }
+    // A script still being fed the body waits for the client, whose own timeout applies
+    if (_bodyStream != nullptr && !_bodyStream->isComplete())
+        _cgiStartTime = std::chrono::steady_clock::now();
+    auto elapsed{std::chrono::steady_clock::now() - _cgiStartTime.value()};
+    if (elapsed >= std::chrono::seconds(CGI_TIMEOUT)) // CGI process going on for too long
+    {
+        std::cout << "CGI process has not responded within the specified timeout. Killing it." << '\n';
+        _cgiSubprocess->killSubprocess(SIGKILL);
+        _cgiRelay = nullptr;
+        _cgiStartTime = std::nullopt;
+        return errorResponse(500);
     }
+    // else, do nothing (keep _responseState to IN_PROGRESS)
 }
 
-bool HTTPRequest::normalizeAndValidateUnderRoot(const std::filesystem::path &candidate, std::filesystem::path &outNormalized) const
+void HTTPRequest::startCGIResponse()
+{
+    std::unordered_map<std::string, std::string> headers{_cgiRelay->getHeaders()};
+    std::size_t                                  length{std::string::npos};
+    auto                                         contentLength{headers.find("content-length")};
+    if (contentLength != headers.end())
+    {
+        const std::string &value{contentLength->second};
+        std::size_t        parsed{};
+        auto [end, error]{std::from_chars(value.data(), value.data() + value.size(), parsed)};
+        if (error == std::errc{} && end == value.data() + value.size() && !value.empty())
+            length = parsed;
+        headers.erase(contentLength); // Set again below if the body is sent as it is
+    }
+    ResponseWriter response{cgiHeadersToResponse(std::move(headers))};
+    response.setStreamedBody();
+
+    const int  status{response.getStatusCode()};
+    const bool noBody{status < 200 || status == 204 || status == 304};
+    std::unique_ptr<GzipEncoder> gzip;
+    if (!noBody && _effective_config && _effective_config->getGzipDirectives().isEnabled() && prepareGzip(response, length))
+    {
+        gzip = std::make_unique<GzipEncoder>(_effective_config->getGzipDirectives().getCompLevel());
+        length = std::string::npos;
+    }
+
+    // The body is sent as it is if its length is known, chunked otherwise (HTTP/1.0 clients read it until the end)
+    CGIResponseRelay::Framing framing{CGIResponseRelay::LENGTH};
+    if (noBody)
+        length = 0;
+    else if (length != std::string::npos)
+        response.setHeader(ResponseWriter::CONTENT_LENGTH, std::to_string(length));
+    else if (_data.version == "HTTP/1.0")
+        framing = CGIResponseRelay::CLOSE;
+    else
+    {
+        framing = CGIResponseRelay::CHUNKED;
+        response.addHeader("Transfer-Encoding", "chunked");
+    }
+    // The body is stored once the script has sent all of it (see continueCGIResponse()); HEAD doesn't read it
+    if (!_cgiCacheKey.empty() && _data.method == GET &&
+        CGICache::getLifetime(status, _cgiRelay->getHeaders(), _effective_config->getCGICache(), _cgiCacheLifetime))
+        _cgiRelay->captureBody(_server->getCGICache().getMaxObject());
+    _fullResponse = renderResponse(response, false);
+    _cgiRelay->startBody(framing, length, noBody || _data.method == HEAD, std::move(gzip));
+    // The timeout was for the script to start responding; from now on the pipe's idle timeout applies
+    _cgiStartTime = std::nullopt;
+    _responseState = READY;
+}
+
+void HTTPRequest::handleProcessExit()
 {
-    std::filesystem::path rootPath = std::filesystem::path(_effective_config->getRoot());
-    std::filesystem::path normRoot = rootPath.lexically_normal();
-    std::filesystem::path normCand = candidate.lexically_normal();
+    if (_cgiSubprocess == nullptr)
+        return;
+    _cgiSubprocess->collectExitStatus();
+    if (_cgiSubprocess->childHasExited())
+        releaseCGISlot();
+}
 
-    auto rootStr = normRoot.string();
-    auto candStr = normCand.string();
+void HTTPRequest::continueCGIResponse()
+{
+    if (_cgiRelay == nullptr || _cgiRelay->isFinished() || !_cgiRelay->hasEndOfOutput())
+        return;
+    // The response ends with the script, which gets CGI_TIMEOUT to exit after closing its output
+    if (!_cgiSubprocess->childHasExited())
+    {
+        if (!_cgiStartTime.has_value())
+            _cgiStartTime = std::chrono::steady_clock::now();
+        if (std::chrono::steady_clock::now() - _cgiStartTime.value() < std::chrono::seconds(CGI_TIMEOUT))
+            return;
+        std::cout << "CGI process has not exited within the specified timeout. Killing it." << '\n';
+        _cgiSubprocess->killSubprocess(SIGKILL);
+        _cgiRelay->finish(false);
+        return;
+    }
+    releaseCGISlot();
+    const bool succeeded{_cgiSubprocess->getChildExitStatus() == 0};
+    if (!succeeded)
+        std::cout << "Child exited with non-zero status code, response cut off" << '\n';
+    _cgiRelay->finish(succeeded);
+    std::string body;
+    if (!_cgiCacheKey.empty() && _cgiRelay->takeCapturedBody(body))
+        _server->getCGICache().store(_cgiCacheKey, _cgiRelay->getHeaders(), std::move(body), _cgiCacheLifetime);
+}
 
-    // Ensure trailing separator handling: either exact match, or next char is '/'
-    bool startsWith =
-        candStr.compare(0, rootStr.size(), rootStr) == 0 && (candStr.size() == rootStr.size() || candStr[rootStr.size()] == '/');
-    if (!startsWith)
-        return false;
+const std::string &HTTPRequest::findIndexFile()
+{
+    ResolutionCache &resolutionCache{_server->getResolutionCache()};
+    OpenFileCache   &fileCache{_server->getOpenFileCache()};
+    // A remembered index file is only looked up again (an open file cache hit) to notice that it's gone
+    if (resolutionCache.hasIndexFile(*_resolution) &&
+        (_resolution->indexFile.empty() || fileCache.lookup(_resolution->indexFile)->exists))
+        return _resolution->indexFile;
+
+    const RootIndex &rootIndex{_server->getRootIndex()};
+    std::string      indexFile;
+    for (const auto &file : _effective_config->getIndexFilesVec())
+    {
+        // Join paths: requested URI dir + index file name
+        std::string candidate{(std::filesystem::path(_resolution->filePath) / file).string()};
+        if (rootIndex.lookup(candidate) == RootIndex::MISSING)
+            continue;
+        // Commit to this file if it exists, even if permission denied
+        if (fileCache.lookup(candidate)->exists)
+        {
+            indexFile = std::move(candidate);
+            break;
+        }
+    }
+    resolutionCache.setIndexFile(*_resolution, std::move(indexFile));
+    return _resolution->indexFile;
+}
 
-    outNormalized = normCand;
-    return true;
+bool HTTPRequest::normalizeAndValidateUnderRoot(const std::filesystem::path &candidate, std::filesystem::path &outNormalized) const
+{
+    return normalizeUnderRoot(_effective_config->getRoot(), candidate, outNormalized);
 }
\ No newline at end of file
@@ -6,6 +6,8 @@ std::string HTTPRequestData::methodStr() const
     {
     case GET:
         return "GET";
+    case HEAD:
+        return "HEAD";
     case POST:
         return "POST";
     case DELETE:
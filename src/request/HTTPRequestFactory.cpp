@@ -5,6 +5,7 @@ std::unique_ptr<HTTPRequest> HTTPRequestFactory::createRequest(const HTTPRequest
     switch (data.method)
     {
     case GET:
+    case HEAD: // HEAD shares the GET resolution path, only the body is left out
         return std::make_unique<GETRequest>(data, location_config);
     case POST:
         return std::make_unique<POSTRequest>(data, location_config);
@@ -1,6 +1,7 @@
 #include "HTTPRequestParser.hpp"
 
 #include <iostream>
+#include <utility> /* std::move() */
 
 bool HTTPRequestParser::isValidRequest(const std::string &buffer)
 {
@@ -23,11 +24,14 @@ bool HTTPRequestParser::isValidRequest(const std::string &buffer)
 
 HTTPRequestData HTTPRequestParser::parse(const std::string &requestStr)
 {
-    auto               bodyStart = requestStr.find("\r\n\r\n");
-    std::istringstream headerStream(requestStr.substr(0, bodyStart));
-    auto               HTTPData = getRequestLine(headerStream);
-    HTTPData.headers = parseHeaders(std::move(headerStream));
+    auto bodyStart = requestStr.find("\r\n\r\n");
+    auto HTTPData = parseHead(requestStr.substr(0, bodyStart));
     bodyStart += 4; // Skip CRLF CRLF
+    return parse(std::move(HTTPData), requestStr, bodyStart);
+}
+
+HTTPRequestData HTTPRequestParser::parse(HTTPRequestData HTTPData, const std::string &requestStr, std::size_t bodyStart)
+{
     try
     {
         HTTPData.body = getBody(HTTPData.headers, requestStr.substr(bodyStart));
@@ -35,26 +39,47 @@ HTTPRequestData HTTPRequestParser::parse(const std::string &requestStr)
     catch (const std::exception &e)
     {
         std::cout << "[info] Failed to parse body: " << e.what() << std::endl;
-        return {BAD_REQUEST, "", "", {}, ""};
+        return {BAD_REQUEST, "", "", {}, "", "/", ""};
     }
     return HTTPData;
 }
 
-std::size_t HTTPRequestParser::getResponseSizeFromCgiHeader(const std::string &cgiResponseStr)
+HTTPRequestData HTTPRequestParser::parseHead(const std::string &head)
 {
-    std::size_t size{0};
-    auto        bodyStart = cgiResponseStr.find("\r\n\r\n");
-    if (bodyStart != std::string::npos)
-        size += 4;
-    std::istringstream headerStream(cgiResponseStr.substr(0, bodyStart));
-    size += headerStream.str().length();
-    [[maybe_unused]] auto HTTPData = getRequestLine(headerStream);
+    std::istringstream headerStream(head);
+    auto               HTTPData = getRequestLine(headerStream);
     HTTPData.headers = parseHeaders(std::move(headerStream));
-    auto content_length_header{HTTPData.headers.find("content-length")};
-    if (content_length_header == HTTPData.headers.end())
-        return std::string::npos;
-    size += std::stoul(content_length_header->second);
-    return size;
+    // Decoded and normalized once here, so equivalent URIs resolve (and are cached) the same way
+    if (!normalizeRequestTarget(HTTPData.uri, HTTPData.path, HTTPData.query))
+    {
+        HTTPData.method = BAD_REQUEST;
+        HTTPData.path = "/";
+    }
+    return HTTPData;
+}
+
+bool HTTPRequestParser::parseCGIResponse(const std::string &cgiResponseStr, std::unordered_map<std::string, std::string> &headers,
+                                         std::string &body)
+{
+    // Unlike a request, a CGI response starts with header fields, which scripts often end with a bare LF
+    std::size_t headersEnd{cgiResponseStr.find("\r\n\r\n")};
+    std::size_t separatorLength{4};
+    std::size_t bareEnd{cgiResponseStr.find("\n\n")};
+    if (bareEnd < headersEnd)
+    {
+        headersEnd = bareEnd;
+        separatorLength = 2;
+    }
+    if (headersEnd == std::string::npos)
+        return false;
+    headers = parseCGIHeaders(cgiResponseStr.substr(0, headersEnd));
+    body = cgiResponseStr.substr(headersEnd + separatorLength);
+    return true;
+}
+
+std::unordered_map<std::string, std::string> HTTPRequestParser::parseCGIHeaders(const std::string &headerBlock)
+{
+    return parseHeaders(std::istringstream(headerBlock));
 }
 
 std::string HTTPRequestParser::getBody(const std::unordered_map<std::string, std::string> &headers, const std::string &bodyStr)
@@ -133,6 +158,8 @@ HTTPRequestData HTTPRequestParser::getRequestLine(std::istringstream &headerStre
     lineStream >> method >> HTTPData.uri >> HTTPData.version;
     if (method == "GET")
         HTTPData.method = GET;
+    else if (method == "HEAD")
+        HTTPData.method = HEAD;
     else if (method == "POST")
         HTTPData.method = POST;
     else if (method == "DELETE")
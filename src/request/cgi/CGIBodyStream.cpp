@@ -0,0 +1,81 @@
+#include "CGIBodyStream.hpp"
+
+#include <algorithm> /* std::min() */
+
+CGIBodyStream::CGIBodyStream(std::size_t contentLength)
+    : _contentLength(contentLength)
+{
+}
+
+std::size_t CGIBodyStream::append(const char *data, std::size_t size)
+{
+    const std::size_t bodyBytes{std::min(size, _contentLength - _received)};
+    _received += bodyBytes;
+    if (!_detached)
+        _pending.append(data, bodyBytes);
+    return bodyBytes;
+}
+
+void CGIBodyStream::attach(int pipeFd)
+{
+    _pipeFd = pipeFd;
+}
+
+void CGIBodyStream::detach()
+{
+    _pipeFd = -1;
+    _detached = true;
+    _pending = std::string{};
+    _pendingSent = 0;
+}
+
+std::size_t CGIBodyStream::getContentLength() const
+{
+    return _contentLength;
+}
+
+int CGIBodyStream::getPipeFd() const
+{
+    return _pipeFd;
+}
+
+bool CGIBodyStream::isComplete() const
+{
+    return _received == _contentLength;
+}
+
+const char *CGIBodyStream::data() const
+{
+    return _pending.data() + _pendingSent;
+}
+
+std::size_t CGIBodyStream::size() const
+{
+    return _pending.size() - _pendingSent;
+}
+
+void CGIBodyStream::consume(std::size_t count)
+{
+    _pendingSent += count;
+    if (_pendingSent == _pending.size())
+    {
+        _pending.clear();
+        _pendingSent = 0;
+    }
+    else if (_pendingSent >= CGI_BODY_BUFFER_SIZE / 2)
+    {
+        // Keeps the buffer from growing while the script takes it in small pieces
+        _pending.erase(0, _pendingSent);
+        _pendingSent = 0;
+    }
+}
+
+bool CGIBodyStream::isDrained() const
+{
+    return isComplete() && size() == 0;
+}
+
+bool CGIBodyStream::isFull() const
+{
+    return size() >= CGI_BODY_BUFFER_SIZE;
+}
@@ -0,0 +1,136 @@
+#include "CGIConcurrencyLimiter.hpp"
+
+#include <algorithm> /* std::max() */
+
+CGIConcurrencyLimiter::CGIConcurrencyLimiter(const Settings &settings)
+    : _settings(settings)
+{
+}
+
+CGIConcurrencyLimiter::Admission CGIConcurrencyLimiter::admit(int clientFd, const void *location, std::size_t locationLimit)
+{
+    // Waiters are granted slots as soon as they fit, so those still waiting can't use this one
+    if (hasRoom(location, locationLimit))
+    {
+        take(location);
+        ++_stats.admitted;
+        return ADMITTED;
+    }
+    if (_queue.size() >= _settings.queueSize)
+    {
+        ++_stats.rejected;
+        return REJECTED;
+    }
+    _queue.push_back({clientFd, location, locationLimit, std::chrono::steady_clock::now()});
+    ++_stats.queued;
+    return QUEUED;
+}
+
+bool CGIConcurrencyLimiter::takeGrant(int clientFd)
+{
+    return _granted.erase(clientFd) != 0;
+}
+
+void CGIConcurrencyLimiter::leave(int clientFd, bool timedOut)
+{
+    for (auto it{_queue.begin()}; it != _queue.end(); ++it)
+    {
+        if (it->clientFd == clientFd)
+        {
+            // Time spent waiting in vain counts too, or the wait looks shorter than it is under overload
+            if (timedOut)
+                recordWait(*it, std::chrono::steady_clock::now());
+            _queue.erase(it);
+            break;
+        }
+    }
+    if (timedOut)
+        ++_stats.timedOut;
+    auto granted{_granted.find(clientFd)};
+    if (granted == _granted.end())
+        return;
+    const void *location{granted->second};
+    _granted.erase(granted);
+    release(location);
+}
+
+void CGIConcurrencyLimiter::release(const void *location)
+{
+    --_running;
+    auto running{_runningPerLocation.find(location)};
+    if (running != _runningPerLocation.end() && --running->second == 0)
+        _runningPerLocation.erase(running);
+    grantWaiters();
+}
+
+std::vector<int> CGIConcurrencyLimiter::takeGranted()
+{
+    std::vector<int> granted;
+    granted.swap(_toWake);
+    return granted;
+}
+
+const CGIConcurrencyLimiter::Settings &CGIConcurrencyLimiter::getSettings() const
+{
+    return _settings;
+}
+
+const CGIConcurrencyLimiter::Stats &CGIConcurrencyLimiter::getStats() const
+{
+    return _stats;
+}
+
+std::size_t CGIConcurrencyLimiter::getRunning() const
+{
+    return _running;
+}
+
+std::size_t CGIConcurrencyLimiter::getQueueDepth() const
+{
+    return _queue.size();
+}
+
+bool CGIConcurrencyLimiter::hasRoom(const void *location, std::size_t locationLimit) const
+{
+    if (_settings.maxConcurrency != 0 && _running >= _settings.maxConcurrency)
+        return false;
+    if (locationLimit == 0)
+        return true;
+    auto running{_runningPerLocation.find(location)};
+    return running == _runningPerLocation.end() || running->second < locationLimit;
+}
+
+void CGIConcurrencyLimiter::take(const void *location)
+{
+    ++_running;
+    ++_runningPerLocation[location];
+}
+
+void CGIConcurrencyLimiter::grantWaiters()
+{
+    const auto now{std::chrono::steady_clock::now()};
+    for (auto it{_queue.begin()}; it != _queue.end();)
+    {
+        if (_settings.maxConcurrency != 0 && _running >= _settings.maxConcurrency)
+            return;
+        if (!hasRoom(it->location, it->locationLimit))
+        {
+            ++it;
+            continue;
+        }
+        take(it->location);
+        ++_stats.admitted;
+        recordWait(*it, now);
+        _granted[it->clientFd] = it->location;
+        _toWake.push_back(it->clientFd);
+        it = _queue.erase(it);
+    }
+}
+
+void CGIConcurrencyLimiter::recordWait(const Waiter &waiter, std::chrono::steady_clock::time_point now)
+{
+    const double waited{std::chrono::duration<double>(now - waiter.since).count()};
+    ++_stats.waitCount;
+    _stats.waitSeconds += waited;
+    _stats.maxWaitSeconds = std::max(_stats.maxWaitSeconds, waited);
+}
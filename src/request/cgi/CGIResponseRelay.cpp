@@ -0,0 +1,235 @@
+#include "CGIResponseRelay.hpp"
+#include "HTTPRequestParser.hpp"
+
+#include <algorithm> /* std::min() */
+#include <cstdio>    /* std::snprintf() */
+
+CGIResponseRelay::CGIResponseRelay(int pipeFd)
+    : _pipeFd(pipeFd)
+{
+}
+
+bool CGIResponseRelay::feed(const char *data, std::size_t size)
+{
+    if (_headersComplete)
+    {
+        if (_started)
+            relayBody({data, size});
+        else
+            _early.append(data, size);
+        return true;
+    }
+
+    // Only the new output is scanned for the empty line ending the header block (scripts often end lines with a bare LF)
+    std::size_t lineEnd{_headerBlock.size()};
+    _headerBlock.append(data, size);
+    while ((lineEnd = _headerBlock.find('\n', lineEnd)) != std::string::npos)
+    {
+        const std::size_t lineLength{lineEnd - _lineStart};
+        if (lineLength == 0 || (lineLength == 1 && _headerBlock[_lineStart] == '\r'))
+        {
+            _headers = HTTPRequestParser::parseCGIHeaders(_headerBlock.substr(0, _lineStart));
+            _early.assign(_headerBlock, lineEnd + 1);
+            _headerBlock = std::string{};
+            _headersComplete = true;
+            return true;
+        }
+        _lineStart = ++lineEnd;
+    }
+    return _headerBlock.size() <= CGI_HEADERS_MAX_SIZE;
+}
+
+void CGIResponseRelay::endOfOutput()
+{
+    _endOfOutput = true;
+}
+
+bool CGIResponseRelay::headersComplete() const
+{
+    return _headersComplete;
+}
+
+const std::unordered_map<std::string, std::string> &CGIResponseRelay::getHeaders() const
+{
+    return _headers;
+}
+
+void CGIResponseRelay::startBody(Framing framing, std::size_t length, bool discard, std::unique_ptr<GzipEncoder> gzip)
+{
+    _started = true;
+    _framing = framing;
+    _remaining = length;
+    _discard = discard;
+    _gzip = std::move(gzip);
+    std::string early;
+    early.swap(_early);
+    relayBody(early);
+}
+
+void CGIResponseRelay::finish(bool succeeded)
+{
+    if (_finished)
+        return;
+    _finished = true;
+    if (!succeeded || (_framing == LENGTH && _remaining > 0 && !_discard))
+    {
+        _cutOff = true;
+        return;
+    }
+    if (_discard)
+        return;
+    if (_gzip != nullptr)
+    {
+        std::string trailer;
+        _gzip->finish(trailer);
+        queue(trailer);
+    }
+    if (_framing == CHUNKED)
+        _queue += "0\r\n\r\n";
+}
+
+void CGIResponseRelay::captureBody(std::size_t limit)
+{
+    _capturing = true;
+    _captureLimit = limit;
+}
+
+bool CGIResponseRelay::takeCapturedBody(std::string &body)
+{
+    if (!_capturing || !_finished || _cutOff)
+        return false;
+    body = std::move(_captured);
+    _capturing = false;
+    return true;
+}
+
+int CGIResponseRelay::getPipeFd() const
+{
+    return _pipeFd;
+}
+
+bool CGIResponseRelay::hasEndOfOutput() const
+{
+    return _endOfOutput;
+}
+
+bool CGIResponseRelay::isFinished() const
+{
+    return _finished;
+}
+
+bool CGIResponseRelay::closesConnection() const
+{
+    return _framing == CLOSE || _cutOff;
+}
+
+bool CGIResponseRelay::canSplice() const
+{
+    return _started && !_finished && !_spliceDisabled && !_discard && _gzip == nullptr && !_capturing &&
+           _framing != CHUNKED && size() == 0 && (_framing == CLOSE || _remaining > 0);
+}
+
+std::size_t CGIResponseRelay::getSpliceLimit() const
+{
+    return _framing == LENGTH ? _remaining : CGI_RELAY_BUFFER_SIZE;
+}
+
+void CGIResponseRelay::spliced(std::size_t count)
+{
+    if (_framing == LENGTH)
+        _remaining -= count;
+}
+
+void CGIResponseRelay::disableSplice()
+{
+    _spliceDisabled = true;
+}
+
+const char *CGIResponseRelay::data() const
+{
+    return _queue.data() + _queueSent;
+}
+
+std::size_t CGIResponseRelay::size() const
+{
+    return _queue.size() - _queueSent;
+}
+
+void CGIResponseRelay::consume(std::size_t count)
+{
+    _queueSent += count;
+    if (_queueSent == _queue.size())
+    {
+        _queue.clear();
+        _queueSent = 0;
+    }
+    else if (_queueSent >= CGI_RELAY_BUFFER_SIZE / 2)
+    {
+        // Keeps the queue from growing while the client takes it in small pieces
+        _queue.erase(0, _queueSent);
+        _queueSent = 0;
+    }
+}
+
+bool CGIResponseRelay::isDrained() const
+{
+    return _finished && size() == 0;
+}
+
+bool CGIResponseRelay::isFull() const
+{
+    return size() + _early.size() >= CGI_RELAY_BUFFER_SIZE;
+}
+
+bool CGIResponseRelay::isPaused() const
+{
+    return _paused;
+}
+
+void CGIResponseRelay::setPaused(bool paused)
+{
+    _paused = paused;
+}
+
+void CGIResponseRelay::relayBody(std::string_view body)
+{
+    if (_discard || body.empty())
+        return;
+    if (_framing == LENGTH)
+    {
+        // Output beyond the announced length isn't part of the response
+        body = body.substr(0, std::min(body.size(), _remaining));
+        _remaining -= body.size();
+    }
+    if (_capturing)
+    {
+        if (_captured.size() + body.size() <= _captureLimit)
+            _captured.append(body);
+        else
+        {
+            _capturing = false;
+            _captured = std::string{};
+        }
+    }
+    if (_gzip == nullptr)
+        return queue(body);
+    std::string compressed;
+    _gzip->update(body, compressed);
+    queue(compressed);
+}
+
+void CGIResponseRelay::queue(std::string_view data)
+{
+    if (data.empty())
+        return;
+    if (_framing != CHUNKED)
+    {
+        _queue.append(data);
+        return;
+    }
+    char sizeLine[24];
+    const int sizeLineLength{std::snprintf(sizeLine, sizeof(sizeLine), "%zx\r\n", data.size())};
+    _queue.append(sizeLine, static_cast<std::size_t>(sizeLineLength));
+    _queue.append(data);
+    _queue += "\r\n";
+}
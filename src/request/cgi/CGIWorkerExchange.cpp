@@ -0,0 +1,168 @@
+#include "CGIWorkerExchange.hpp"
+
+#include <cerrno>
+#include <cstring> /* strerror() */
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+
+namespace
+{
+constexpr std::size_t RESPONSE_HEADER_LENGTH{8};
+constexpr std::size_t RECEIVE_BUFFER_SIZE{16384};
+
+void appendU32(std::string &out, std::size_t value)
+{
+    out += static_cast<char>((value >> 24) & 0xFF);
+    out += static_cast<char>((value >> 16) & 0xFF);
+    out += static_cast<char>((value >> 8) & 0xFF);
+    out += static_cast<char>(value & 0xFF);
+}
+
+std::uint32_t readU32(const std::string &in, std::size_t pos)
+{
+    const auto *bytes{reinterpret_cast<const unsigned char *>(in.data() + pos)};
+    return static_cast<std::uint32_t>(bytes[0]) << 24 | static_cast<std::uint32_t>(bytes[1]) << 16 |
+           static_cast<std::uint32_t>(bytes[2]) << 8 | bytes[3];
+}
+} // namespace
+
+CGIWorkerExchange::CGIWorkerExchange(CGIWorkerPool &pool, std::string interpreter,
+                                     const std::unordered_map<std::string, std::string> &env, std::string_view body)
+    : _pool(pool)
+    , _interpreter(std::move(interpreter))
+{
+    std::string environment;
+    for (const auto &[name, value] : env)
+    {
+        environment += name;
+        environment += '=';
+        environment += value;
+        environment += '\0';
+    }
+    _request.reserve(8 + environment.size() + body.size());
+    appendU32(_request, environment.size());
+    _request += environment;
+    appendU32(_request, body.size());
+    _request += body;
+
+    _worker = _pool.acquire(_interpreter, this);
+    _waiting = _worker == nullptr;
+}
+
+CGIWorkerExchange::~CGIWorkerExchange()
+{
+    releaseConnection();
+}
+
+void CGIWorkerExchange::start(CGIWorkerPool::Worker *worker)
+{
+    _worker = worker;
+    _waiting = false;
+}
+
+int CGIWorkerExchange::getFd() const
+{
+    return _worker != nullptr ? _worker->fd : -1;
+}
+
+short CGIWorkerExchange::getEvents() const
+{
+    if (isDone() || _worker == nullptr)
+        return 0;
+    if (_sent < _request.size())
+        return POLLOUT | POLLIN;
+    return POLLIN;
+}
+
+void CGIWorkerExchange::handleEvents(short revents)
+{
+    if (isDone() || _worker == nullptr)
+        return;
+    if (_sent < _request.size() && (revents & (POLLOUT | POLLERR | POLLHUP)))
+        sendRequest();
+    if (!isDone() && (revents & (POLLIN | POLLERR | POLLHUP)))
+        receiveResponse();
+}
+
+bool CGIWorkerExchange::isDone() const
+{
+    return _complete || _broken;
+}
+
+bool CGIWorkerExchange::hasFailed() const
+{
+    return _broken || _status != 0;
+}
+
+bool CGIWorkerExchange::isGateway() const
+{
+    return false;
+}
+
+std::string CGIWorkerExchange::takeOutput()
+{
+    if (!_complete)
+        return "";
+    return _response.substr(RESPONSE_HEADER_LENGTH);
+}
+
+void CGIWorkerExchange::releaseConnection()
+{
+    if (_waiting)
+        _pool.cancel(_interpreter, this);
+    else if (_worker != nullptr)
+        // A worker that didn't finish its request (e.g., on timeout) may still be running the script
+        _pool.release(_interpreter, _worker, _broken || !_complete);
+    _waiting = false;
+    _worker = nullptr;
+}
+
+void CGIWorkerExchange::fail(const std::string &reason)
+{
+    std::cerr << "CGI worker for " << _interpreter << " failed: " << reason << '\n';
+    _broken = true;
+}
+
+void CGIWorkerExchange::sendRequest()
+{
+    while (_sent < _request.size())
+    {
+        ssize_t bytesSent{send(_worker->fd, _request.data() + _sent, _request.size() - _sent, MSG_NOSIGNAL | MSG_DONTWAIT)};
+        if (bytesSent < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            return fail("send() failed: " + std::string(strerror(errno)));
+        }
+        _sent += static_cast<std::size_t>(bytesSent);
+    }
+}
+
+void CGIWorkerExchange::receiveResponse()
+{
+    char buffer[RECEIVE_BUFFER_SIZE];
+    while (!isDone())
+    {
+        ssize_t bytesRead{recv(_worker->fd, buffer, sizeof(buffer), MSG_DONTWAIT)};
+        if (bytesRead < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            return fail("recv() failed: " + std::string(strerror(errno)));
+        }
+        if (bytesRead == 0)
+            return fail("worker exited before the end of the response");
+        _response.append(buffer, static_cast<std::size_t>(bytesRead));
+        if (_response.size() < RESPONSE_HEADER_LENGTH)
+            continue;
+        const std::size_t expected{RESPONSE_HEADER_LENGTH + readU32(_response, 4)};
+        if (_response.size() > expected)
+            return fail("worker sent more than its response");
+        if (_response.size() == expected)
+        {
+            _status = readU32(_response, 0);
+            _complete = true;
+        }
+    }
+}
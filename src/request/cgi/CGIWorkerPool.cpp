@@ -0,0 +1,169 @@
+#include "CGIWorkerPool.hpp"
+#include "CGIWorkerExchange.hpp"
+
+#include <algorithm> /* std::find() */
+#include <cerrno>
+#include <csignal>   /* kill() */
+#include <cstring>   /* strerror() */
+#include <iostream>
+#include <spawn.h>   /* posix_spawn() */
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+CGIWorkerPool::CGIWorkerPool(std::map<std::string, Settings> settings)
+{
+    for (auto &[interpreter, groupSettings] : settings)
+        _groups.emplace(interpreter, Group{std::move(groupSettings)});
+}
+
+CGIWorkerPool::~CGIWorkerPool()
+{
+    // Workers exit when their socket is closed; the ones still running a script are stopped
+    for (auto &[_, group] : _groups)
+    {
+        for (auto &worker : group.workers)
+        {
+            close(worker->fd);
+            kill(worker->pid, SIGTERM);
+            _exiting.push_back(worker->pid);
+        }
+    }
+    for (pid_t pid : _exiting)
+        waitpid(pid, nullptr, 0);
+}
+
+bool CGIWorkerPool::handles(const std::string &interpreter) const
+{
+    return _groups.find(interpreter) != _groups.end();
+}
+
+CGIWorkerPool::Worker *CGIWorkerPool::acquire(const std::string &interpreter, CGIWorkerExchange *exchange)
+{
+    reap();
+    Group &group{_groups.at(interpreter)};
+    // A worker may have died while it was idle (killed, or its interpreter crashed); it's replaced instead of failing
+    // the request
+    while (!group.idle.empty())
+    {
+        Worker *worker{group.idle.back()};
+        group.idle.pop_back();
+        if (isAlive(*worker))
+            return worker;
+        std::cerr << "CGI worker " << worker->pid << " is gone, replacing it" << '\n';
+        retire(group, worker);
+    }
+    if (group.workers.size() < group.settings.size)
+        return spawn(interpreter, group);
+    group.waiting.push_back(exchange);
+    return nullptr;
+}
+
+void CGIWorkerPool::cancel(const std::string &interpreter, CGIWorkerExchange *exchange)
+{
+    auto &waiting{_groups.at(interpreter).waiting};
+    auto  found{std::find(waiting.begin(), waiting.end(), exchange)};
+    if (found != waiting.end())
+        waiting.erase(found);
+}
+
+void CGIWorkerPool::release(const std::string &interpreter, Worker *worker, bool broken)
+{
+    reap();
+    Group &group{_groups.at(interpreter)};
+    ++worker->served;
+    if (broken || worker->served >= group.settings.maxRequests)
+    {
+        retire(group, worker);
+        worker = nullptr;
+    }
+    if (group.waiting.empty())
+    {
+        if (worker != nullptr)
+            group.idle.push_back(worker);
+        return;
+    }
+
+    // The next request in line takes this worker, or a new one in place of a retired worker
+    if (worker == nullptr)
+    {
+        try
+        {
+            worker = spawn(interpreter, group);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            return;
+        }
+    }
+    CGIWorkerExchange *next{group.waiting.front()};
+    group.waiting.pop_front();
+    next->start(worker);
+}
+
+CGIWorkerPool::Worker *CGIWorkerPool::spawn(const std::string &interpreter, Group &group)
+{
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) == -1)
+        throw std::runtime_error("Failed to create socket pair for CGI worker: " + std::string{strerror(errno)});
+
+    // The worker's end becomes its stdin and stdout (dup2() clears close-on-exec on those)
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, sockets[1], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, sockets[1], STDOUT_FILENO);
+    char *args[] = {const_cast<char *>(interpreter.c_str()), const_cast<char *>(group.settings.worker.c_str()), nullptr};
+    pid_t pid;
+    int   error{posix_spawn(&pid, interpreter.c_str(), &actions, nullptr, args, environ)};
+    posix_spawn_file_actions_destroy(&actions);
+    close(sockets[1]);
+    if (error != 0)
+    {
+        close(sockets[0]);
+        throw std::runtime_error("Failed to start CGI worker " + group.settings.worker + ": " + strerror(error));
+    }
+
+    auto worker{std::make_unique<Worker>()};
+    worker->pid = pid;
+    worker->fd = sockets[0];
+    group.workers.push_back(std::move(worker));
+    return group.workers.back().get();
+}
+
+void CGIWorkerPool::retire(Group &group, Worker *worker)
+{
+    close(worker->fd);
+    kill(worker->pid, SIGTERM);
+    _exiting.push_back(worker->pid);
+    for (auto it{group.workers.begin()}; it != group.workers.end(); ++it)
+    {
+        if (it->get() == worker)
+        {
+            group.workers.erase(it);
+            break;
+        }
+    }
+}
+
+bool CGIWorkerPool::isAlive(const Worker &worker)
+{
+    char          byte;
+    const ssize_t peeked{recv(worker.fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT)};
+    // An idle worker has nothing to send: end of stream, an error or stray bytes all mean it can't serve a request
+    return peeked == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+void CGIWorkerPool::reap()
+{
+    for (auto it{_exiting.begin()}; it != _exiting.end();)
+    {
+        if (waitpid(*it, nullptr, WNOHANG) != 0)
+            it = _exiting.erase(it);
+        else
+            ++it;
+    }
+}
@@ -0,0 +1,150 @@
+#include "FastCGICodec.hpp"
+
+#include <algorithm> /* std::min() */
+
+namespace
+{
+constexpr std::uint8_t  FASTCGI_VERSION{1};
+constexpr std::size_t   HEADER_LENGTH{8};
+constexpr std::size_t   MAX_CONTENT_LENGTH{65535};
+constexpr std::uint16_t ROLE_RESPONDER{1};
+constexpr std::uint8_t  FLAG_KEEP_CONN{1};
+constexpr std::uint8_t  PROTOCOL_REQUEST_COMPLETE{0};
+} // namespace
+
+FastCGICodec::FastCGICodec(std::uint16_t requestId)
+    : _request_id(requestId)
+{
+}
+
+void FastCGICodec::appendHeader(std::string &out, RecordType type, std::uint16_t requestId, std::size_t contentLength)
+{
+    // Content is padded to a multiple of 8 bytes, as the specification recommends
+    const std::size_t padding{(8 - contentLength % 8) % 8};
+    out += static_cast<char>(FASTCGI_VERSION);
+    out += static_cast<char>(type);
+    out += static_cast<char>(requestId >> 8);
+    out += static_cast<char>(requestId & 0xFF);
+    out += static_cast<char>(contentLength >> 8);
+    out += static_cast<char>(contentLength & 0xFF);
+    out += static_cast<char>(padding);
+    out += '\0';
+}
+
+void FastCGICodec::appendLength(std::string &out, std::size_t length)
+{
+    // One byte for short lengths, four (with the high bit set) for the rest
+    if (length < 128)
+    {
+        out += static_cast<char>(length);
+        return;
+    }
+    out += static_cast<char>(((length >> 24) & 0x7F) | 0x80);
+    out += static_cast<char>((length >> 16) & 0xFF);
+    out += static_cast<char>((length >> 8) & 0xFF);
+    out += static_cast<char>(length & 0xFF);
+}
+
+void FastCGICodec::appendBeginRequest(std::string &out, std::uint16_t requestId, bool keepConnection)
+{
+    appendHeader(out, BEGIN_REQUEST, requestId, 8);
+    out += static_cast<char>(ROLE_RESPONDER >> 8);
+    out += static_cast<char>(ROLE_RESPONDER & 0xFF);
+    out += static_cast<char>(keepConnection ? FLAG_KEEP_CONN : 0);
+    out.append(5, '\0');
+}
+
+void FastCGICodec::appendParams(std::string &out, std::uint16_t requestId, const std::unordered_map<std::string, std::string> &params)
+{
+    std::string pairs;
+    for (const auto &[name, value] : params)
+    {
+        appendLength(pairs, name.size());
+        appendLength(pairs, value.size());
+        pairs += name;
+        pairs += value;
+    }
+    appendStream(out, PARAMS, requestId, pairs);
+}
+
+void FastCGICodec::appendStream(std::string &out, RecordType type, std::uint16_t requestId, std::string_view data)
+{
+    out.reserve(out.size() + data.size() + (data.size() / MAX_CONTENT_LENGTH + 2) * (HEADER_LENGTH + 7));
+    while (!data.empty())
+    {
+        const std::size_t length{std::min(data.size(), MAX_CONTENT_LENGTH)};
+        appendHeader(out, type, requestId, length);
+        out.append(data.substr(0, length));
+        out.append((8 - length % 8) % 8, '\0');
+        data.remove_prefix(length);
+    }
+    appendHeader(out, type, requestId, 0);
+}
+
+FastCGICodec::Status FastCGICodec::feed(const char *data, std::size_t size)
+{
+    if (_status != INCOMPLETE)
+        return _status;
+    _pending.append(data, size);
+
+    std::size_t pos{0};
+    while (_status == INCOMPLETE && _pending.size() - pos >= HEADER_LENGTH)
+    {
+        const auto       *header{reinterpret_cast<const unsigned char *>(_pending.data() + pos)};
+        const std::size_t contentLength{static_cast<std::size_t>(header[4] << 8 | header[5])};
+        const std::size_t recordLength{HEADER_LENGTH + contentLength + header[6]};
+        if (header[0] != FASTCGI_VERSION)
+        {
+            _status = FAILED;
+            break;
+        }
+        if (_pending.size() - pos < recordLength)
+            break; // The rest of the record hasn't arrived yet
+
+        const std::uint16_t requestId{static_cast<std::uint16_t>(header[2] << 8 | header[3])};
+        const char         *content{_pending.data() + pos + HEADER_LENGTH};
+        if (requestId == _request_id)
+        {
+            if (header[1] == STDOUT)
+                _stdout.append(content, contentLength);
+            else if (header[1] == STDERR)
+                _stderr.append(content, contentLength);
+            else if (header[1] == END_REQUEST)
+            {
+                if (contentLength < 8)
+                    _status = FAILED;
+                else
+                {
+                    const auto *body{reinterpret_cast<const unsigned char *>(content)};
+                    _app_status = static_cast<std::uint32_t>(body[0]) << 24 | static_cast<std::uint32_t>(body[1]) << 16 |
+                                  static_cast<std::uint32_t>(body[2]) << 8 | body[3];
+                    _status = body[4] == PROTOCOL_REQUEST_COMPLETE ? COMPLETE : FAILED;
+                }
+            }
+        }
+        // Management records (request id 0) and records of other requests are skipped
+        pos += recordLength;
+    }
+    _pending.erase(0, pos);
+    return _status;
+}
+
+FastCGICodec::Status FastCGICodec::getStatus() const
+{
+    return _status;
+}
+
+std::uint32_t FastCGICodec::getAppStatus() const
+{
+    return _app_status;
+}
+
+const std::string &FastCGICodec::getStderr() const
+{
+    return _stderr;
+}
+
+std::string FastCGICodec::takeStdout()
+{
+    return std::move(_stdout);
+}
@@ -0,0 +1,166 @@
+#include "FastCGIExchange.hpp"
+
+#include <cerrno>
+#include <cstring> /* strerror() */
+#include <iostream>
+#include <poll.h>
+#include <unistd.h> /* close() */
+
+namespace
+{
+// Only one request at a time goes over a connection, so they all use the same id
+constexpr std::uint16_t REQUEST_ID{1};
+constexpr std::size_t   RECEIVE_BUFFER_SIZE{16384};
+} // namespace
+
+FastCGIExchange::FastCGIExchange(FastCGIPool &pool, std::string address,
+                                 const std::unordered_map<std::string, std::string> &params, std::string_view body)
+    : _pool(pool)
+    , _address(std::move(address))
+    , _codec(REQUEST_ID)
+{
+    FastCGICodec::appendBeginRequest(_request, REQUEST_ID, true);
+    FastCGICodec::appendParams(_request, REQUEST_ID, params);
+    FastCGICodec::appendStream(_request, FastCGICodec::STDIN, REQUEST_ID, body);
+    connectUpstream(true);
+}
+
+FastCGIExchange::~FastCGIExchange()
+{
+    if (_fd != -1)
+        close(_fd);
+}
+
+int FastCGIExchange::getFd() const
+{
+    return _fd;
+}
+
+short FastCGIExchange::getEvents() const
+{
+    if (isDone())
+        return 0;
+    // Responders may answer before they've read the whole request
+    if (_connecting || _sent < _request.size())
+        return POLLOUT | POLLIN;
+    return POLLIN;
+}
+
+void FastCGIExchange::handleEvents(short revents)
+{
+    if (isDone())
+        return;
+    if (_connecting)
+    {
+        if (!(revents & (POLLOUT | POLLERR | POLLHUP)))
+            return;
+        int       error{0};
+        socklen_t length{sizeof(error)};
+        if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) == -1)
+            error = errno;
+        if (error != 0)
+            return fail("connect() failed: " + std::string(strerror(error)));
+        _connecting = false;
+    }
+    if (_sent < _request.size() && (revents & (POLLOUT | POLLERR | POLLHUP)))
+        sendRequest();
+    if (!isDone() && (revents & (POLLIN | POLLERR | POLLHUP)))
+        receiveResponse();
+}
+
+bool FastCGIExchange::isDone() const
+{
+    return _failed || _codec.getStatus() != FastCGICodec::INCOMPLETE;
+}
+
+bool FastCGIExchange::hasFailed() const
+{
+    return _failed || _codec.getStatus() == FastCGICodec::FAILED;
+}
+
+bool FastCGIExchange::isGateway() const
+{
+    return true;
+}
+
+std::string FastCGIExchange::takeOutput()
+{
+    if (!_codec.getStderr().empty())
+        std::cerr << "FastCGI responder " << _address << " stderr: " << _codec.getStderr() << '\n';
+    return _codec.takeStdout();
+}
+
+void FastCGIExchange::releaseConnection()
+{
+    if (_fd == -1)
+        return;
+    // Only a connection whose request completed cleanly is in a known state for the next one
+    if (_codec.getStatus() == FastCGICodec::COMPLETE && !_failed && _sent == _request.size())
+        _pool.release(_address, _fd);
+    else
+        close(_fd);
+    _fd = -1;
+}
+
+void FastCGIExchange::connectUpstream(bool allowIdle)
+{
+    _fd = _pool.acquire(_address, allowIdle, _reused);
+    _connecting = !_reused;
+    _sent = 0;
+}
+
+void FastCGIExchange::fail(const std::string &reason)
+{
+    close(_fd);
+    _fd = -1;
+    if (_reused && !_received)
+    {
+        // The responder probably closed the idle connection: send the request again on a new one
+        try
+        {
+            connectUpstream(false);
+            return;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+        }
+    }
+    std::cerr << "FastCGI request to " << _address << " failed: " << reason << '\n';
+    _failed = true;
+}
+
+void FastCGIExchange::sendRequest()
+{
+    while (_sent < _request.size())
+    {
+        ssize_t bytesSent{send(_fd, _request.data() + _sent, _request.size() - _sent, MSG_NOSIGNAL)};
+        if (bytesSent < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            return fail("send() failed: " + std::string(strerror(errno)));
+        }
+        _sent += static_cast<std::size_t>(bytesSent);
+    }
+}
+
+void FastCGIExchange::receiveResponse()
+{
+    char buffer[RECEIVE_BUFFER_SIZE];
+    while (!isDone())
+    {
+        ssize_t bytesRead{recv(_fd, buffer, sizeof(buffer), 0)};
+        if (bytesRead < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            return fail("recv() failed: " + std::string(strerror(errno)));
+        }
+        if (bytesRead == 0)
+            return fail("connection closed before the end of the response");
+        _received = true;
+        if (_codec.feed(buffer, static_cast<std::size_t>(bytesRead)) == FastCGICodec::FAILED)
+            return fail("malformed response records");
+    }
+}
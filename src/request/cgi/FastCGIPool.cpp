@@ -0,0 +1,111 @@
+#include "FastCGIPool.hpp"
+
+#include <cerrno>
+#include <cstring>   /* strerror() */
+#include <netdb.h>   /* getaddrinfo() */
+#include <stdexcept>
+#include <sys/un.h>  /* sockaddr_un */
+#include <unistd.h>  /* close() */
+
+FastCGIPool::FastCGIPool(std::size_t keepalive)
+    : _keepalive(keepalive)
+{
+}
+
+FastCGIPool::~FastCGIPool()
+{
+    for (auto &[_, upstream] : _upstreams)
+    {
+        for (int fd : upstream.idle)
+            close(fd);
+    }
+}
+
+int FastCGIPool::acquire(const std::string &address, bool allowIdle, bool &reused)
+{
+    Upstream &upstream{findUpstream(address)};
+    while (allowIdle && !upstream.idle.empty())
+    {
+        int fd{upstream.idle.back()};
+        upstream.idle.pop_back();
+        // A responder may have closed the connection while it was idle (recv() returns 0), or sent something unexpected
+        char    byte;
+        ssize_t peeked{recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT)};
+        if (peeked < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            reused = true;
+            return fd;
+        }
+        close(fd);
+    }
+
+    int fd{socket(upstream.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+    if (fd == -1)
+        throw std::runtime_error("FastCGI socket() failed: " + std::string(strerror(errno)));
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&upstream.address), upstream.addressLength) == -1 && errno != EINPROGRESS)
+    {
+        const int error{errno};
+        close(fd);
+        throw std::runtime_error("FastCGI connect() to " + address + " failed: " + strerror(error));
+    }
+    reused = false;
+    return fd;
+}
+
+void FastCGIPool::release(const std::string &address, int fd)
+{
+    auto found{_upstreams.find(address)};
+    if (found == _upstreams.end() || found->second.idle.size() >= _keepalive)
+    {
+        close(fd);
+        return;
+    }
+    found->second.idle.push_back(fd);
+}
+
+std::size_t FastCGIPool::getIdleCount() const
+{
+    std::size_t count{0};
+    for (const auto &[_, upstream] : _upstreams)
+        count += upstream.idle.size();
+    return count;
+}
+
+FastCGIPool::Upstream &FastCGIPool::findUpstream(const std::string &address)
+{
+    auto found{_upstreams.find(address)};
+    if (found != _upstreams.end())
+        return found->second;
+
+    Upstream upstream;
+    if (address.compare(0, 5, "unix:") == 0)
+    {
+        sockaddr_un unixAddress{};
+        unixAddress.sun_family = AF_UNIX;
+        const std::string path{address.substr(5)};
+        if (path.size() >= sizeof(unixAddress.sun_path))
+            throw std::runtime_error("FastCGI socket path is too long: " + path);
+        std::memcpy(unixAddress.sun_path, path.c_str(), path.size() + 1);
+        std::memcpy(&upstream.address, &unixAddress, sizeof(unixAddress));
+        upstream.addressLength = sizeof(unixAddress);
+    }
+    else
+    {
+        // The config parser made sure there is a port after the last colon
+        const std::size_t colonPos{address.rfind(':')};
+        std::string       host{address.substr(0, colonPos)};
+        if (host.size() > 2 && host.front() == '[' && host.back() == ']')
+            host = host.substr(1, host.size() - 2);
+        addrinfo  hints{};
+        addrinfo *result{nullptr};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        int status{getaddrinfo(host.c_str(), address.c_str() + colonPos + 1, &hints, &result)};
+        if (status != 0)
+            throw std::runtime_error("FastCGI address " + address + " could not be resolved: " + gai_strerror(status));
+        std::memcpy(&upstream.address, result->ai_addr, result->ai_addrlen);
+        upstream.addressLength = result->ai_addrlen;
+        freeaddrinfo(result);
+    }
+    return _upstreams.emplace(address, std::move(upstream)).first->second;
+}
@@ -0,0 +1,68 @@
+#include "GzipEncoder.hpp"
+
+namespace
+{
+constexpr int GZIP_WINDOW_BITS{15 + 16}; // Maximum window, plus 16 for a gzip header and trailer instead of zlib's
+constexpr int MEMORY_LEVEL{8};           // zlib's default
+} // namespace
+
+GzipEncoder::GzipEncoder(int level)
+{
+    if (deflateInit2(&_stream, level, Z_DEFLATED, GZIP_WINDOW_BITS, MEMORY_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("deflateInit2() failed");
+}
+
+GzipEncoder::~GzipEncoder()
+{
+    deflateEnd(&_stream);
+}
+
+void GzipEncoder::update(std::string_view in, std::string &out)
+{
+    if (_finished)
+        throw std::logic_error("GzipEncoder used after finish()");
+    _stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+    _stream.avail_in = static_cast<uInt>(in.size());
+    deflateInto(out, Z_NO_FLUSH);
+}
+
+void GzipEncoder::finish(std::string &out)
+{
+    if (_finished)
+        return;
+    _stream.next_in = nullptr;
+    _stream.avail_in = 0;
+    deflateInto(out, Z_FINISH);
+    _finished = true;
+}
+
+std::string GzipEncoder::compress(std::string_view in, int level)
+{
+    GzipEncoder encoder(level);
+    std::string out;
+    // Text usually shrinks to well under half; the string grows if it doesn't
+    out.reserve(in.size() / 3 + 64);
+    encoder.update(in, out);
+    encoder.finish(out);
+    return out;
+}
+
+void GzipEncoder::deflateInto(std::string &out, int flush)
+{
+    // Write straight into `out`, growing it until zlib has consumed all input (and, when finishing, ended the stream)
+    while (true)
+    {
+        std::size_t used{out.size()};
+        std::size_t room{deflateBound(&_stream, _stream.avail_in) + 64};
+        out.resize(used + room);
+        _stream.next_out = reinterpret_cast<Bytef *>(out.data() + used);
+        _stream.avail_out = static_cast<uInt>(room);
+
+        int result{deflate(&_stream, flush)};
+        out.resize(used + room - _stream.avail_out);
+        if (result == Z_STREAM_ERROR)
+            throw std::runtime_error("deflate() failed");
+        if (flush == Z_FINISH ? result == Z_STREAM_END : _stream.avail_in == 0)
+            return;
+    }
+}
@@ -1,39 +1,235 @@
 #include "ResponseWriter.hpp"
 
-ResponseWriter::ResponseWriter(int statusCode, const std::unordered_map<std::string, std::string> &headers, const std::string &response_body)
-    : _start_line(std::string("HTTP/1.1 ") + std::to_string(statusCode) + " " + reasonPhraseFromStatusCode(statusCode))
-    , _headers()
-    , _response_body(response_body)
+#include <charconv> /* std::to_chars() */
+#include <cstring>  /* std::memcpy() */
+#include <strings.h> /* strncasecmp() */
+
+namespace
+{
+constexpr std::array<std::string_view, ResponseWriter::HEADER_COUNT> HEADER_NAMES{
+    "Date",          "Server",        "Content-Type", "Content-Encoding", "Content-Length", "Content-Range",
+    "Accept-Ranges", "Last-Modified", "ETag",         "Vary",             "Cache-Control",  "Expires",
+    "Location"};
+
+constexpr std::string_view SERVER_NAME{"Webserv"};
+constexpr std::string_view CRLF{"\r\n"};
+constexpr std::string_view COLON_SPACE{": "};
+
+// Space for the decimal representation of any std::size_t
+constexpr std::size_t NUMBER_SCRATCH = 24;
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+// Appends `str` at `pos` and returns the new position
+char *append(char *pos, std::string_view str)
+{
+    if (!str.empty())
+        std::memcpy(pos, str.data(), str.size());
+    return pos + str.size();
+}
+} // namespace
+
+ResponseWriter::ResponseWriter(int statusCode)
+    : _status_code(statusCode)
 {
-    _headers["Date"] = getCurrentGMTString();
-    _headers["Server"] = "Webserv";
-    _headers["Content-Length"] = std::to_string(response_body.length());
+}
 
+ResponseWriter::ResponseWriter(int statusCode, std::initializer_list<HeaderField> headers, std::string response_body)
+    : _status_code(statusCode)
+    , _response_body(std::move(response_body))
+{
     for (const auto &[key, value] : headers)
-        _headers[key] = value;
+        addHeader(key, value);
+}
+
+std::string_view ResponseWriter::headerName(Header header)
+{
+    return HEADER_NAMES[header];
+}
+
+ResponseWriter::Slot ResponseWriter::store(std::string_view value)
+{
+    Slot slot;
+    slot.isSet = true;
+    slot.length = static_cast<std::uint32_t>(value.size());
+    if (_inline_used + value.size() <= INLINE_STORAGE)
+    {
+        std::memcpy(_inline.data() + _inline_used, value.data(), value.size());
+        slot.offset = static_cast<std::uint32_t>(_inline_used);
+        _inline_used += value.size();
+    }
+    else
+    {
+        slot.isSpilled = true;
+        slot.offset = static_cast<std::uint32_t>(_spilled.size());
+        _spilled.emplace_back(value);
+    }
+    return slot;
+}
+
+std::string_view ResponseWriter::view(const Slot &slot) const
+{
+    if (slot.isSpilled)
+        return _spilled[slot.offset];
+    return {_inline.data() + slot.offset, slot.length};
+}
+
+void ResponseWriter::setHeader(Header header, std::string_view value)
+{
+    // Replaced values are not reclaimed; headers are practically never overwritten more than once
+    _known[header] = store(value);
+}
+
+void ResponseWriter::addHeader(std::string_view name, std::string_view value)
+{
+    for (std::size_t i{0}; i < HEADER_COUNT; ++i)
+    {
+        if (equalsIgnoreCase(name, HEADER_NAMES[i]))
+            return setHeader(static_cast<Header>(i), value);
+    }
+    for (auto &[extraName, extraValue] : _extra)
+    {
+        if (equalsIgnoreCase(name, view(extraName)))
+        {
+            extraValue = store(value);
+            return;
+        }
+    }
+    Slot nameSlot{store(name)};
+    _extra.emplace_back(nameSlot, store(value));
 }
 
-void ResponseWriter::setBody(const std::string &body)
+void ResponseWriter::appendRawHeaders(std::string_view lines)
 {
-    _response_body = body;
+    if (!lines.empty())
+        _raw.push_back(store(lines));
 }
 
-std::string ResponseWriter::write()
+void ResponseWriter::setBody(std::string body)
 {
-    _headers["Content-Length"] = std::to_string(_response_body.length());
+    _response_body = std::move(body);
+}
+
+void ResponseWriter::setStreamedBody()
+{
+    _streamed_body = true;
+}
+
+int ResponseWriter::getStatusCode() const
+{
+    return _status_code;
+}
+
+std::string_view ResponseWriter::getHeader(Header header) const
+{
+    if (!_known[header].isSet)
+        return {};
+    return view(_known[header]);
+}
+
+const std::string &ResponseWriter::getBody() const
+{
+    return _response_body;
+}
+
+std::string_view ResponseWriter::renderedValue(Header header, char *scratch, std::size_t scratchSize) const
+{
+    if (_known[header].isSet)
+        return view(_known[header]);
+    switch (header)
+    {
+    case DATE:
+        return getCachedGMTString();
+    case SERVER:
+        return SERVER_NAME;
+    case CONTENT_LENGTH:
+    {
+        // Responses that never have a body don't get a Content-Length, nor do bodies sent separately
+        if (_status_code < 200 || _status_code == 204 || _status_code == 304 || _streamed_body)
+            return {};
+        auto result{std::to_chars(scratch, scratch + scratchSize, _response_body.length())};
+        return {scratch, static_cast<std::size_t>(result.ptr - scratch)};
+    }
+    default:
+        return {};
+    }
+}
+
+std::size_t ResponseWriter::headersSize() const
+{
+    char        scratch[NUMBER_SCRATCH];
+    auto        statusEnd{std::to_chars(scratch, scratch + sizeof(scratch), _status_code).ptr};
+    std::size_t size{std::string_view{"HTTP/1.1 "}.size() + static_cast<std::size_t>(statusEnd - scratch) + 1 +
+                     reasonPhraseFromStatusCode(_status_code).size() + CRLF.size()};
+
+    for (std::size_t i{0}; i < HEADER_COUNT; ++i)
+    {
+        auto value{renderedValue(static_cast<Header>(i), scratch, sizeof(scratch))};
+        if (value.data() != nullptr)
+            size += HEADER_NAMES[i].size() + COLON_SPACE.size() + value.size() + CRLF.size();
+    }
+    for (const auto &[name, value] : _extra)
+        size += name.length + COLON_SPACE.size() + value.length + CRLF.size();
+    for (const auto &lines : _raw)
+        size += lines.length;
+
+    return size + CRLF.size();
+}
 
-    std::string responseStr{_start_line + "\r\n"};
-    responseStr.reserve(200 + _response_body.length());
+std::size_t ResponseWriter::renderHeaders(char *buf, std::size_t capacity) const
+{
+    const std::size_t needed{headersSize()};
+    if (capacity < needed)
+        return needed;
+
+    char  scratch[NUMBER_SCRATCH];
+    char *pos{append(buf, "HTTP/1.1 ")};
+    pos = std::to_chars(pos, buf + capacity, _status_code).ptr;
+    *pos++ = ' ';
+    pos = append(pos, reasonPhraseFromStatusCode(_status_code));
+    pos = append(pos, CRLF);
 
-    for (const auto &[key, value] : _headers)
+    for (std::size_t i{0}; i < HEADER_COUNT; ++i)
     {
-        responseStr.append(key + ": ");
-        responseStr.append(value + "\r\n");
+        auto value{renderedValue(static_cast<Header>(i), scratch, sizeof(scratch))};
+        if (value.data() == nullptr)
+            continue;
+        pos = append(pos, HEADER_NAMES[i]);
+        pos = append(pos, COLON_SPACE);
+        pos = append(pos, value);
+        pos = append(pos, CRLF);
     }
+    for (const auto &[name, value] : _extra)
+    {
+        pos = append(pos, view(name));
+        pos = append(pos, COLON_SPACE);
+        pos = append(pos, view(value));
+        pos = append(pos, CRLF);
+    }
+    for (const auto &lines : _raw)
+        pos = append(pos, view(lines));
+    append(pos, CRLF);
 
-    responseStr.append("\r\n");
+    return needed;
+}
 
-    responseStr.append(_response_body);
+void ResponseWriter::writeTo(std::string &out) const
+{
+    const std::size_t start{out.size()};
+    const std::size_t headers_size{headersSize()};
+
+    out.resize(start + headers_size);
+    renderHeaders(out.data() + start, headers_size);
+    out.append(_response_body);
+}
 
+std::string ResponseWriter::write() const
+{
+    std::string responseStr;
+    responseStr.reserve(headersSize() + _response_body.length());
+    writeTo(responseStr);
     return responseStr;
 }
@@ -30,50 +30,50 @@ void DELETERequest::generateResponse(Server *server, int clientFd)
     if (_effective_config->getReturn().first != -1)
         return handleRedirection(_effective_config->getReturn());
 
-    // Resolve target resource path
-    std::filesystem::path targetPath{_effective_config->getRoot()};
-    targetPath /= splitUriIntoPathAndQuery(getURInoLeadingSlash()).first; // get rid of query string
+    // Locations passed to a FastCGI responder leave everything else to it
+    if (!_effective_config->getFastCGIPass().empty())
+        return serveFastCGI();
 
     // Prevent escaping root
-    std::filesystem::path safePath;
-    if (!normalizeAndValidateUnderRoot(targetPath, safePath))
+    if (!_resolution->underRoot)
         return errorResponse(403);
+    const std::filesystem::path safePath{_resolution->filePath};
 
-    if (!std::filesystem::exists(safePath))
+    OpenFileCache          &fileCache{_server->getOpenFileCache()};
+    OpenFileCache::EntryPtr target{fileCache.lookup(safePath)};
+    if (!target->exists)
         return errorResponse(404);
 
     // If path exists and is a directory, check for index files
     std::filesystem::path cgiPath = safePath;
-    if (std::filesystem::is_directory(safePath))
+    const std::string    *cgiInterpreter{_resolution->cgiInterpreter};
+    if (target->isDirectory)
     {
-        for (const auto &file : _effective_config->getIndexFilesVec())
+        const std::string &indexFile{findIndexFile()};
+        if (!indexFile.empty())
         {
-            std::filesystem::path indexPath = safePath / file;
-            if (std::filesystem::exists(indexPath))
-            {
-                cgiPath = indexPath;
-                break;
-            }
+            cgiPath = indexFile;
+            cgiInterpreter = _resolution->indexCGIInterpreter;
         }
     }
 
     // Check if path matches any CGI handler
-    for (const auto &[extension, interpreter] : _effective_config->getCGIHandlersMap())
+    if (cgiInterpreter != nullptr)
     {
-        if (cgiPath.extension().string() == extension)
-        {
-            std::cout << "CGI detected for: " << cgiPath << std::endl;
-            return serveCGI(cgiPath, interpreter);
-        }
+        std::cout << "CGI detected for: " << cgiPath << std::endl;
+        return serveCGI(cgiPath, *cgiInterpreter);
     }
 
     // Don't allow deletion of directories
-    if (std::filesystem::is_directory(safePath))
+    if (target->isDirectory)
         return errorResponse(403);
 
     // Remove the file
     std::error_code ec;
     bool            removed = std::filesystem::remove(safePath, ec);
+    fileCache.invalidate(safePath);
+    _server->getContentCache().clear();
+    _server->getResolutionCache().forgetIndexFiles();
     if (ec)
         return errorResponse(500);
 
@@ -81,12 +81,19 @@ void DELETERequest::generateResponse(Server *server, int clientFd)
         return errorResponse(404);
 
     ResponseWriter response(200, {{"Content-Type", "text/plain"}}, std::string("Deleted \"") + safePath.filename().string() + "\"\n");
-    _fullResponse = response.write();
+    _fullResponse = renderResponse(response);
     _responseState = READY;
 }
 
 void DELETERequest::continuePrevious()
 {
+    if (_cgiWaitingScript.has_value())
+        return continueWaitingForCGISlot();
+    if (_upstream != nullptr)
+        return continueUpstream();
+    if (_cgiRelay != nullptr)
+        return continueCGI();
+
     std::size_t num_ready{0};
     for (auto &[fileFd, fileData] : _clientData->openFiles)
     {
@@ -95,14 +102,7 @@ void DELETERequest::continuePrevious()
             if (fileData.fileType == OpenFile::READ)
             {
                 ++num_ready;
-                if (fileData.isCGI && _cgiSubprocess != nullptr)
-                    cgiOutputToResponse(fileData.content);
-                else if (_responseWithoutBody != nullptr)
-                {
-                    // non-CGI read
-                    _responseWithoutBody->setBody(fileData.content);
-                    _fullResponse = _responseWithoutBody->write();
-                }
+                // CGI output is relayed, see continueCGI()
             }
             else if (fileData.fileType == OpenFile::WRITE)
             {
@@ -113,9 +113,6 @@ void DELETERequest::continuePrevious()
     }
     if (num_ready == _clientData->openFiles.size())
     {
-        if (_cgiStartTime.has_value()) // A CGI process exists
-            return checkCGIstatus();
-        else // No CGI process exists
-            _responseState = READY;
+        _responseState = READY;
     }
 }
@@ -32,12 +32,7 @@ void ErrorRequest::continuePrevious()
             if (fileData.fileType == OpenFile::READ)
             {
                 ++num_ready;
-                if (_responseWithoutBody)
-                {
-                    // no CGI here
-                    _responseWithoutBody->setBody(fileData.content);
-                    _fullResponse = _responseWithoutBody->write();
-                }
+                // no CGI here, and error pages are sent with sendfile()
             }
             else if (fileData.fileType == OpenFile::WRITE)
             {
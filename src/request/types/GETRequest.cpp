@@ -18,8 +18,10 @@ void GETRequest::generateResponse(Server *server, int clientFd)
 
     _responseState = IN_PROGRESS;
 
-    // Check if GET requests for this URI are allowed
-    if (_effective_config->getLimitExcept().find("get") == _effective_config->getLimitExcept().end())
+    // Check if GET requests for this URI are allowed (allowing GET also allows HEAD)
+    const auto &allowedMethods{_effective_config->getLimitExcept()};
+    if (allowedMethods.find("get") == allowedMethods.end() &&
+        (_data.method != HEAD || allowedMethods.find("head") == allowedMethods.end()))
     {
         // Method not allowed
         return errorResponse(405);
@@ -31,33 +33,41 @@ void GETRequest::generateResponse(Server *server, int clientFd)
         return handleRedirection(_effective_config->getReturn());
     }
 
-    std::filesystem::path resourcePath{_effective_config->getRoot()};
-    std::string           uri{splitUriIntoPathAndQuery(_data.uri).first};
-    removeLeadingSlash(uri);
-    resourcePath /= uri; // resourcePath = root + requested URI
+    // Metrics endpoints answer with the server's counters instead of files
+    if (_effective_config->getMetrics())
+        return serveMetrics();
+
+    // Locations passed to a FastCGI responder leave everything else to it
+    if (!_effective_config->getFastCGIPass().empty())
+        return serveFastCGI();
 
     // Prevent escaping root
-    std::filesystem::path safePath;
-    if (!normalizeAndValidateUnderRoot(resourcePath, safePath))
+    if (!_resolution->underRoot)
         return errorResponse(403);
+    const std::string &safePath{_resolution->filePath}; // root + requested URI, normalized
+
+    // Paths the root index knows aren't there are rejected without touching the filesystem
+    const RootIndex &rootIndex{_server->getRootIndex()};
+    if (rootIndex.lookup(safePath) == RootIndex::MISSING)
+        return errorResponse(404);
 
-    if (std::filesystem::exists(safePath))
+    OpenFileCache          &fileCache{_server->getOpenFileCache()};
+    OpenFileCache::EntryPtr resource{fileCache.lookup(safePath)};
+    if (resource->exists)
     {
         // look for index file. if not found, return either directory listing or error
-        if (std::filesystem::is_directory(safePath))
+        if (resource->isDirectory)
         {
-            for (const auto &file : _effective_config->getIndexFilesVec())
-            {
-                // Join paths: requested URI dir + index file name
-                std::filesystem::path curFilePath{safePath / file};
-                // Commit to serving this file if it exists, even if permission denied
-                if (std::filesystem::exists(curFilePath))
-                    return serveFile(curFilePath);
-            }
+            const std::string &indexFile{findIndexFile()};
+            if (!indexFile.empty())
+                return serveFile(indexFile, fileCache.lookup(indexFile), _resolution->indexCGIInterpreter);
             if (_effective_config->getAutoIndex())
             {
-                ResponseWriter response(200, {{"Content-Type", "text/html"}}, getDirectoryListingBody(safePath));
-                _fullResponse = response.write();
+                std::string listing;
+                if (!getDirectoryListingBody(safePath, listing))
+                    return errorResponse(404);
+                ResponseWriter response(200, {{"Content-Type", "text/html"}}, std::move(listing));
+                _fullResponse = renderResponse(response);
                 _responseState = READY;
                 return;
             }
@@ -65,7 +75,7 @@ void GETRequest::generateResponse(Server *server, int clientFd)
         else
         {
             // requested resource is a file
-            return serveFile(safePath);
+            return serveFile(safePath, std::move(resource), _resolution->cgiInterpreter);
         }
     }
 
@@ -73,17 +83,20 @@ void GETRequest::generateResponse(Server *server, int clientFd)
     errorResponse(404);
 }
 
-void GETRequest::serveFile(const std::filesystem::path &filePath)
+void GETRequest::serveFile(const std::filesystem::path &filePath, OpenFileCache::EntryPtr file, const std::string *cgiInterpreter)
 {
-    for (const auto &[extension, interpreter] : _effective_config->getCGIHandlersMap())
-    {
-        if (filePath.extension().string() == extension)
-            return serveCGI(filePath, interpreter);
-    }
+    if (cgiInterpreter != nullptr)
+        return serveCGI(filePath, *cgiInterpreter);
     try
     {
-        // Will throw if fail to open fd
-        openFileSetHeaders(filePath);
+        const std::string_view mimeType{file->mimeType};
+        std::string_view       contentEncoding{};
+        bool                   varyOnEncoding{false};
+        if (file->fd != -1 && (_effective_config->getBrotliStatic() || _effective_config->getGzipStatic()))
+            file = selectPrecompressedVariant(filePath, std::move(file), contentEncoding, varyOnEncoding);
+
+        // Will throw if the file could not be opened
+        serveStaticFile(filePath, std::move(file), mimeType, contentEncoding, varyOnEncoding);
 
         return;
     }
@@ -96,8 +109,259 @@ void GETRequest::serveFile(const std::filesystem::path &filePath)
     errorResponse(403);
 }
 
+void GETRequest::serveMetrics()
+{
+    ResponseWriter response(200, {{"Content-Type", "text/plain; version=0.0.4"}, {"Cache-Control", "no-store"}},
+                            _server->renderMetrics());
+    _fullResponse = renderResponse(response);
+    _responseState = READY;
+}
+
+OpenFileCache::EntryPtr GETRequest::selectPrecompressedVariant(const std::filesystem::path &filePath, OpenFileCache::EntryPtr file,
+                                                               std::string_view &contentEncoding, bool &varyOnEncoding)
+{
+    struct Variant
+    {
+        bool             enabled;
+        std::string_view coding;
+        const char      *suffix;
+    };
+    // Brotli first: it wins ties since it usually compresses better
+    const Variant variants[]{{_effective_config->getBrotliStatic(), "br", ".br"},
+                             {_effective_config->getGzipStatic(), "gzip", ".gz"}};
+
+    auto             acceptEncodingHeader{_data.headers.find("accept-encoding")};
+    std::string_view acceptEncoding{};
+    if (acceptEncodingHeader != _data.headers.end())
+        acceptEncoding = acceptEncodingHeader->second;
+    OpenFileCache   &fileCache{_server->getOpenFileCache()};
+    const RootIndex &rootIndex{_server->getRootIndex()};
+    int              bestQuality{0};
+    for (const auto &variant : variants)
+    {
+        if (!variant.enabled)
+            continue;
+        // Checked even if the client doesn't accept the coding: the response varies as soon as a variant exists
+        std::string siblingPath{filePath.string() + variant.suffix};
+        if (rootIndex.lookup(siblingPath) == RootIndex::MISSING)
+            continue;
+        OpenFileCache::EntryPtr sibling{fileCache.lookup(siblingPath)};
+        if (sibling->fd == -1)
+            continue;
+        varyOnEncoding = true;
+        int quality{acceptEncodingQuality(acceptEncoding, variant.coding)};
+        if (quality > bestQuality)
+        {
+            bestQuality = quality;
+            contentEncoding = variant.coding;
+            file = std::move(sibling);
+        }
+    }
+    return file;
+}
+
+bool GETRequest::isNotModified(const std::string &etag, std::time_t lastModified) const
+{
+    // If-None-Match takes precedence; If-Modified-Since is only evaluated without it (RFC 9110, section 13.2.2)
+    auto ifNoneMatch{_data.headers.find("if-none-match")};
+    if (ifNoneMatch != _data.headers.end())
+        return etagListMatches(ifNoneMatch->second, etag, true);
+
+    auto        ifModifiedSince{_data.headers.find("if-modified-since")};
+    std::time_t since;
+    if (ifModifiedSince != _data.headers.end() && parseHTTPDate(ifModifiedSince->second, since))
+        return lastModified <= since;
+    return false;
+}
+
+bool GETRequest::rangeIsApplicable(const std::string &etag, const std::string &lastModified) const
+{
+    auto ifRange{_data.headers.find("if-range")};
+    // Without `If-Range`, the range is always applicable. Otherwise the validator must match exactly
+    if (ifRange == _data.headers.end())
+        return true;
+    // An empty validator matches nothing: the whole representation is sent
+    if (ifRange->second.empty())
+        return false;
+    if (ifRange->second.front() == '"' || ifRange->second.compare(0, 2, "W/") == 0)
+        return etagListMatches(ifRange->second, etag, false);
+    return ifRange->second == lastModified;
+}
+
+void GETRequest::serveStaticFile(const std::filesystem::path &filePath, OpenFileCache::EntryPtr file,
+                                 std::string_view mimeType, std::string_view contentEncoding, bool varyOnEncoding)
+{
+    // Size and validators come from the open file cache, so revalidations and hot files cost no syscalls
+    if (file->fd == -1)
+        throw std::runtime_error(strerror(file->error));
+
+    _bodyFile = std::move(file);
+
+    const std::size_t  fileSize{_bodyFile->size};
+    const std::string &lastModified{_bodyFile->lastModified};
+    const int          fd{_bodyFile->fd};
+
+    // Text without a precompressed variant can be gzipped on the fly (once per file version, thanks to the gzip cache).
+    // Range requests are answered from the uncompressed file
+    const GzipDirectives &gzip{_effective_config->getGzipDirectives()};
+    GzipCache            &gzipCache{_server->getGzipCache()};
+    const bool gzipApplies{gzip.isEnabled() && contentEncoding.empty() && fileSize >= GZIP_MIN_LENGTH &&
+                           gzipCache.admits(fileSize) && gzip.compressesType(mimeType)};
+    const bool compress{gzipApplies && acceptsGzip() && _data.headers.find("range") == _data.headers.end()};
+    varyOnEncoding = varyOnEncoding || gzipApplies;
+    // The compressed representation needs its own entity tag
+    std::string etag{_bodyFile->etag};
+    if (compress)
+        etag.insert(etag.size() - 1, "-gzip");
+
+    if (isNotModified(etag, _bodyFile->mtime))
+    {
+        ResponseWriter response(304);
+        response.setHeader(ResponseWriter::LAST_MODIFIED, lastModified);
+        response.setHeader(ResponseWriter::ETAG, etag);
+        if (varyOnEncoding)
+            response.setHeader(ResponseWriter::VARY, "Accept-Encoding");
+        _fullResponse = renderResponse(response);
+        _responseState = READY;
+        return;
+    }
+
+    std::vector<ByteRange> ranges;
+    ByteRangeStatus        rangeStatus{RANGE_IGNORED};
+    auto                   rangeHeader{_data.headers.find("range")};
+    if (rangeHeader != _data.headers.end() && rangeIsApplicable(etag, lastModified))
+        rangeStatus = parseByteRanges(rangeHeader->second, fileSize, ranges);
+
+    if (rangeStatus == RANGE_UNSATISFIABLE)
+    {
+        ResponseWriter response(416, {{"Content-Type", "text/html"}}, getMinimalErrorDefaultBody(416));
+        response.setHeader(ResponseWriter::CONTENT_RANGE, "bytes */" + std::to_string(fileSize));
+        _fullResponse = renderResponse(response);
+        _responseState = READY;
+        return;
+    }
+
+    ResponseWriter response(rangeStatus == RANGE_SATISFIABLE ? 206 : 200);
+    response.setHeader(ResponseWriter::ACCEPT_RANGES, "bytes");
+    response.setHeader(ResponseWriter::LAST_MODIFIED, lastModified);
+    response.setHeader(ResponseWriter::ETAG, etag);
+    // Ranges apply to the encoded representation, so a compressed variant can be served partially as well
+    if (!contentEncoding.empty())
+        response.setHeader(ResponseWriter::CONTENT_ENCODING, contentEncoding);
+    if (varyOnEncoding)
+        response.setHeader(ResponseWriter::VARY, "Accept-Encoding");
+
+    std::size_t contentLength{0};
+    bool        lengthKnown{true};
+    bool        storeInContentCache{false};
+    if (compress)
+    {
+        response.setHeader(ResponseWriter::CONTENT_TYPE, mimeType);
+        response.setHeader(ResponseWriter::CONTENT_ENCODING, "gzip");
+        // HEAD doesn't compress the file just to tell its length: without a cached body, the length is left out
+        if (_data.method == HEAD)
+        {
+            GzipCache::BodyPtr body{gzipCache.lookup(filePath, *_bodyFile, gzip.getCompLevel())};
+            if (body != nullptr)
+                contentLength = body->size();
+            else
+            {
+                lengthKnown = false;
+                response.setStreamedBody();
+            }
+        }
+        else
+        {
+            GzipCache::BodyPtr body{gzipCache.get(filePath, *_bodyFile, gzip.getCompLevel())};
+            if (body == nullptr)
+                throw std::runtime_error("could not be read for compression");
+            contentLength = body->size();
+            // Sent from the cached body itself, which may be shared by many connections
+            _sharedBody = std::move(body);
+        }
+    }
+    else if (rangeStatus == RANGE_IGNORED)
+    {
+        response.setHeader(ResponseWriter::CONTENT_TYPE, mimeType);
+        contentLength = fileSize;
+        // Small files are read into memory once, so the complete response can be kept in the hot cache.
+        // The hot cache is keyed by path only, so responses that depend on `Accept-Encoding` are left out.
+        // HEAD doesn't read the body; it's only answered from an entry a GET has stored
+        std::string body;
+        if (!varyOnEncoding && _data.method == GET && ContentCache::isCacheableRequest(_data) && _server->getContentCache().admits(fileSize) &&
+            readWholeFile(fd, fileSize, body))
+        {
+            response.setBody(std::move(body));
+            storeInContentCache = true;
+        }
+        else
+            _fileSegments.push_back({"", fd, 0, fileSize});
+    }
+    else if (ranges.size() == 1)
+    {
+        const ByteRange &range{ranges.front()};
+        response.setHeader(ResponseWriter::CONTENT_TYPE, mimeType);
+        response.setHeader(ResponseWriter::CONTENT_RANGE, "bytes " + std::to_string(range.first) + "-" +
+                                                              std::to_string(range.last) + "/" + std::to_string(fileSize));
+        _fileSegments.push_back({"", fd, static_cast<off_t>(range.first), range.last - range.first + 1});
+        contentLength = range.last - range.first + 1;
+    }
+    else
+    {
+        // Each part is preceded by its own headers and the whole body is terminated by the closing boundary
+        static unsigned long boundaryCounter{0};
+        const std::string    boundary{"webserv_" + std::to_string(_bodyFile->ino) + "_" + std::to_string(++boundaryCounter)};
+
+        response.setHeader(ResponseWriter::CONTENT_TYPE, "multipart/byteranges; boundary=" + boundary);
+        for (const auto &range : ranges)
+        {
+            std::string preamble{"\r\n--" + boundary + "\r\nContent-Type: "};
+            preamble.append(mimeType);
+            preamble += "\r\nContent-Range: bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" +
+                        std::to_string(fileSize) + "\r\n\r\n";
+            contentLength += preamble.size() + range.last - range.first + 1;
+            _fileSegments.push_back({std::move(preamble), fd, static_cast<off_t>(range.first), range.last - range.first + 1});
+        }
+        std::string closing{"\r\n--" + boundary + "--\r\n"};
+        contentLength += closing.size();
+        _fileSegments.push_back({std::move(closing), -1, 0, 0});
+    }
+    if (lengthKnown)
+        response.setHeader(ResponseWriter::CONTENT_LENGTH, std::to_string(contentLength));
+    // HEAD needs the exact same headers, but no body
+    if (_data.method == HEAD)
+        _fileSegments.clear();
+
+    // Medium-sized files are written from a mapping shared by all connections instead of with sendfile()
+    FileMappingCache &mappingCache{_server->getFileMappingCache()};
+    if (!_fileSegments.empty() && mappingCache.selects(fileSize))
+    {
+        _bodyMapping = mappingCache.map(*_bodyFile);
+        if (_bodyMapping != nullptr)
+        {
+            for (auto &segment : _fileSegments)
+            {
+                if (segment.fd != -1)
+                    segment.mapped = _bodyMapping->data;
+            }
+        }
+    }
+
+    _fullResponse = renderResponse(response, false);
+    if (storeInContentCache)
+        _server->getContentCache().store(_clientData->serverConfig, _data.path, _fullResponse, filePath);
+    _responseState = READY;
+}
+
 void GETRequest::continuePrevious()
 {
+    if (_cgiWaitingScript.has_value())
+        return continueWaitingForCGISlot();
+    if (_upstream != nullptr)
+        return continueUpstream();
+    if (_cgiRelay != nullptr)
+        return continueCGI();
+
     std::size_t num_ready{0};
     for (auto &[fileFd, fileData] : _clientData->openFiles)
     {
@@ -106,14 +370,7 @@ void GETRequest::continuePrevious()
             if (fileData.fileType == OpenFile::READ)
             {
                 ++num_ready;
-                if (fileData.isCGI && _cgiSubprocess != nullptr)
-                    cgiOutputToResponse(fileData.content);
-                else if (_responseWithoutBody != nullptr)
-                {
-                    // non-CGI read
-                    _responseWithoutBody->setBody(fileData.content);
-                    _fullResponse = _responseWithoutBody->write();
-                }
+                // CGI output is relayed, see continueCGI()
             }
             else if (fileData.fileType == OpenFile::WRITE)
             {
@@ -125,9 +382,6 @@ void GETRequest::continuePrevious()
 
     if (num_ready == _clientData->openFiles.size())
     {
-        if (_cgiStartTime.has_value()) // A CGI process exists
-            return checkCGIstatus();
-        else // No CGI process exists
-            _responseState = READY;
+        _responseState = READY;
     }
 }
@@ -6,6 +6,28 @@ POSTRequest::POSTRequest(HTTPRequestData data, const LocationConfig *location_co
 {
 }
 
+POSTRequest::Route POSTRequest::route(Server &server, const LocationConfig &location, const ResolutionCache::Entry &resolution,
+                                      std::size_t contentLength)
+{
+    if (location.getLimitExcept().count("post") == 0)
+        return NOT_ALLOWED;
+    if (location.getReturn().first != -1)
+        return REDIRECT;
+    if (contentLength > location.getClientMaxBodySize())
+        return TOO_LARGE;
+    // Locations passed to a FastCGI responder leave everything else to it
+    if (!location.getFastCGIPass().empty())
+        return FASTCGI;
+    // Prevent escaping root
+    if (!resolution.underRoot)
+        return OUTSIDE_ROOT;
+    if (server.getOpenFileCache().lookup(resolution.filePath)->isDirectory)
+        return DIRECTORY;
+    if (resolution.cgiInterpreter == nullptr)
+        return UPLOAD;
+    return server.getCGIWorkerPool().handles(*resolution.cgiInterpreter) ? CGI_WORKER : CGI_SUBPROCESS;
+}
+
 void POSTRequest::generateResponse(Server *server, int clientFd)
 {
     _server = server;
@@ -18,52 +40,43 @@ void POSTRequest::generateResponse(Server *server, int clientFd)
 
     _responseState = IN_PROGRESS;
 
-    // Check POST method allowed
-    if (_effective_config->getLimitExcept().find("post") == _effective_config->getLimitExcept().end())
+    std::filesystem::path finalPath{_resolution->filePath};
+    const std::string    *cgiInterpreter{_resolution->cgiInterpreter};
+    const std::size_t     contentLength{_bodyStream != nullptr ? _bodyStream->getContentLength() : _data.body.size()};
+    switch (route(*_server, *_effective_config, *_resolution, contentLength))
     {
+    case NOT_ALLOWED:
         return errorResponse(405);
-    }
-
-    if (_effective_config->getReturn().first != -1)
+    case REDIRECT:
         return handleRedirection(_effective_config->getReturn());
-
-    // Check client_max_body_size
-    const std::size_t maxAllowedBody = _effective_config->getClientMaxBodySize();
-    if (_data.body.size() > maxAllowedBody)
+    case TOO_LARGE:
         return errorResponse(413);
-
-    // Check if this is a CGI request first
-    std::filesystem::path cgiTargetPath{_effective_config->getRoot()};
-    cgiTargetPath /= splitUriIntoPathAndQuery(getURInoLeadingSlash()).first; // get rid of query string
-
-    // Normalize and validate the path
-    std::filesystem::path safePath;
-    if (!normalizeAndValidateUnderRoot(cgiTargetPath, safePath))
+    case FASTCGI:
+        return serveFastCGI();
+    case OUTSIDE_ROOT:
         return errorResponse(403);
-
-    // If path exists and is a directory, check for index files
-    std::filesystem::path finalPath = safePath;
-    if (std::filesystem::exists(safePath) && std::filesystem::is_directory(safePath))
+    case DIRECTORY:
     {
-        for (const auto &file : _effective_config->getIndexFilesVec())
+        // If path exists and is a directory, check for index files
+        const std::string &indexFile{findIndexFile()};
+        if (!indexFile.empty())
         {
-            std::filesystem::path indexPath = safePath / file;
-            if (std::filesystem::exists(indexPath))
-            {
-                finalPath = indexPath;
-                break;
-            }
+            finalPath = indexFile;
+            cgiInterpreter = _resolution->indexCGIInterpreter;
         }
+        break;
+    }
+    case CGI_WORKER:
+    case CGI_SUBPROCESS:
+    case UPLOAD:
+        break;
     }
 
     // Check if the final resolved path matches any CGI handler
-    for (const auto &[extension, interpreter] : _effective_config->getCGIHandlersMap())
+    if (cgiInterpreter != nullptr)
     {
-        if (finalPath.extension().string() == extension)
-        {
-            std::cout << "CGI detected for: " << finalPath << std::endl;
-            return serveCGI(finalPath, interpreter);
-        }
+        std::cout << "CGI detected for: " << finalPath << std::endl;
+        return serveCGI(finalPath, *cgiInterpreter);
     }
 
     std::cout << "Not a CGI request, handling as file upload" << std::endl;
@@ -115,7 +128,7 @@ void POSTRequest::handleMultipart()
         // No file parts found in multipart data - generate success response
         std::string responseMessage = "Multipart form data received without files to upload.\n";
         ResponseWriter response(200, {{"Content-Type", "text/plain"}}, responseMessage);
-        _fullResponse = response.write();
+        _fullResponse = renderResponse(response);
         _responseState = READY;
     }
 }
@@ -336,12 +349,14 @@ void POSTRequest::handleFileUpload(const std::vector<MultipartPart *> &fileParts
         }
 
         // Open file for writing
-        int fd = open(targetPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int fd = open(targetPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
         if (fd == -1)
         {
             std::cerr << "Failed to open file for writing: " << strerror(errno) << std::endl;
             return errorResponse(500);
         }
+        // A cached (possibly negative) entry for this path is outdated now
+        _server->forgetFile(targetPath);
 
         // Set to non-blocking mode
         try
@@ -361,6 +376,7 @@ void POSTRequest::handleFileUpload(const std::vector<MultipartPart *> &fileParts
         openFile.content = filePart->content;
         openFile.size = filePart->content.size();
         openFile.finished = false;
+        openFile.uploadPath = targetPath;
         openFile.lastReadWriteTime = std::chrono::steady_clock::now();
 
         // Register file with server
@@ -389,6 +405,13 @@ std::vector<POSTRequest::MultipartPart *> POSTRequest::findAllUploadFileParts(st
 
 void POSTRequest::continuePrevious()
 {
+    if (_cgiWaitingScript.has_value())
+        return continueWaitingForCGISlot();
+    if (_upstream != nullptr)
+        return continueUpstream();
+    if (_cgiRelay != nullptr)
+        return continueCGI();
+
     std::size_t num_ready{0};
     std::size_t num_files_uploaded{0};
 
@@ -399,14 +422,7 @@ void POSTRequest::continuePrevious()
             if (fileData.fileType == OpenFile::READ)
             {
                 ++num_ready;
-                if (fileData.isCGI && _cgiSubprocess != nullptr)
-                    cgiOutputToResponse(fileData.content);
-                else if (_responseWithoutBody != nullptr)
-                {
-                    // non-CGI read
-                    _responseWithoutBody->setBody(fileData.content);
-                    _fullResponse = _responseWithoutBody->write();
-                }
+                // CGI output is relayed, see continueCGI()
             }
             else if (fileData.fileType == OpenFile::WRITE)
             {
@@ -424,11 +440,8 @@ void POSTRequest::continuePrevious()
             responseMessage = std::to_string(num_files_uploaded) + " File(s) uploaded successfully\n";
 
             ResponseWriter response(201, {{"Content-Type", "text/plain"}}, responseMessage);
-            _fullResponse = response.write();
+            _fullResponse = renderResponse(response);
         }
-        if (_cgiStartTime.has_value()) // A CGI process exists
-            return checkCGIstatus();
-        else // No CGI process exists
-            _responseState = READY;
+        _responseState = READY;
     }
 }
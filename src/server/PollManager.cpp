@@ -49,6 +49,24 @@ void PollManager::addWriteFileFd(int fd)
     // _isWriteFile[fd] = true;
 }
 
+void PollManager::addWatchFd(int fd)
+{
+    addSocket(fd, POLLIN);
+    _sockTypeMap[fd] = WATCH;
+}
+
+void PollManager::addUpstreamFd(int fd, short events)
+{
+    addSocket(fd, events);
+    _sockTypeMap[fd] = UPSTREAM;
+}
+
+void PollManager::addProcessFd(int fd)
+{
+    addSocket(fd, POLLIN);
+    _sockTypeMap[fd] = PROCESS;
+}
+
 void PollManager::removeSocket(int fd)
 {
     for (auto it = _pollfds.begin(); it != _pollfds.end(); ++it)
@@ -145,6 +163,28 @@ bool PollManager::isWriteFileSocket(int fd) const
     return it != _sockTypeMap.end() && it->second == WRITEFILE;
 }
 
+bool PollManager::isUpstreamSocket(int fd) const
+{
+    auto it = _sockTypeMap.find(fd);
+    return it != _sockTypeMap.end() && it->second == UPSTREAM;
+}
+
+bool PollManager::isProcessFd(int fd) const
+{
+    auto it = _sockTypeMap.find(fd);
+    return it != _sockTypeMap.end() && it->second == PROCESS;
+}
+
+short PollManager::getRevents(int fd) const
+{
+    for (const auto &pfd : _pollfds)
+    {
+        if (pfd.fd == fd)
+            return pfd.revents;
+    }
+    return 0;
+}
+
 std::vector<int> PollManager::getReadableServerSockets() const
 {
     std::vector<int> readableSockets;
@@ -180,10 +220,11 @@ std::vector<int> PollManager::getWritableClientSockets() const
 
 std::vector<int> PollManager::getReadableFiles() const
 {
+    // A pipe whose writer has closed reports only POLLHUP once it's empty; read() returns its end of file
     std::vector<int> writableFiles;
     for (const auto &pfd : _pollfds)
     {
-        if ((pfd.revents & POLLIN) && isReadFileSocket(pfd.fd))
+        if ((pfd.revents & (POLLIN | POLLHUP | POLLERR)) && isReadFileSocket(pfd.fd))
             writableFiles.push_back(pfd.fd);
     }
     return writableFiles;
@@ -200,6 +241,29 @@ std::vector<int> PollManager::getWritableFiles() const
     return readableFiles;
 }
 
+std::vector<int> PollManager::getReadyUpstreamSockets() const
+{
+    // Errors and hang-ups count too: the exchange has to notice them
+    std::vector<int> readySockets;
+    for (const auto &pfd : _pollfds)
+    {
+        if (pfd.revents != 0 && isUpstreamSocket(pfd.fd))
+            readySockets.push_back(pfd.fd);
+    }
+    return readySockets;
+}
+
+std::vector<int> PollManager::getExitedProcesses() const
+{
+    std::vector<int> exitedProcesses;
+    for (const auto &pfd : _pollfds)
+    {
+        if (pfd.revents != 0 && isProcessFd(pfd.fd))
+            exitedProcesses.push_back(pfd.fd);
+    }
+    return exitedProcesses;
+}
+
 std::vector<pollfd> PollManager::getPollFDs()
 {
     return _pollfds;
@@ -3,9 +3,37 @@
 #include "HTTPRequest.hpp"
 #include "HTTPRequestFactory.hpp"
 
+#include <glob.h> /* glob(), globfree() */
+
 Server::Server(std::string configFileName)
     : _global_config{std::move(configFileName)} // Initiate parsing of the config file
+    , _openFileCache{_global_config.getOpenFileCacheMax(), _global_config.getOpenFileCacheValid()}
+    , _contentCache{_global_config.getHotCacheSize(), _global_config.getHotCacheMaxObject(), _global_config.getHotCacheValid()}
+    , _cgiCache{_global_config.getCGICacheSize(), _global_config.getCGICacheMaxObject()}
+    , _fileMappingCache{_global_config.getMmapCacheSize(), _global_config.getMmapCacheMin(), _global_config.getMmapCacheMax()}
+    , _gzipCache{_global_config.getGzipCacheSize(), _global_config.getGzipCacheMaxObject()}
+    , _directoryListingCache{_global_config.getAutoIndexCacheMax(), _global_config.getAutoIndexCacheValid(),
+                             _global_config.getAutoIndexCacheSize()}
+    , _rootIndex{_global_config.getRootIndexMax()}
+    // Index files are trusted as long as the open file cache would trust their entries
+    , _resolutionCache{_global_config.getResolutionCacheMax(),
+                       _global_config.getOpenFileCacheMax() != 0 ? _global_config.getOpenFileCacheValid() : 0}
+    , _cgiWorkerPool{_global_config.getCGIPools()}
+    , _cgiLimiter{_global_config.getCGIConcurrency()}
 {
+    // Index every root requests can be served from
+    if (_rootIndex.isEnabled())
+    {
+        for (const auto &server_config : _global_config.getServerConfigs())
+        {
+            _rootIndex.addRoot(server_config->getRoot());
+            for (const auto &[_, location_config] : server_config->getLocationsMap())
+                _rootIndex.addRoot(location_config->getRoot());
+        }
+        if (_rootIndex.isEnabled())
+            std::cout << "Root index: " << _rootIndex.getPathCount() << " paths" << '\n';
+    }
+
     // Create listening sockets
     for (const auto &server_config : _global_config.getServerConfigs())
     {
@@ -45,17 +73,109 @@ Server::~Server()
 {
     for (auto &[clientFd, clientData] : _clientData)
     {
-        close(clientFd);
+        if (clientFd >= 0)
+            close(clientFd);
+    }
+    if (_global_config.getHotCacheStats() && _contentCache.isEnabled())
+    {
+        const ContentCache::Stats &stats{_contentCache.getStats()};
+        std::cout << "Hot cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.stores << " stores, "
+                  << stats.evictions << " evictions, " << _contentCache.getEntryCount() << " entries ("
+                  << bytesToHumanReadable(_contentCache.getSize()) << ")" << '\n';
     }
     std::cout << "Server successfully stopped. Goodbye!" << '\n';
 }
 
+void Server::preload()
+{
+    const auto  start{std::chrono::steady_clock::now()};
+    std::size_t fileCount{0};
+    std::size_t byteCount{0};
+    bool        anyPatterns{false};
+    for (const auto &server_config : _global_config.getServerConfigs())
+    {
+        anyPatterns |= !server_config->getPreloadPatterns().empty();
+        preloadPatterns(server_config.get(), server_config->getRoot(), server_config->getPreloadPatterns(), fileCount, byteCount);
+        for (const auto &[_, location_config] : server_config->getLocationsMap())
+        {
+            anyPatterns |= !location_config->getPreloadPatterns().empty();
+            preloadPatterns(server_config.get(), location_config->getRoot(), location_config->getPreloadPatterns(), fileCount,
+                            byteCount);
+        }
+    }
+    if (!anyPatterns)
+        return;
+
+    const auto elapsed{std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)};
+    std::cout << "Preloaded " << fileCount << " files (" << bytesToHumanReadable(byteCount) << ") in " << elapsed.count()
+              << " ms" << '\n';
+}
+
+void Server::preloadPatterns(const ServerConfig *server_config, const std::string &root,
+                             const std::vector<std::string> &patterns, std::size_t &fileCount, std::size_t &byteCount)
+{
+    const std::string rootPath{std::filesystem::path(root).lexically_normal().string()};
+    for (const auto &pattern : patterns)
+    {
+        glob_t matches{};
+        int    result{glob((rootPath + pattern).c_str(), GLOB_NOSORT, nullptr, &matches)};
+        if (result != 0 && result != GLOB_NOMATCH)
+            std::cerr << "preload " << pattern << ": glob() failed" << '\n';
+        for (std::size_t i{0}; result == 0 && i < matches.gl_pathc; ++i)
+        {
+            // Back to the URI path the file is requested with
+            std::string match{std::filesystem::path(matches.gl_pathv[i]).lexically_normal().string()};
+            if (match.compare(0, rootPath.size(), rootPath) != 0)
+                continue;
+            std::string path{match.substr(rootPath.size())};
+            if (path.empty() || path[0] != '/')
+                path.insert(path.begin(), '/');
+
+            OpenFileCache::EntryPtr file{_openFileCache.lookup(match)};
+            if (file->fd == -1 || !preloadFile(server_config, path))
+                continue;
+            // Start reading the file into the page cache (files small enough are already in the hot cache)
+            posix_fadvise(file->fd, 0, 0, POSIX_FADV_WILLNEED);
+            ++fileCount;
+            byteCount += file->size;
+        }
+        globfree(&matches);
+    }
+}
+
+bool Server::preloadFile(const ServerConfig *server_config, const std::string &path)
+{
+    ResolutionCache::EntryPtr resolution{resolveRequestPath(path, server_config)};
+    const LocationConfig     *location_config{resolution->location};
+    if (location_config == nullptr || !resolution->underRoot || resolution->cgiInterpreter != nullptr ||
+        !location_config->getFastCGIPass().empty())
+        return false; // Scripts are never preloaded
+
+    // A client that doesn't exist: its fd is never polled, and it's gone before the first real connection
+    constexpr int preloadFd{-1};
+    _clientData[preloadFd].serverConfig = server_config;
+    std::vector<std::unordered_map<std::string, std::string>> headerSets{{{"host", "localhost"}}};
+    if (location_config->getGzipDirectives().isEnabled())
+        headerSets.push_back({{"host", "localhost"}, {"accept-encoding", "gzip"}});
+    for (auto &headers : headerSets)
+    {
+        HTTPRequestData data{GET, path, "HTTP/1.1", std::move(headers), "", path, ""};
+        std::unique_ptr<HTTPRequest> request{HTTPRequestFactory::createRequest(data, location_config)};
+        request->setResolution(resolution);
+        request->generateResponse(this, preloadFd);
+    }
+    _clientData.erase(preloadFd);
+    return true;
+}
+
 void Server::fillPollManager()
 {
     for (const auto &[fd, sockPtr] : _sockets)
     {
         _pollManager.addServerSocket(fd);
     }
+    if (_rootIndex.isEnabled())
+        _pollManager.addWatchFd(_rootIndex.getFd());
 }
 
 void Server::run()
@@ -69,7 +189,8 @@ void Server::run()
 
     while (g_shutdownServer == 0)
     {
-        const int pollResult = poll(_pollManager.data(), _pollManager.size(), -1);
+        // Without anything to do for a request, poll() sleeps until some I/O completes or the tick is over
+        const int pollResult = poll(_pollManager.data(), _pollManager.size(), _clientsToWake.empty() ? POLL_TICK : 0);
 
         if (pollResult < 0)
         {
@@ -80,6 +201,9 @@ void Server::run()
             std::cerr << "Poll error: " << strerror(errno) << '\n';
             continue;
         }
+        // Keep the root index and the caches in line with the filesystem before any request uses them
+        processFilesystemEvents();
+
         // Accept new connections
         acceptNewConnections();
 
@@ -92,6 +216,12 @@ void Server::run()
         // Write to open files
         writeToOpenFiles();
 
+        // Send requests to FastCGI responders and CGI workers and read their responses
+        exchangeWithUpstreams();
+
+        // Reap CGI subprocesses that have exited
+        collectExitedProcesses();
+
         // Write responses to clients
         respondToClients();
 
@@ -103,9 +233,90 @@ void Server::run()
 
         // Clean up files that are we are done with
         closeDoneFiles();
+
+        // Requests waiting for a CGI worker may get one now
+        wakeUpstreamWaiters();
+
+        // Requests waiting for a CGI slot may start their scripts now
+        admitCGIWaiters();
+    }
+}
+
+void Server::processFilesystemEvents()
+{
+    const int watchFd{_rootIndex.getFd()};
+    if (watchFd == -1 || !_pollManager.isReadable(watchFd))
+        return;
+
+    std::vector<std::string> changed;
+    const bool               complete{_rootIndex.processEvents(changed)};
+    if (!changed.empty() || !complete)
+        _resolutionCache.forgetIndexFiles();
+    if (!complete)
+    {
+        // Events were lost, so nothing cached can be trusted
+        _openFileCache.clear();
+        _contentCache.clear();
+        _gzipCache.clear();
+        _directoryListingCache.clear();
+    }
+    else
+    {
+        for (const auto &path : changed)
+        {
+            // Directories are looked up both with and without the trailing slash of their URI
+            const std::string parent{std::filesystem::path(path).parent_path().string()};
+            _openFileCache.invalidate(path);
+            _openFileCache.invalidate(path + '/');
+            _contentCache.invalidateFile(path);
+            // A new or removed precompressed variant changes how its original is served
+            for (std::string_view suffix : {".gz", ".br"})
+            {
+                if (path.size() > suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0)
+                    _contentCache.invalidateFile(path.substr(0, path.size() - suffix.size()));
+            }
+            _gzipCache.invalidate(path);
+            _directoryListingCache.invalidate(path);
+            _directoryListingCache.invalidate(path + '/');
+            _directoryListingCache.invalidate(parent);
+            _directoryListingCache.invalidate(parent + '/');
+        }
+    }
+    if (!_rootIndex.isEnabled())
+        _pollManager.removeSocket(watchFd);
+}
+
+void Server::exchangeWithUpstreams()
+{
+    for (int upstreamFd : _pollManager.getReadyUpstreamSockets())
+    {
+        auto client{_upstreamToClientMap.find(upstreamFd)};
+        if (client == _upstreamToClientMap.end())
+            continue;
+        HTTPRequest *request{_clientData[client->second].parsedRequest.get()};
+        if (request == nullptr || !request->handleUpstreamEvents(_pollManager.getRevents(upstreamFd)))
+            unregisterUpstream(upstreamFd);
+        else
+            wakeClient(client->second);
+    }
+}
+
+void Server::collectExitedProcesses()
+{
+    for (int pidFd : _pollManager.getExitedProcesses())
+    {
+        auto client{_processToClientMap.find(pidFd)};
+        if (client == _processToClientMap.end())
+            continue;
+        const int    clientFd{client->second};
+        HTTPRequest *request{_clientData[clientFd].parsedRequest.get()};
+        // The pidfd stays readable: it's polled no more once the exit has been handled
+        unregisterProcess(pidFd);
+        if (request == nullptr)
+            continue;
+        request->handleProcessExit();
+        wakeClient(clientFd);
     }
-    if (g_shutdownServer == 2)
-        throw std::runtime_error("execve failure"); // only possible to reach in CGI child process
 }
 
 void Server::acceptNewConnections()
@@ -125,9 +336,12 @@ void Server::acceptNewConnections()
 
 void Server::acceptNewConnection(int serverFd)
 {
-    const int clientFd = accept(serverFd, nullptr, nullptr);
+    // Close-on-exec, like every fd of the server, so none of them leaks into CGI scripts
+    const int clientFd = accept4(serverFd, nullptr, nullptr, SOCK_CLOEXEC);
     if (clientFd >= 0)
     {
+        // Responses are sent with as many write()/sendfile() calls as the socket accepts without blocking
+        setNonBlocking(clientFd);
         std::cout << "Accepted new connection via: \n" << *(_sockets[serverFd]) << '\n';
         _pollManager.addClientSocket(clientFd);
         _clientData[clientFd] = {
@@ -149,10 +363,10 @@ void Server::readFromClients()
 {
     for (int clientFd : _pollManager.getReadableClientSockets())
     {
-        std::string currentRequest;
+        std::string received;
         try
         {
-            currentRequest = readFromClientOrFile(clientFd, _clientData[clientFd].partialRequest);
+            received = readFromClientOrFile(clientFd, "");
             _clientData[clientFd].lastInteractionTime = std::chrono::steady_clock::now();
             // std::cout << "Received request from client: " << clientFd << ' ' << _clientData[clientFd] << '\n';
         }
@@ -162,48 +376,197 @@ void Server::readFromClients()
             _clientsToRemove.insert(clientFd);
             continue;
         }
-        if (currentRequest.empty())
+        if (received.empty())
             _clientsToRemove.insert(clientFd);
-        else if (HTTPRequestParser::isValidRequest(currentRequest))
+        else if (_clientData[clientFd].bodyStream != nullptr)
+            consumeBody(clientFd, received.data(), received.size());
+        else
         {
-            try
-            {
-                HTTPRequestData data = HTTPRequestParser::parse(currentRequest);
-                // std::cout << "Parsed request body:\n" << data.body << std::endl;
+            _clientData[clientFd].partialRequest += received;
+            // The next request waits for the response to this one to be sent (see respondToClient())
+            if (_clientData[clientFd].parsedRequest == nullptr && _clientData[clientFd].pendingResponse.response.empty())
+                processPartialRequest(clientFd);
+        }
+    }
+}
+
+void Server::processPartialRequest(int clientFd)
+{
+    ClientData &client_data{_clientData[clientFd]};
+    try
+    {
+        // The head is parsed, and whether the body is streamed decided, once; then only the rest is waited for
+        if (!client_data.receivedHead.has_value())
+        {
+            const std::size_t headEnd{client_data.partialRequest.find("\r\n\r\n")};
+            if (headEnd == std::string::npos)
+                return;
+            ReceivedHead head{HTTPRequestParser::parseHead(client_data.partialRequest.substr(0, headEnd))};
+            head.bodyStart = headEnd + 4;
+            head.scanned = head.bodyStart;
+            auto length{head.data.headers.find("content-length")};
+            if (length != head.data.headers.end())
+                std::from_chars(length->second.data(), length->second.data() + length->second.size(), head.contentLength);
+            auto encoding{head.data.headers.find("transfer-encoding")};
+            head.chunked = encoding != head.data.headers.end() && encoding->second == "chunked";
+            client_data.receivedHead = std::move(head);
+            if (streamRequestBody(clientFd))
+                return;
+        }
+        if (!client_data.receivedHead->isComplete(client_data.partialRequest))
+            return;
+        HTTPRequestData data{HTTPRequestParser::parse(std::move(client_data.receivedHead->data), client_data.partialRequest,
+                                                      client_data.receivedHead->bodyStart)};
+        // std::cout << "Parsed request body:\n" << data.body << std::endl;
 
-                const ServerConfig *server_config = _clientData[clientFd].serverConfig;
+        client_data.receivedHead.reset();
+        client_data.partialRequest.clear();
+        if (respondFromContentCache(clientFd, data))
+            return;
 
-                const LocationConfig *location_config = findLocationConfig(data.uri, server_config);
+        const ServerConfig *server_config = client_data.serverConfig;
 
-                // std::cout << "Using ServerConfig: " << (server_config ? "found" : "not found") << ", LocationConfig: " << (location_config ? "found" : "not found") << std::endl;
-                _clientData[clientFd].parsedRequest = HTTPRequestFactory::createRequest(data, location_config);
-                _pollManager.updateEvents(clientFd, POLLOUT);
-                _clientData[clientFd].partialRequest.clear();
-            }
-            catch (const std::runtime_error &e)
-            {
-                std::cerr << "Error parsing request: " << e.what() << '\n';
-                _clientsToRemove.insert(clientFd);
-            }
-        }
-        else
-            _clientData[clientFd].partialRequest = currentRequest;
+        ResolutionCache::EntryPtr resolution{resolveRequestPath(data.path, server_config)};
+
+        // std::cout << "Using ServerConfig: " << (server_config ? "found" : "not found") << ", LocationConfig: " << (location_config ? "found" : "not found") << std::endl;
+        client_data.parsedRequest = HTTPRequestFactory::createRequest(data, resolution->location);
+        client_data.parsedRequest->setResolution(std::move(resolution));
+        armResponse(clientFd);
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << "Error parsing request: " << e.what() << '\n';
+        _clientsToRemove.insert(clientFd);
+    }
+}
+
+bool ReceivedHead::isComplete(const std::string &received)
+{
+    if (received.size() < bodyStart + contentLength)
+        return false;
+    if (!chunked)
+        return true;
+    // Only what arrived since the last search is searched (and the end of what was, the last chunk may straddle both)
+    const std::size_t from{std::max(bodyStart, scanned - std::min<std::size_t>(scanned, 4))};
+    scanned = received.size();
+    return received.find("0\r\n\r\n", from) != std::string::npos;
+}
+
+bool Server::streamRequestBody(int clientFd)
+{
+    ClientData            &client_data{_clientData[clientFd]};
+    const HTTPRequestData &data{client_data.receivedHead->data};
+    if (data.method != POST)
+        return false;
+
+    ResolutionCache::EntryPtr resolution{resolveRequestPath(data.path, client_data.serverConfig)};
+    std::size_t               contentLength{0};
+    if (!streamsBodyToCGI(data, *resolution, contentLength))
+        return false;
+
+    // The request starts the script right away, with an empty body in its data
+    auto        stream{std::make_shared<CGIBodyStream>(contentLength)};
+    std::string received;
+    received.swap(client_data.partialRequest);
+    const std::size_t bodyStart{client_data.receivedHead->bodyStart};
+    client_data.parsedRequest = HTTPRequestFactory::createRequest(data, resolution->location);
+    client_data.receivedHead.reset();
+    client_data.parsedRequest->setResolution(std::move(resolution));
+    client_data.parsedRequest->setBodyStream(stream);
+    client_data.bodyStream = std::move(stream);
+    armResponse(clientFd);
+    consumeBody(clientFd, received.data() + bodyStart, received.size() - bodyStart);
+    return true;
+}
+
+bool Server::streamsBodyToCGI(const HTTPRequestData &data, const ResolutionCache::Entry &resolution, std::size_t &contentLength)
+{
+    // Chunked bodies are still received whole: the script is told the length of the body up front (CONTENT_LENGTH)
+    auto length{data.headers.find("content-length")};
+    if (length == data.headers.end() || data.headers.find("transfer-encoding") != data.headers.end())
+        return false;
+    const char *end{length->second.data() + length->second.size()};
+    auto [parsed, error]{std::from_chars(length->second.data(), end, contentLength)};
+    if (error != std::errc{} || parsed != end || contentLength == 0)
+        return false;
+
+    // Only requests POSTRequest hands to a CGI subprocess; workers, FastCGI and uploads take the whole body
+    return resolution.location != nullptr &&
+           POSTRequest::route(*this, *resolution.location, resolution, contentLength) == POSTRequest::CGI_SUBPROCESS;
+}
+
+void Server::consumeBody(int clientFd, const char *data, std::size_t size)
+{
+    ClientData    &client_data{_clientData[clientFd]};
+    CGIBodyStream &stream{*client_data.bodyStream};
+    const std::size_t bodyBytes{stream.append(data, size)};
+    if (bodyBytes < size)
+        client_data.partialRequest.append(data + bodyBytes, size - bodyBytes);
+    if (stream.getPipeFd() != -1 && stream.size() > 0)
+        _pollManager.updateEvents(stream.getPipeFd(), POLLOUT);
+    if (stream.isFull())
+    {
+        // Resumed once the script has taken some of it (see writeBodyToCGI())
+        _pollManager.removeEvents(clientFd, POLLIN);
     }
+    if (!stream.isComplete())
+        return;
+    client_data.bodyStream = nullptr;
+    // What came after the body may be the next request
+    if (client_data.parsedRequest == nullptr && client_data.pendingResponse.response.empty())
+        processPartialRequest(clientFd);
+}
+
+void Server::abandonBodyStream(ClientData &client_data)
+{
+    if (client_data.bodyStream == nullptr)
+        return;
+    if (client_data.bodyStream->getPipeFd() != -1)
+        _filesToRemove.insert(client_data.bodyStream->getPipeFd());
+    client_data.bodyStream->detach();
+}
+
+bool Server::respondFromContentCache(int clientFd, const HTTPRequestData &data)
+{
+    if (!_contentCache.isEnabled() || !ContentCache::isCacheableRequest(data))
+        return false;
+
+    ClientData             &client_data{_clientData[clientFd]};
+    ContentCache::EntryPtr entry{_contentCache.lookup(client_data.serverConfig, data.path)};
+    if (entry == nullptr)
+        return false;
+
+    PendingResponse &pending{client_data.pendingResponse};
+    ContentCache::renderFreshHead(pending.response);
+    pending.sharedTail = std::shared_ptr<const std::string>(entry, &entry->tail);
+    pending.sharedTailSize = data.method == HEAD ? entry->headersSize : entry->tail.size();
+    auto connection{data.headers.find("connection")};
+    pending.closeConnection = connection != data.headers.end() && connection->second == "close";
+    armResponse(clientFd);
+    return true;
 }
 
 void Server::readFromOpenFiles()
 {
     for (int fileFd : _pollManager.getReadableFiles())
     {
-        ClientData &client_data{getClientOfFile(fileFd)};
+        // A file that isn't registered anymore belongs to no request
+        auto owner{_openFilesToClientMap.find(fileFd)};
+        if (owner == _openFilesToClientMap.end())
+            continue;
+        const int   clientFd{owner->second};
+        ClientData &client_data{_clientData[clientFd]};
+        OpenFile   &file{client_data.openFiles[fileFd]};
+        if (file.cgiRelay != nullptr)
+        {
+            readFromCGI(fileFd, clientFd, file);
+            continue;
+        }
         std::string currentRead;
         try
         {
-            currentRead = readFromClientOrFile(fileFd, client_data.openFiles[fileFd].content);
-            // std::cout << "Successfully read from file: " << fileFd << '\n';
-            client_data.openFiles[fileFd].lastReadWriteTime = std::chrono::steady_clock::now();
-            if (client_data.openFiles[fileFd].isCGI)
-                client_data.openFiles[fileFd].size = HTTPRequestParser::getResponseSizeFromCgiHeader(currentRead);
+            currentRead = readFromClientOrFile(fileFd, file.content);
+            file.lastReadWriteTime = std::chrono::steady_clock::now();
         }
         catch (const std::runtime_error &e)
         {
@@ -211,41 +574,107 @@ void Server::readFromOpenFiles()
             _filesToRemove.insert(fileFd);
             continue;
         }
-        if (currentRead.empty())
+        if (currentRead.empty() || currentRead.size() == file.size)
         {
             // Nothing more to read
-            client_data.openFiles[fileFd].finished = true;
+            file.finished = true;
+            file.content = currentRead;
             _filesToRemove.insert(fileFd);
+            // Before the file is closed: the request looks for it among its finished files
+            wakeClient(clientFd);
         }
-        // recycling isValidRequest to check if CGI response is valid
-        else if (HTTPRequestParser::isValidRequest(currentRead))
+        else
+            file.content = currentRead;
+    }
+}
+
+void Server::readFromCGI(int fileFd, int clientFd, OpenFile &file)
+{
+    if (spliceFromCGI(fileFd, clientFd, file))
+        return;
+    // The pipe is read until it's empty, so an output that has already ended is known to have before the head is sent
+    // (a script that failed can then still get a 500, see HTTPRequest::continueCGI())
+    char buffer[CGI_READ_SIZE];
+    while (!file.cgiRelay->isFull())
+    {
+        const ssize_t bytesRead{read(fileFd, buffer, sizeof(buffer))};
+        if (bytesRead < 0)
         {
-            try
-            {
-                HTTPRequestData data = HTTPRequestParser::parse(currentRead);
-                // nothing more to read
-                client_data.openFiles[fileFd].finished = true;
-                client_data.openFiles[fileFd].content = currentRead;
-                _filesToRemove.insert(fileFd);
-            }
-            catch (const std::runtime_error &e)
-            {
-                std::cerr << "Error parsing cgi response: " << e.what() << '\n';
-                _filesToRemove.insert(fileFd);
-            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            std::cerr << "Error reading from CGI " << fileFd << ": " << strerror(errno) << '\n';
+            _filesToRemove.insert(fileFd);
+            return;
         }
-        else if (currentRead.size() == client_data.openFiles[fileFd].size)
+        file.lastReadWriteTime = std::chrono::steady_clock::now();
+        if (bytesRead == 0)
         {
-            // nothing more to read
-            client_data.openFiles[fileFd].finished = true;
-            client_data.openFiles[fileFd].content = currentRead;
+            // The script closed its output
+            file.finished = true;
+            file.cgiRelay->endOfOutput();
             _filesToRemove.insert(fileFd);
+            break;
         }
-        else
+        if (!file.cgiRelay->feed(buffer, static_cast<std::size_t>(bytesRead)))
         {
-            client_data.openFiles[fileFd].content = currentRead;
+            std::cerr << "Error parsing cgi response: header block too long" << '\n';
+            _filesToRemove.insert(fileFd);
+            return;
         }
     }
+    // The header block may be complete, or there is more of the body to send
+    wakeClient(clientFd);
+    if (file.cgiRelay->isFull())
+    {
+        // Resumed once the client has taken some of it (see respondToClient())
+        file.cgiRelay->setPaused(true);
+        _pollManager.removeSocket(fileFd);
+    }
+}
+
+bool Server::spliceFromCGI(int fileFd, int clientFd, OpenFile &file)
+{
+    if (clientFd < 0)
+        return false; // A refresh's body is read and dropped
+    ClientData            &client_data{_clientData[clientFd]};
+    const PendingResponse &pending{client_data.pendingResponse};
+    CGIResponseRelay      &relay{*file.cgiRelay};
+    if (pending.cgiRelay != file.cgiRelay || pending.sent < pending.response.size() || !relay.canSplice())
+        return false;
+
+    // No SPLICE_F_MORE: like TCP_CORK, it holds back the last partial segment of the body for up to 200 ms
+    const ssize_t bytesMoved{splice(fileFd, nullptr, clientFd, nullptr, relay.getSpliceLimit(),
+                                    SPLICE_F_MOVE | SPLICE_F_NONBLOCK)};
+    if (bytesMoved < 0)
+    {
+        if (errno == EINVAL)
+        {
+            relay.disableSplice();
+            return false;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            std::cerr << "Error writing to client " << clientFd << ": " << strerror(errno) << '\n';
+            _clientsToRemove.insert(clientFd);
+            return true;
+        }
+        // The pipe is readable, so it's the socket that is full: resumed once the client takes more (see respondToClient())
+        relay.setPaused(true);
+        _pollManager.removeSocket(fileFd);
+        armResponse(clientFd);
+        return true;
+    }
+    file.lastReadWriteTime = std::chrono::steady_clock::now();
+    if (bytesMoved == 0)
+    {
+        // The script closed its output
+        file.finished = true;
+        _filesToRemove.insert(fileFd);
+        return true;
+    }
+    relay.spliced(static_cast<std::size_t>(bytesMoved));
+    client_data.lastInteractionTime = file.lastReadWriteTime;
+    return true;
 }
 
 std::string Server::readFromClientOrFile(int fd, std::string partialContent)
@@ -266,9 +695,19 @@ std::string Server::readFromClientOrFile(int fd, std::string partialContent)
 
 void Server::respondToClients()
 {
-    for (int clientFd : _pollManager.getWritableClientSockets())
+    // Clients whose sockets take more bytes, and clients whose requests were woken by the I/O they waited for
+    std::vector<int> clients{_pollManager.getWritableClientSockets()};
+    for (int clientFd : _clientsToWake)
+    {
+        if (!_pollManager.isWritable(clientFd))
+            clients.push_back(clientFd);
+    }
+    _clientsToWake.clear();
+    for (int clientFd : clients)
     {
-        if (_clientData[clientFd].parsedRequest != nullptr)
+        if (_clientsToRemove.count(clientFd) != 0 || _clientData.find(clientFd) == _clientData.end())
+            continue;
+        if (_clientData[clientFd].parsedRequest != nullptr || !_clientData[clientFd].pendingResponse.response.empty())
         {
             try
             {
@@ -289,46 +728,238 @@ void Server::respondToClient(int clientFd)
     {
         _clientData[clientFd].parsedRequest->generateResponse(this, clientFd);
         if (_clientData[clientFd].parsedRequest->fullResponseIsReady())
-            _clientData[clientFd].pendingResponse = {_clientData[clientFd].parsedRequest->getFullResponse(), 0};
+        {
+            PendingResponse &pendingResponse{_clientData[clientFd].pendingResponse};
+            pendingResponse.response = _clientData[clientFd].parsedRequest->getFullResponse();
+            pendingResponse.fileSegments = _clientData[clientFd].parsedRequest->takeFileSegments();
+            pendingResponse.sharedTail = _clientData[clientFd].parsedRequest->takeSharedBody();
+            pendingResponse.sharedTailSize = pendingResponse.sharedTail != nullptr ? pendingResponse.sharedTail->size() : 0;
+            pendingResponse.cgiRelay = _clientData[clientFd].parsedRequest->getCGIRelay();
+            pendingResponse.closeConnection = _clientData[clientFd].parsedRequest->isCloseConnection();
+        }
         else
-            return;
+            return waitForIO(clientFd);
     }
+    else if (_clientData[clientFd].pendingResponse.cgiRelay != nullptr)
+        _clientData[clientFd].parsedRequest->continueCGIResponse();
     // std::cout << "Sending response to client: " << clientFd << ' ' << _clientData[clientFd] << '\n';
     _clientData[clientFd].lastInteractionTime = std::chrono::steady_clock::now();
-    auto pendingResponse = writeResponseToClient(clientFd);
-    if (pendingResponse.response.size() == pendingResponse.sent)
+    if (clientFd < 0)
+        _clientData[clientFd].pendingResponse.discard();
+    else
+        writeResponseToClient(clientFd);
+    const std::shared_ptr<CGIResponseRelay> &relay{_clientData[clientFd].pendingResponse.cgiRelay};
+    if (relay != nullptr && relay->isPaused() && !relay->isFull())
+    {
+        relay->setPaused(false);
+        _pollManager.addReadFileFd(relay->getPipeFd());
+    }
+    if (_clientData[clientFd].pendingResponse.isComplete())
     {
         std::cout << "Full response sent, switch back to listening for client: " << clientFd << ' ' << _clientData[clientFd] << std::endl;
-        if (_clientData[clientFd].parsedRequest->isCloseConnection())
+        if (_clientData[clientFd].pendingResponse.closeConnection || (relay != nullptr && relay->closesConnection()) ||
+            clientFd < 0)
             _clientsToRemove.insert(clientFd);
         _clientData[clientFd].pendingResponse = {};
         _clientData[clientFd].parsedRequest = nullptr;
+        _clientData[clientFd].state = ClientData::IDLE;
         _pollManager.updateEvents(clientFd, POLLIN); // Start monitoring for reading new requests
         _pollManager.removeEvents(clientFd, POLLOUT); // Stop monitoring for writing until new request arrives / new response is ready
+        if (_clientsToRemove.count(clientFd) != 0)
+            return;
+        // A response sent before the whole body arrived (e.g., the script didn't read it) leaves the rest to be dropped
+        abandonBodyStream(_clientData[clientFd]);
+        // A request that arrived in the meantime is next
+        if (_clientData[clientFd].bodyStream == nullptr)
+            processPartialRequest(clientFd);
     }
+    else if (_clientData[clientFd].pendingResponse.isWaitingForCGI())
+        waitForIO(clientFd); // Woken by more output, its end, or the script's exit
     else
-        _clientData[clientFd].pendingResponse = pendingResponse;
+        armResponse(clientFd); // The rest goes out when the socket takes more
 }
 
-PendingResponse Server::writeResponseToClient(int clientFd)
+void Server::writeResponseToClient(int clientFd)
 {
-    auto pendingResponses = _clientData[clientFd].pendingResponse;
-    auto responseRemainder = pendingResponses.response.c_str() + pendingResponses.sent;
-    auto remainingToSend = pendingResponses.response.size() - pendingResponses.sent;
+    PendingResponse &pending{_clientData[clientFd].pendingResponse};
 
-    // Send response back to client
-    ssize_t bytesWritten = write(clientFd, responseRemainder, remainingToSend);
-    if (bytesWritten < 0)
-        throw std::runtime_error("Error writing to client " + std::to_string(clientFd) + ": " + strerror(errno));
-    pendingResponses.sent += bytesWritten;
-    return pendingResponses;
+    while (!pending.isComplete())
+    {
+        ssize_t bytesWritten;
+        if (pending.sent < pending.response.size() || pending.sharedTailSent < pending.sharedTailSize)
+        {
+            // The in-memory parts go out together
+            struct iovec iov[2];
+            int          iovCount{0};
+            std::size_t  responseLeft{pending.response.size() - pending.sent};
+            if (responseLeft > 0)
+                iov[iovCount++] = {pending.response.data() + pending.sent, responseLeft};
+            if (pending.sharedTailSent < pending.sharedTailSize)
+                iov[iovCount++] = {const_cast<char *>(pending.sharedTail->data()) + pending.sharedTailSent,
+                                   pending.sharedTailSize - pending.sharedTailSent};
+            bytesWritten = writev(clientFd, iov, iovCount);
+            if (bytesWritten > 0)
+            {
+                std::size_t fromResponse{std::min(static_cast<std::size_t>(bytesWritten), responseLeft)};
+                pending.sent += fromResponse;
+                pending.sharedTailSent += bytesWritten - fromResponse;
+            }
+        }
+        else if (pending.segmentIndex < pending.fileSegments.size())
+        {
+            const FileSegment &segment{pending.fileSegments[pending.segmentIndex]};
+            if (pending.segmentSent < segment.preamble.size())
+            {
+                bytesWritten = write(clientFd, segment.preamble.c_str() + pending.segmentSent, segment.preamble.size() - pending.segmentSent);
+            }
+            else if (segment.mapped != nullptr)
+            {
+                std::size_t alreadySent{pending.segmentSent - segment.preamble.size()};
+                bytesWritten = write(clientFd, segment.mapped + segment.offset + alreadySent, segment.length - alreadySent);
+            }
+            else
+            {
+                std::size_t alreadySent{pending.segmentSent - segment.preamble.size()};
+                off_t       offset{segment.offset + static_cast<off_t>(alreadySent)};
+                bytesWritten = sendfile(clientFd, segment.fd, &offset, segment.length - alreadySent);
+                if (bytesWritten == 0 && alreadySent < segment.length)
+                    throw std::runtime_error("File sent to client " + std::to_string(clientFd) + " was truncated");
+            }
+            if (bytesWritten > 0)
+                pending.segmentSent += bytesWritten;
+            if (pending.segmentSent == segment.preamble.size() + segment.length)
+            {
+                ++pending.segmentIndex;
+                pending.segmentSent = 0;
+            }
+        }
+        else
+        {
+            // As much of the CGI output as has arrived
+            if (pending.cgiRelay->size() == 0)
+                return;
+            bytesWritten = write(clientFd, pending.cgiRelay->data(), pending.cgiRelay->size());
+            if (bytesWritten > 0)
+                pending.cgiRelay->consume(static_cast<std::size_t>(bytesWritten));
+        }
+        if (bytesWritten < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return; // Socket buffer is full, continue when poll() reports it writable again
+            throw std::runtime_error("Error writing to client " + std::to_string(clientFd) + ": " + strerror(errno));
+        }
+    }
+}
+
+bool PendingResponse::isComplete() const
+{
+    return sent == response.size() && sharedTailSent == sharedTailSize && segmentIndex == fileSegments.size() &&
+           (cgiRelay == nullptr || cgiRelay->isDrained());
+}
+
+bool PendingResponse::isWaitingForCGI() const
+{
+    return sent == response.size() && sharedTailSent == sharedTailSize && segmentIndex == fileSegments.size() &&
+           cgiRelay != nullptr && cgiRelay->size() == 0 && !cgiRelay->isFinished();
+}
+
+void PendingResponse::discard()
+{
+    sent = response.size();
+    sharedTailSent = sharedTailSize;
+    segmentIndex = fileSegments.size();
+    segmentSent = 0;
+    if (cgiRelay != nullptr)
+        cgiRelay->consume(cgiRelay->size());
+}
+
+void Server::armResponse(int clientFd)
+{
+    _clientData[clientFd].state = ClientData::RESPONDING;
+    if (clientFd < 0)
+        _clientsToWake.insert(clientFd); // There is no socket that poll() could report writable
+    else
+        _pollManager.updateEvents(clientFd, POLLOUT);
+}
+
+void Server::waitForIO(int clientFd)
+{
+    _clientData[clientFd].state = ClientData::PROCESSING;
+    _pollManager.removeEvents(clientFd, POLLOUT);
+}
+
+void Server::wakeClient(int clientFd)
+{
+    // Handled by the next respondToClients(), without waiting for poll() to report the socket writable
+    auto client{_clientData.find(clientFd)};
+    if (client != _clientData.end() && client->second.state == ClientData::PROCESSING)
+        _clientsToWake.insert(clientFd);
+}
+
+void Server::awaitUpstream(int clientFd)
+{
+    _clientsAwaitingUpstream.insert(clientFd);
+}
+
+void Server::refreshCGICache(int clientFd, HTTPRequestData data, ResolutionCache::EntryPtr resolution,
+                             const std::string &key)
+{
+    // A client that doesn't exist (like the preload one): its fd is never polled and its response is dropped
+    const int   refreshFd{_nextRefreshFd--};
+    ClientData &origin{_clientData[clientFd]};
+    ClientData &refresh{_clientData[refreshFd]};
+    refresh.serverConfig = origin.serverConfig;
+    refresh.hostName = origin.hostName;
+    refresh.port = origin.port;
+    refresh.lastInteractionTime = std::chrono::steady_clock::now();
+    refresh.cgiCacheRefresh = key;
+
+    // A HEAD hit refreshes the entry of GET
+    data.method = GET;
+    data.body.clear();
+    refresh.parsedRequest = HTTPRequestFactory::createRequest(data, resolution->location);
+    refresh.parsedRequest->setResolution(std::move(resolution));
+    armResponse(refreshFd);
+}
+
+void Server::releasedUpstream()
+{
+    // Requests give back workers while they are being destroyed, when the clients can't be touched
+    _upstreamReleased = true;
+}
+
+void Server::wakeUpstreamWaiters()
+{
+    if (!_upstreamReleased)
+        return;
+    _upstreamReleased = false;
+    // Whichever of them got the worker, the others wait in line again (see HTTPRequest::syncUpstreamFd())
+    for (int clientFd : _clientsAwaitingUpstream)
+        wakeClient(clientFd);
+    _clientsAwaitingUpstream.clear();
+}
+
+void Server::admitCGIWaiters()
+{
+    // Slots are granted while the scripts' requests are destroyed, when the clients can't be touched
+    for (int clientFd : _cgiLimiter.takeGranted())
+        wakeClient(clientFd);
 }
 
 void Server::writeToOpenFiles()
 {
     for (int fileFd : _pollManager.getWritableFiles())
     {
-        ClientData &client_data{getClientOfFile(fileFd)};
+        auto owner{_openFilesToClientMap.find(fileFd)};
+        if (owner == _openFilesToClientMap.end())
+            continue;
+        const int   clientFd{owner->second};
+        ClientData &client_data{_clientData[clientFd]};
+        if (client_data.openFiles[fileFd].bodyStream != nullptr)
+        {
+            writeBodyToCGI(fileFd, clientFd, client_data.openFiles[fileFd]);
+            continue;
+        }
         if (!client_data.openFiles[fileFd].finished)
         {
             try
@@ -340,18 +971,55 @@ void Server::writeToOpenFiles()
                 {
                     std::cout << "Finished writing to file " << fileFd << ". Closing it now." << '\n';
                     client_data.openFiles[fileFd].finished = true;
+                    // Requests served while it was written may have cached it empty or partial
+                    if (!client_data.openFiles[fileFd].uploadPath.empty())
+                        forgetFile(client_data.openFiles[fileFd].uploadPath);
                     _filesToRemove.insert(fileFd);
+                    wakeClient(clientFd);
                 }
             }
             catch (const std::runtime_error &e)
             {
                 std::cerr << "Error writing to file " << fileFd << ": " << e.what() << '\n';
+                if (!client_data.openFiles[fileFd].uploadPath.empty())
+                    forgetFile(client_data.openFiles[fileFd].uploadPath);
                 _filesToRemove.insert(fileFd);
             }
         }
     }
 }
 
+void Server::writeBodyToCGI(int fileFd, int clientFd, OpenFile &file)
+{
+    CGIBodyStream &stream{*file.bodyStream};
+    if (stream.size() > 0)
+    {
+        const ssize_t bytesWritten{write(fileFd, stream.data(), stream.size())};
+        if (bytesWritten < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            // E.g., the script exited without reading all of it
+            std::cerr << "Error writing to CGI " << fileFd << ": " << strerror(errno) << '\n';
+            _filesToRemove.insert(fileFd);
+            return;
+        }
+        stream.consume(static_cast<std::size_t>(bytesWritten));
+        file.lastReadWriteTime = std::chrono::steady_clock::now();
+    }
+    if (stream.isDrained())
+    {
+        // Closing the pipe is the end of the script's input
+        file.finished = true;
+        _filesToRemove.insert(fileFd);
+        return;
+    }
+    if (stream.size() == 0)
+        _pollManager.removeEvents(fileFd, POLLOUT); // Until more of the body arrives (see consumeBody())
+    if (!stream.isFull())
+        _pollManager.updateEvents(clientFd, POLLIN);
+}
+
 void Server::writeToFile(int fileFd, ClientData &client_data)
 {
     std::string pendingWrite = client_data.openFiles[fileFd].content;
@@ -364,6 +1032,17 @@ void Server::writeToFile(int fileFd, ClientData &client_data)
 
 void Server::checkTimeoutConnectionsAndFiles()
 {
+    // Requests waiting for I/O check their own deadlines (CGI and upstream timeouts) once per tick
+    const auto now{std::chrono::steady_clock::now()};
+    if (now - _lastTick >= std::chrono::milliseconds(POLL_TICK))
+    {
+        _lastTick = now;
+        for (const auto &[clientFd, client_data] : _clientData)
+        {
+            if (client_data.state == ClientData::PROCESSING)
+                _clientsToWake.insert(clientFd);
+        }
+    }
     for (const auto &[clientFd, client_data] : _clientData)
     {
         auto elapsedSinceInteraction{std::chrono::steady_clock::now() - client_data.lastInteractionTime};
@@ -375,6 +1054,12 @@ void Server::checkTimeoutConnectionsAndFiles()
         }
         for (const auto &[fileFd, open_file] : client_data.openFiles)
         {
+            // A paused CGI pipe waits for the client, whose own timeout applies
+            if (open_file.cgiRelay != nullptr && open_file.cgiRelay->isPaused())
+                continue;
+            // Same for a CGI stdin waiting for more of the body
+            if (open_file.bodyStream != nullptr && open_file.bodyStream->size() == 0)
+                continue;
             auto elapsedSinceReadWrite{std::chrono::steady_clock::now() - open_file.lastReadWriteTime};
             if (elapsedSinceReadWrite >= std::chrono::seconds(FILE_TIMEOUT))
             {
@@ -392,8 +1077,12 @@ void Server::closeConnections()
     {
         _pollManager.removeSocket(fd);
         closeClientFiles(fd);
+        // Whether or not it stored a new entry, the next stale hit may start another refresh
+        if (!_clientData[fd].cgiCacheRefresh.empty())
+            _cgiCache.endRefresh(_clientData[fd].cgiCacheRefresh);
         _clientData.erase(fd);
-        close(fd);
+        if (fd >= 0)
+            close(fd);
     }
     _clientsToRemove.clear();
 }
@@ -403,6 +1092,7 @@ void Server::closeClientFiles(int client_fd)
     for (auto &[file_fd, file_data] : _clientData[client_fd].openFiles)
     {
         _pollManager.removeSocket(file_fd);
+        _openFilesToClientMap.erase(file_fd);
         close(file_fd);
     }
 }
@@ -411,19 +1101,30 @@ void Server::closeDoneFiles()
 {
     for (int fd : _filesToRemove)
     {
+        // Not registered anymore: it was closed along with its client
+        auto owner{_openFilesToClientMap.find(fd)};
+        if (owner == _openFilesToClientMap.end())
+            continue;
+        const int   clientFd{owner->second};
+        ClientData &client_data{_clientData[clientFd]};
         _pollManager.removeSocket(fd);
-        getClientOfFile(fd).openFiles.erase(fd);
-        _openFilesToClientMap.erase(fd);
+        // Whatever the reason the pipe is closed, the script's output ends here
+        std::shared_ptr<CGIResponseRelay> &relay{client_data.openFiles[fd].cgiRelay};
+        if (relay != nullptr)
+            relay->endOfOutput();
+        // And whatever more of the body arrives for it is dropped
+        std::shared_ptr<CGIBodyStream> &bodyStream{client_data.openFiles[fd].bodyStream};
+        if (bodyStream != nullptr)
+            bodyStream->detach();
+        client_data.openFiles.erase(fd);
+        // The request may have been waiting for this file
+        wakeClient(clientFd);
+        _openFilesToClientMap.erase(owner);
         close(fd);
     }
     _filesToRemove.clear();
 }
 
-ClientData &Server::getClientOfFile(int fileFd)
-{
-    return _clientData[_openFilesToClientMap[fileFd]];
-}
-
 const LocationConfig *Server::findLocationConfig(const std::string &uri, const ServerConfig *server_config) const
 {
     if (!server_config)
@@ -446,6 +1147,16 @@ const LocationConfig *Server::findLocationConfig(const std::string &uri, const S
     return best_match;
 }
 
+ResolutionCache::EntryPtr Server::resolveRequestPath(const std::string &path, const ServerConfig *server_config)
+{
+    ResolutionCache::EntryPtr resolution{_resolutionCache.lookup(server_config, path)};
+    if (resolution != nullptr)
+        return resolution;
+    resolution = ResolutionCache::resolve(findLocationConfig(path, server_config), path);
+    _resolutionCache.store(server_config, path, resolution);
+    return resolution;
+}
+
 std::unordered_map<int, ClientData> &Server::getClientDataMap()
 {
     return _clientData;
@@ -456,6 +1167,140 @@ PollManager &Server::getPollManager()
     return _pollManager;
 }
 
+OpenFileCache &Server::getOpenFileCache()
+{
+    return _openFileCache;
+}
+
+ContentCache &Server::getContentCache()
+{
+    return _contentCache;
+}
+
+CGICache &Server::getCGICache()
+{
+    return _cgiCache;
+}
+
+FileMappingCache &Server::getFileMappingCache()
+{
+    return _fileMappingCache;
+}
+
+GzipCache &Server::getGzipCache()
+{
+    return _gzipCache;
+}
+
+DirectoryListingCache &Server::getDirectoryListingCache()
+{
+    return _directoryListingCache;
+}
+
+RootIndex &Server::getRootIndex()
+{
+    return _rootIndex;
+}
+
+ResolutionCache &Server::getResolutionCache()
+{
+    return _resolutionCache;
+}
+
+FastCGIPool &Server::getFastCGIPool()
+{
+    return _fastcgiPool;
+}
+
+CGIWorkerPool &Server::getCGIWorkerPool()
+{
+    return _cgiWorkerPool;
+}
+
+CGIConcurrencyLimiter &Server::getCGILimiter()
+{
+    return _cgiLimiter;
+}
+
+void Server::forgetFile(const std::filesystem::path &path)
+{
+    _openFileCache.invalidate(path);
+    _contentCache.clear();
+    _resolutionCache.forgetIndexFiles();
+}
+
+std::string Server::renderMetrics() const
+{
+    std::size_t connections{0};
+    for (const auto &[clientFd, client_data] : _clientData)
+    {
+        if (clientFd >= 0)
+            ++connections;
+    }
+    const CGIConcurrencyLimiter::Stats &cgi{_cgiLimiter.getStats()};
+    const CGICache::Stats              &cgiCache{_cgiCache.getStats()};
+    const ContentCache::Stats          &hotCache{_contentCache.getStats()};
+
+    std::ostringstream out;
+    out << "# TYPE webserv_connections gauge\n"
+        << "webserv_connections " << connections << '\n'
+        << "# TYPE webserv_cgi_running gauge\n"
+        << "webserv_cgi_running " << _cgiLimiter.getRunning() << '\n'
+        << "# TYPE webserv_cgi_queue_depth gauge\n"
+        << "webserv_cgi_queue_depth " << _cgiLimiter.getQueueDepth() << '\n'
+        << "# TYPE webserv_cgi_admitted_total counter\n"
+        << "webserv_cgi_admitted_total " << cgi.admitted << '\n'
+        << "# TYPE webserv_cgi_queued_total counter\n"
+        << "webserv_cgi_queued_total " << cgi.queued << '\n'
+        << "# TYPE webserv_cgi_rejected_total counter\n"
+        << "webserv_cgi_rejected_total " << cgi.rejected << '\n'
+        << "# TYPE webserv_cgi_queue_timeouts_total counter\n"
+        << "webserv_cgi_queue_timeouts_total " << cgi.timedOut << '\n'
+        << "# TYPE webserv_cgi_queue_wait_seconds summary\n"
+        << "webserv_cgi_queue_wait_seconds_sum " << cgi.waitSeconds << '\n'
+        << "webserv_cgi_queue_wait_seconds_count " << cgi.waitCount << '\n'
+        << "# TYPE webserv_cgi_queue_wait_seconds_max gauge\n"
+        << "webserv_cgi_queue_wait_seconds_max " << cgi.maxWaitSeconds << '\n'
+        << "# TYPE webserv_cgi_cache_requests_total counter\n"
+        << "webserv_cgi_cache_requests_total{result=\"hit\"} " << cgiCache.hits << '\n'
+        << "webserv_cgi_cache_requests_total{result=\"stale\"} " << cgiCache.staleHits << '\n'
+        << "webserv_cgi_cache_requests_total{result=\"miss\"} " << cgiCache.misses << '\n'
+        << "# TYPE webserv_cgi_cache_refreshes_total counter\n"
+        << "webserv_cgi_cache_refreshes_total " << cgiCache.refreshes << '\n'
+        << "# TYPE webserv_cgi_cache_bytes gauge\n"
+        << "webserv_cgi_cache_bytes " << _cgiCache.getSize() << '\n'
+        << "# TYPE webserv_hot_cache_requests_total counter\n"
+        << "webserv_hot_cache_requests_total{result=\"hit\"} " << hotCache.hits << '\n'
+        << "webserv_hot_cache_requests_total{result=\"miss\"} " << hotCache.misses << '\n'
+        << "# TYPE webserv_hot_cache_bytes gauge\n"
+        << "webserv_hot_cache_bytes " << _contentCache.getSize() << '\n';
+    return out.str();
+}
+
+void Server::registerUpstream(int fd, int clientFd, short events)
+{
+    _pollManager.addUpstreamFd(fd, events);
+    _upstreamToClientMap[fd] = clientFd;
+}
+
+void Server::unregisterUpstream(int fd)
+{
+    if (_upstreamToClientMap.erase(fd) != 0)
+        _pollManager.removeSocket(fd);
+}
+
+void Server::registerProcess(int fd, int clientFd)
+{
+    _pollManager.addProcessFd(fd);
+    _processToClientMap[fd] = clientFd;
+}
+
+void Server::unregisterProcess(int fd)
+{
+    if (_processToClientMap.erase(fd) != 0)
+        _pollManager.removeSocket(fd);
+}
+
 std::unordered_map<int, int> &Server::getOpenFilesToClientMap()
 {
     return _openFilesToClientMap;
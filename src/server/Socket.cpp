@@ -70,7 +70,7 @@ int Socket::get_fd() const
 
 void Socket::createSocket()
 {
-    _fd = socket(_addr_info_struct.ai_family, _addr_info_struct.ai_socktype, _addr_info_struct.ai_protocol);
+    _fd = socket(_addr_info_struct.ai_family, _addr_info_struct.ai_socktype | SOCK_CLOEXEC, _addr_info_struct.ai_protocol);
     if (_fd < 0)
     {
         throw std::runtime_error("Failed to create socket: " + std::string{strerror(errno)});
@@ -189,18 +189,89 @@ bool strEndsWith(const std::string& str, const std::string& suffix)
     return str.substr(str.length() - suffix.length()) == suffix;
 }
 
-std::pair<std::string, std::string> splitUriIntoPathAndQuery(const std::string& uri)
+namespace
 {
-    std::string path{uri};
-    std::string queryStr{""};
-    std::size_t queryBegin{path.find_last_of('?')}; // technically this is 1 before query begin
-    if (queryBegin != std::string::npos)
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/* Close the segment that was written to `path[segmentStart, end)`: a `.` segment is dropped, a `..` segment is dropped
+along with the one before it. Returns false if `..` would leave the root */
+bool closePathSegment(std::string &path, std::size_t segmentStart, std::size_t &end)
+{
+    const std::size_t length{end - segmentStart};
+    if (length == 1 && path[segmentStart] == '.')
+        end = segmentStart;
+    else if (length == 2 && path[segmentStart] == '.' && path[segmentStart + 1] == '.')
     {
-        if (queryBegin + 1 < path.length())
-            queryStr = path.substr(queryBegin + 1); // get part after '?'
-        path.erase(queryBegin);                     // erase from '?' to end of string
+        if (segmentStart == 1)
+            return false;
+        // Back to just after the slash that starts the previous segment
+        end = path.rfind('/', segmentStart - 2) + 1;
     }
-    return {path, queryStr};
+    return true;
+}
+} // namespace
+
+bool normalizeRequestTarget(const std::string &target, std::string &path, std::string &query)
+{
+    std::size_t pathStart{0};
+    // Absolute form (`http://host/path`): only the path is looked at
+    const bool  absoluteForm{strncasecmp(target.c_str(), "http://", 7) == 0 || strncasecmp(target.c_str(), "https://", 8) == 0};
+    if (absoluteForm)
+        pathStart = std::min(target.find_first_of("/?#", target.find("//") + 2), target.size());
+    const std::size_t pathEnd{std::min(target.find_first_of("?#", pathStart), target.size())};
+    if (pathEnd < target.size() && target[pathEnd] == '?')
+        query.assign(target, pathEnd + 1, std::min(target.find('#', pathEnd), target.size()) - pathEnd - 1);
+    else
+        query.clear();
+
+    path.assign(target, pathStart, pathEnd - pathStart);
+    if (path.empty() && absoluteForm)
+        path = "/";
+    if (path.empty() || path[0] != '/')
+        return false;
+
+    // Decoding and dropping segments only ever shrink the path, so it is rewritten in place: `end` never passes `pos`
+    std::size_t end{1};
+    std::size_t segmentStart{1};
+    for (std::size_t pos{1}; pos < path.size();)
+    {
+        char c{path[pos]};
+        if (c == '%')
+        {
+            int high{pos + 2 < path.size() ? hexValue(path[pos + 1]) : -1};
+            int low{high == -1 ? -1 : hexValue(path[pos + 2])};
+            if (low == -1 || (high == 0 && low == 0))
+                return false; // Invalid escape or NUL
+            c = static_cast<char>(high << 4 | low);
+            pos += 3;
+        }
+        else
+            ++pos;
+
+        if (c != '/')
+        {
+            path[end++] = c;
+            continue;
+        }
+        if (!closePathSegment(path, segmentStart, end))
+            return false;
+        if (path[end - 1] != '/') // Duplicate slashes collapse into one
+            path[end++] = '/';
+        segmentStart = end;
+    }
+    if (!closePathSegment(path, segmentStart, end))
+        return false;
+    path.resize(end);
+    return true;
 }
 
 bool isHttpMethod(const std::string &str)
@@ -239,6 +310,149 @@ std::string getCurrentGMTString()
     return oss.str();
 }
 
+std::string_view getCachedGMTString()
+{
+    static char        buffer[32];
+    static std::size_t length{0};
+    static std::time_t cachedSecond{-1};
+
+    std::time_t now{std::time(nullptr)};
+    if (now != cachedSecond)
+    {
+        std::tm gmt_tm;
+        gmtime_r(&now, &gmt_tm);
+        length = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &gmt_tm);
+        cachedSecond = now;
+    }
+    return {buffer, length};
+}
+
+std::string formatHTTPDate(std::time_t time)
+{
+    char    buffer[32];
+    std::tm gmt_tm;
+    gmtime_r(&time, &gmt_tm);
+    return {buffer, std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &gmt_tm)};
+}
+
+bool parseHTTPDate(const std::string &str, std::time_t &out)
+{
+    std::tm     tm{};
+    const char *end{strptime(str.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm)};
+    if (end == nullptr || *end != '\0')
+        return false;
+    out = timegm(&tm);
+    return out != -1;
+}
+
+std::string makeETag(const struct stat &fileStat)
+{
+    std::ostringstream oss;
+    oss << std::hex << '"' << fileStat.st_ino << '-' << fileStat.st_size << '-' << fileStat.st_mtim.tv_sec
+        << std::setw(8) << std::setfill('0') << fileStat.st_mtim.tv_nsec << '"';
+    return oss.str();
+}
+
+bool etagListMatches(const std::string &list, const std::string &etag, bool weak)
+{
+    std::string trimmedList{list};
+    trim(trimmedList);
+    if (trimmedList == "*")
+        return true;
+
+    for (auto &tag : splitStr(trimmedList, ","))
+    {
+        trim(tag, " \t,");
+        if (tag.compare(0, 2, "W/") == 0)
+        {
+            if (!weak)
+                continue;
+            tag.erase(0, 2);
+        }
+        if (tag == etag)
+            return true;
+    }
+    return false;
+}
+
+// Parse a qvalue ("0", "0.5", "1.000", ...) into thousandths
+static bool parseQValue(std::string_view str, int &out)
+{
+    if (str.empty() || (str[0] != '0' && str[0] != '1'))
+        return false;
+    int value{(str[0] - '0') * 1000};
+    if (str.size() > 1)
+    {
+        if (str[1] != '.' || str.size() > 5)
+            return false;
+        int scale{100};
+        for (std::size_t i{2}; i < str.size(); ++i, scale /= 10)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(str[i])))
+                return false;
+            value += (str[i] - '0') * scale;
+        }
+    }
+    if (value > 1000)
+        return false;
+    out = value;
+    return true;
+}
+
+int acceptEncodingQuality(std::string_view acceptEncoding, std::string_view coding)
+{
+    int wildcardQuality{0};
+    while (!acceptEncoding.empty())
+    {
+        std::size_t      comma{acceptEncoding.find(',')};
+        std::string_view element{acceptEncoding.substr(0, comma)};
+        acceptEncoding.remove_prefix(comma == std::string_view::npos ? acceptEncoding.size() : comma + 1);
+
+        // element = coding *( OWS ";" OWS "q=" qvalue )
+        std::size_t      semicolon{element.find(';')};
+        std::string_view name{element.substr(0, semicolon)};
+        while (!name.empty() && (name.front() == ' ' || name.front() == '\t'))
+            name.remove_prefix(1);
+        while (!name.empty() && (name.back() == ' ' || name.back() == '\t'))
+            name.remove_suffix(1);
+        if (name.empty())
+            continue;
+
+        int quality{1000};
+        if (semicolon != std::string_view::npos)
+        {
+            std::string_view param{element.substr(semicolon + 1)};
+            while (!param.empty() && (param.front() == ' ' || param.front() == '\t'))
+                param.remove_prefix(1);
+            while (!param.empty() && (param.back() == ' ' || param.back() == '\t'))
+                param.remove_suffix(1);
+            if (param.size() < 2 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=' ||
+                !parseQValue(param.substr(2), quality))
+                continue; // Malformed elements are ignored
+        }
+
+        if (name.size() == coding.size() && strncasecmp(name.data(), coding.data(), name.size()) == 0)
+            return quality;
+        if (name == "*")
+            wildcardQuality = quality;
+    }
+    return wildcardQuality;
+}
+
+bool readWholeFile(int fd, std::size_t size, std::string &out)
+{
+    out.resize(size);
+    std::size_t done{0};
+    while (done < size)
+    {
+        ssize_t bytesRead{pread(fd, out.data() + done, size - done, static_cast<off_t>(done))};
+        if (bytesRead <= 0)
+            return false;
+        done += static_cast<std::size_t>(bytesRead);
+    }
+    return true;
+}
+
 std::string getLastModTimeHTTP(const std::filesystem::path &filePath)
 {
     try
@@ -301,6 +515,105 @@ void removeLeadingSlash(std::string& str)
         str.erase(str.begin());
 }
 
+bool normalizeUnderRoot(const std::filesystem::path &root, const std::filesystem::path &candidate, std::filesystem::path &out)
+{
+    std::filesystem::path normRoot = root.lexically_normal();
+    std::filesystem::path normCand = candidate.lexically_normal();
+
+    auto rootStr = normRoot.string();
+    auto candStr = normCand.string();
+
+    // Ensure trailing separator handling: either exact match, or next char is '/'
+    bool startsWith =
+        candStr.compare(0, rootStr.size(), rootStr) == 0 && (candStr.size() == rootStr.size() || candStr[rootStr.size()] == '/');
+    if (!startsWith)
+        return false;
+
+    out = normCand;
+    return true;
+}
+
+// Upper bound on the number of ranges in a single request, larger requests are served in full
+#define MAX_BYTE_RANGES 16
+
+// Parses a (non-empty, all digits) decimal number. Returns false on invalid input or overflow
+static bool parseRangeNumber(const std::string &str, std::size_t &out)
+{
+    if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    try
+    {
+        out = std::stoul(str);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    return true;
+}
+
+ByteRangeStatus parseByteRanges(const std::string &header, std::size_t size, std::vector<ByteRange> &ranges)
+{
+    ranges.clear();
+
+    std::string value{header};
+    trim(value);
+    if (value.length() < 6 || strncasecmp(value.c_str(), "bytes=", 6) != 0)
+        return RANGE_IGNORED;
+
+    std::vector<std::string> specs{splitStr(value.substr(6), ",")};
+    if (specs.empty() || specs.size() > MAX_BYTE_RANGES)
+        return RANGE_IGNORED;
+
+    for (auto &spec : specs)
+    {
+        trim(spec);
+        auto dashPos{spec.find('-')};
+        if (dashPos == std::string::npos)
+            return RANGE_IGNORED;
+
+        std::string firstStr{spec.substr(0, dashPos)};
+        std::string lastStr{spec.substr(dashPos + 1)};
+        std::size_t first{};
+        std::size_t last{};
+
+        if (firstStr.empty()) // suffix range: last N bytes
+        {
+            if (!parseRangeNumber(lastStr, last))
+                return RANGE_IGNORED;
+            if (last == 0 || size == 0)
+                continue;
+            ranges.push_back({size - std::min(last, size), size - 1});
+            continue;
+        }
+        if (!parseRangeNumber(firstStr, first))
+            return RANGE_IGNORED;
+        if (lastStr.empty())
+            last = std::string::npos;
+        else if (!parseRangeNumber(lastStr, last) || last < first)
+            return RANGE_IGNORED;
+        if (first >= size)
+            continue; // this range is unsatisfiable, others might not be
+        ranges.push_back({first, std::min(last, size - 1)});
+    }
+
+    if (ranges.empty())
+        return RANGE_UNSATISFIABLE;
+
+    // Sort and merge overlapping or adjacent ranges
+    std::sort(ranges.begin(), ranges.end(), [](const ByteRange &a, const ByteRange &b) { return a.first < b.first; });
+    std::vector<ByteRange> merged{ranges.front()};
+    for (std::size_t i{1}; i < ranges.size(); ++i)
+    {
+        if (ranges[i].first <= merged.back().last + 1)
+            merged.back().last = std::max(merged.back().last, ranges[i].last);
+        else
+            merged.push_back(ranges[i]);
+    }
+    ranges = std::move(merged);
+    return RANGE_SATISFIABLE;
+}
+
 void setNonBlocking(int fd)
 {
     // int flags = fcntl(fd, F_GETFL, 0); // ? is this flag allowed
@@ -317,7 +630,7 @@ void setNonBlocking(int fd)
     }
 }
 
-std::string reasonPhraseFromStatusCode(int code)
+std::string_view reasonPhraseFromStatusCode(int code)
 {
     switch (code)
     {
@@ -456,6 +769,116 @@ std::string reasonPhraseFromStatusCode(int code)
         return "Network Authentication Required";
 
     default:
-        return std::string();
+        return std::string_view();
     }
 }
+
+// Seconds in a given time unit (nginx notation), 0 for an unknown unit
+static long secondsPerUnit(char unit)
+{
+    switch (unit)
+    {
+    case 's':
+        return 1;
+    case 'm':
+        return 60;
+    case 'h':
+        return 60 * 60;
+    case 'd':
+        return 24 * 60 * 60;
+    case 'w':
+        return 7 * 24 * 60 * 60;
+    case 'M':
+        return 30 * 24 * 60 * 60;
+    case 'y':
+        return 365 * 24 * 60 * 60;
+    default:
+        return 0;
+    }
+}
+
+bool parseTimeDuration(std::string_view str, long &out)
+{
+    bool negative{!str.empty() && str.front() == '-'};
+    if (negative)
+        str.remove_prefix(1);
+    if (str.empty())
+        return false;
+
+    constexpr long max{std::numeric_limits<long>::max() / 2};
+    long           total{0};
+    while (!str.empty())
+    {
+        long        value{0};
+        std::size_t digits{0};
+        while (digits < str.size() && std::isdigit(static_cast<unsigned char>(str[digits])))
+        {
+            value = value * 10 + (str[digits] - '0');
+            if (value > max)
+                return false;
+            ++digits;
+        }
+        if (digits == 0)
+            return false;
+        str.remove_prefix(digits);
+
+        long multiplier{1};
+        if (!str.empty())
+        {
+            multiplier = secondsPerUnit(str.front());
+            if (multiplier == 0)
+                return false;
+            str.remove_prefix(1);
+        }
+        else if (total != 0) // A unit is only optional for a plain number
+            return false;
+        if (value > (max - total) / multiplier)
+            return false;
+        total += value * multiplier;
+    }
+    out = negative ? -total : total;
+    return true;
+}
+
+bool parseByteSize(std::string_view str, std::size_t &out)
+{
+    std::size_t multiplier{1};
+    if (!str.empty())
+    {
+        switch (str.back())
+        {
+        case 'k':
+        case 'K':
+            multiplier = 1000;
+            break;
+        case 'm':
+        case 'M':
+            multiplier = 1000000;
+            break;
+        case 'g':
+        case 'G':
+            multiplier = 1000000000;
+            break;
+        default:
+            break;
+        }
+        if (multiplier != 1)
+            str.remove_suffix(1);
+    }
+    if (str.empty())
+        return false;
+
+    std::size_t value{0};
+    for (char c : str)
+    {
+        if (!std::isdigit(static_cast<unsigned char>(c)))
+            return false;
+        if (value > (std::numeric_limits<std::size_t>::max() - (c - '0')) / 10)
+            return false;
+        value = value * 10 + (c - '0');
+    }
+    if (value > std::numeric_limits<std::size_t>::max() / multiplier)
+        return false;
+    out = value * multiplier;
+    return true;
+}
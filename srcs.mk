@@ -1,10 +1,12 @@
-VPATH		=	$(SRC_DIR):$(SRC_DIR)/server:$(SRC_DIR)/config:$(SRC_DIR)/utils:$(SRC_DIR)/request:$(SRC_DIR)/request/types:$(SRC_DIR)/request/response:$(SRC_DIR)/request/cgi
+VPATH		=	$(SRC_DIR):$(SRC_DIR)/server:$(SRC_DIR)/config:$(SRC_DIR)/utils:$(SRC_DIR)/request:$(SRC_DIR)/request/types:$(SRC_DIR)/request/response:$(SRC_DIR)/request/cgi:$(SRC_DIR)/cache
 
 SRCS		=	main.cpp \
 				Server.cpp \
 				GlobalConfig.cpp \
 				ServerConfig.cpp \
 				LocationConfig.cpp \
+				HeaderDirectives.cpp \
+				GzipDirectives.cpp \
 				Socket.cpp \
 				PollManager.cpp \
 				utils.cpp \
@@ -18,7 +20,24 @@ SRCS		=	main.cpp \
                 POSTRequest.cpp \
                 ErrorRequest.cpp \
                 ResponseWriter.cpp \
-                CGISubprocess.cpp
+                GzipEncoder.cpp \
+                CGISubprocess.cpp \
+                CGIResponseRelay.cpp \
+                CGIBodyStream.cpp \
+                FastCGICodec.cpp \
+                FastCGIPool.cpp \
+                FastCGIExchange.cpp \
+                CGIWorkerPool.cpp \
+                CGIWorkerExchange.cpp \
+                CGIConcurrencyLimiter.cpp \
+                OpenFileCache.cpp \
+                ContentCache.cpp \
+                CGICache.cpp \
+                FileMappingCache.cpp \
+                GzipCache.cpp \
+                DirectoryListingCache.cpp \
+                RootIndex.cpp \
+                ResolutionCache.cpp
 
 
 INCLUDES	=	-Iincludes \
@@ -28,4 +47,5 @@ INCLUDES	=	-Iincludes \
 				-Iincludes/request \
 				-Iincludes/request/types \
 				-Iincludes/request/response \
-				-Iincludes/request/cgi
+				-Iincludes/request/cgi \
+				-Iincludes/cache